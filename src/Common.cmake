@@ -20,3 +20,11 @@ if("${LEARNING}" MATCHES "(1|ON)")
 elseif("${LEARNING}" MATCHES "(0|OFF)")
     set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DLEARNING=0")
 endif()
+
+if("${INSTRUMENT}" MATCHES "(1|ON)")
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DSUNFISH_INSTRUMENT=1")
+endif()
+
+if("${TABLE_STATS}" MATCHES "(1|ON)")
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DSUNFISH_TABLE_STATS=1")
+endif()
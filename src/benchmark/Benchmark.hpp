@@ -48,7 +48,7 @@ using BMCounterType = uint64_t;
 class BenchmarkController {
 public:
 
-  BenchmarkController(BMTimeType usec) : usec_(usec) {
+  BenchmarkController(BMTimeType usec) : usec_(usec), itemsPerIteration_(1) {
   }
 
   void start() {
@@ -85,6 +85,18 @@ public:
     return elapsed_;
   }
 
+  /**
+   * Set the number of items processed in an iteration.
+   * The throughput is reported as items per second.
+   */
+  void setItemsPerIteration(BMCounterType itemsPerIteration) {
+    itemsPerIteration_ = itemsPerIteration;
+  }
+
+  BMCounterType getItemsPerIteration() const {
+    return itemsPerIteration_;
+  }
+
 private:
 
   static BenchmarkController* swap(BenchmarkController* newIns) {
@@ -111,6 +123,7 @@ private:
   BMCounterType count_;
   Timer timer_;
   BMTimeType elapsed_;
+  BMCounterType itemsPerIteration_;
 
 };
 
@@ -178,7 +191,7 @@ private:
         longName << '/' << entry.params;
       }
 
-      float ips = (float)bc.getCount() / bc.getElapsed() * 1e+6;
+      float ips = (float)bc.getCount() * bc.getItemsPerIteration() / bc.getElapsed() * 1e+6;
 
       MSG(info)
         << std::setw(41) << std::left  << longName.str() << ' '
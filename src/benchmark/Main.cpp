@@ -5,7 +5,9 @@
 
 #include "common/console/Console.hpp"
 #include "common/program_options/ProgramOptions.hpp"
+#include "common/time/Instrument.hpp"
 #include "core/util/CoreUtil.hpp"
+#include "search/util/SearchUtil.hpp"
 #include "benchmark/Benchmark.hpp"
 #include "logger/Logger.hpp"
 #include <fstream>
@@ -15,6 +17,7 @@ using namespace sunfish;
 int main(int argc, char** argv, char**) {
   // initialize static objects
   CoreUtil::initialize();
+  SearchUtil::initialize();
 
   // program options
   ProgramOptions po;
@@ -66,5 +69,7 @@ int main(int argc, char** argv, char**) {
   // execute
   BenchmarkSuite::run();
 
+  Instrument::print();
+
   return 0;
 }
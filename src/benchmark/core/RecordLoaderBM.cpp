@@ -0,0 +1,61 @@
+/* RecordLoaderBM.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "benchmark/Benchmark.hpp"
+#include "core/record/CsaReader.hpp"
+#include "core/record/RecordLoader.hpp"
+#include "common/file_system/Directory.hpp"
+#include <fstream>
+
+using namespace sunfish;
+
+namespace {
+
+auto KIFU_DIR = "kifu/learn/pro10";
+
+CONSTEXPR_CONST BMTimeType LoadTime = 1000 * 1000;
+
+}
+
+BENCHMARK(LoadRecordsSerial, [](BenchmarkController& bc, bmstr_t path) {
+  Directory directory(path);
+  auto files = directory.files("*.csa");
+
+  bc.setItemsPerIteration(files.size());
+  bc.start();
+  while(bc.cont()) {
+    for (const auto& file : files) {
+      std::ifstream is(file);
+      Record record;
+      CsaReader::read(is, record);
+    }
+  }
+})->args(BMSTR(KIFU_DIR))
+  ->time(LoadTime);
+
+BENCHMARK(LoadRecordsParallel, [](BenchmarkController& bc, bmstr_t path, int numberOfThreads) {
+  BMCounterType records = 0;
+  {
+    RecordLoader loader;
+    loader.start(path);
+    Record record;
+    while (loader.next(record)) {
+      records++;
+    }
+  }
+
+  bc.setItemsPerIteration(records);
+  bc.start();
+  while(bc.cont()) {
+    RecordLoader loader;
+    loader.setNumberOfThreads(numberOfThreads);
+    loader.start(path);
+    Record record;
+    while (loader.next(record)) {
+    }
+  }
+})->args(BMSTR(KIFU_DIR), 1)
+  ->args(BMSTR(KIFU_DIR), 4)
+  ->time(LoadTime);
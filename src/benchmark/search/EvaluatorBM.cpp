@@ -7,7 +7,9 @@
 #include "core/record/CsaReader.hpp"
 #include "core/util/PositionUtil.hpp"
 #include "search/eval/Evaluator.hpp"
+#include "search/RandomSearcher.hpp"
 #include "logger/Logger.hpp"
+#include <vector>
 #include <memory>
 
 using namespace sunfish;
@@ -64,6 +66,30 @@ auto DATA_C =
 auto DATA_C_M1 = "-0051FU";
 auto DATA_C_M2 = "-4152OU";
 
+CONSTEXPR_CONST size_t BatchSize = 4096;
+CONSTEXPR_CONST int MaxRandomPly = 128;
+
+std::vector<Position> generateRandomPositions(size_t size) {
+  RandomSearcher searcher;
+  std::vector<Position> positions;
+  positions.reserve(size);
+
+  while (positions.size() < size) {
+    Position pos = PositionUtil::createPositionFromCsaString(DATA_A);
+    for (int ply = 0; ply < MaxRandomPly && positions.size() < size; ply++) {
+      Move move;
+      if (!searcher.search(pos, move)) {
+        break;
+      }
+      Piece captured;
+      pos.doMove(move, captured);
+      positions.push_back(pos);
+    }
+  }
+
+  return positions;
+}
+
 } // namespace
 
 BENCHMARK(CalculateMaterialScore, [](BenchmarkController& bc, bmstr_t data) {
@@ -113,3 +139,17 @@ BENCHMARK(CalculateTotalScore, [](BenchmarkController& bc, bmstr_t data) {
 })->args(BMSTR(DATA_A))
   ->args(BMSTR(DATA_B))
   ->args(BMSTR(DATA_C));
+
+BENCHMARK(EvaluateBatch, [](BenchmarkController& bc, int numberOfThreads) {
+  auto positions = generateRandomPositions(BatchSize);
+  std::vector<Score> scores;
+  std::unique_ptr<Evaluator> eval(new Evaluator(Evaluator::InitType::Zero));
+
+  bc.setItemsPerIteration(positions.size());
+  bc.start();
+  while(bc.cont()) {
+    eval->evaluateBatch(positions, scores, numberOfThreads);
+  }
+})->args(1)
+  ->args(2)
+  ->args(4);
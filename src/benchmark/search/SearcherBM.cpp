@@ -0,0 +1,90 @@
+/* SearcherBM.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "benchmark/Benchmark.hpp"
+#include "core/util/PositionUtil.hpp"
+#include "search/Searcher.hpp"
+#include "search/eval/Evaluator.hpp"
+#include "logger/Logger.hpp"
+#include <memory>
+
+using namespace sunfish;
+
+namespace {
+
+auto DATA_A =
+  "P1-KY-KE-GI-KI-OU-KI-GI-KE-KY\n"
+  "P2 * -HI *  *  *  *  * -KA * \n"
+  "P3-FU-FU-FU-FU-FU-FU-FU-FU-FU\n"
+  "P4 *  *  *  *  *  *  *  *  * \n"
+  "P5 *  *  *  *  *  *  *  *  * \n"
+  "P6 *  *  *  *  *  *  *  *  * \n"
+  "P7+FU+FU+FU+FU+FU+FU+FU+FU+FU\n"
+  "P8 * +KA *  *  *  *  * +HI * \n"
+  "P9+KY+KE+GI+KI+OU+KI+GI+KE+KY\n"
+  "P+\n"
+  "P-\n"
+  "+\n";
+
+CONSTEXPR_CONST int SearchDepth = 9;
+CONSTEXPR_CONST unsigned HashMem = 256;
+CONSTEXPR_CONST BMTimeType SearchTime = 5 * 1000 * 1000;
+
+class NullSearchHandler : public SearchHandler {
+public:
+  void onStart(const Searcher&) override {}
+  void onUpdatePV(const Searcher&, const PV&, float, int, Score) override {}
+  void onFailLow(const Searcher&, const PV&, float, int, Score) override {}
+  void onFailHigh(const Searcher&, const PV&, float, int, Score) override {}
+  void onIterateEnd(const Searcher&, float, int) override {}
+};
+
+} // namespace
+
+/**
+ * The nodes per second of the iterative deepening search.
+ * The threads are packed into the NUMA nodes if numa is 1,
+ * so that the scaling across the sockets is shown
+ * by the larger number of the threads than the CPUs of a node.
+ */
+BENCHMARK(SearchScaling, [](BenchmarkController& bc, int numberOfThreads, int numa) {
+  Position pos = PositionUtil::createPositionFromCsaString(DATA_A);
+  NullSearchHandler handler;
+  Searcher searcher(Evaluator::sharedEvaluator());
+  searcher.setHandler(&handler);
+  searcher.ttResizeMB(HashMem);
+
+  auto config = searcher.getConfig();
+  config.maximumTimeMs = SearchConfig::InfinityTime;
+  config.optimumTimeMs = SearchConfig::InfinityTime;
+  config.numberOfThreads = numberOfThreads;
+  config.numa = numa != 0;
+  config.replicateEval = numa != 0;
+  searcher.setConfig(config);
+
+  uint64_t nodes = 0;
+
+  bc.start();
+  while(bc.cont()) {
+    // the evaluator replicas are kept by clean().
+    searcher.clean();
+    searcher.idsearch(pos, SearchDepth * Searcher::Depth1Ply);
+    nodes += searcher.getInfo().nodes + searcher.getInfo().quiesNodes;
+  }
+
+  bc.setItemsPerIteration(nodes / bc.getCount());
+})->time(SearchTime)
+  ->args(1, 0)
+  ->args(1, 1)
+  ->args(2, 0)
+  ->args(2, 1)
+  ->args(4, 0)
+  ->args(4, 1)
+  ->args(8, 0)
+  ->args(8, 1)
+  ->args(16, 0)
+  ->args(16, 1)
+  ->args(32, 0)
+  ->args(32, 1);
@@ -0,0 +1,207 @@
+/* BinaryBook.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "book/BinaryBook.hpp"
+#include "book/Book.hpp"
+#include "core/position/Position.hpp"
+#include "core/record/SfenParser.hpp"
+#include "common/file_system/FileUtil.hpp"
+#include "logger/Logger.hpp"
+#include <fstream>
+#include <algorithm>
+#include <vector>
+#include <limits>
+#include <cstring>
+
+namespace {
+
+using namespace sunfish;
+
+const char* const BinaryBookBin = "book.sfbk";
+const char Magic[4] = { 'S', 'F', 'B', 'K' };
+
+struct HashedMoves {
+  uint64_t hash;
+  const BookMoves* moves;
+};
+
+} // namespace
+
+namespace sunfish {
+
+void BinaryBook::initializeHeader(Header& header,
+                                  uint32_t numberOfEntries,
+                                  uint32_t numberOfMoves) {
+  memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.numberOfEntries = numberOfEntries;
+  header.numberOfMoves = numberOfMoves;
+}
+
+const char* BinaryBook::defaultPath() {
+  return BinaryBookBin;
+}
+
+bool BinaryBook::exists() {
+  return FileUtil::isFile(BinaryBookBin);
+}
+
+bool BinaryBook::open() {
+  return open(BinaryBookBin);
+}
+
+bool BinaryBook::open(const char* path) {
+  close();
+
+  if (!file_.open(path)) {
+    return false;
+  }
+
+  auto data = static_cast<const uint8_t*>(file_.data());
+  auto size = file_.size();
+  const Header* header = reinterpret_cast<const Header*>(data);
+
+  if (size < sizeof(Header) ||
+      memcmp(header->magic, Magic, sizeof(Magic)) != 0) {
+    LOG(error) << "invalid binary book: " << path;
+    file_.close();
+    return false;
+  }
+
+  if (header->version != Version) {
+    LOG(error) << "unsupported version: " << header->version << ": " << path;
+    file_.close();
+    return false;
+  }
+
+  if (size != sizeof(Header)
+            + sizeof(Entry) * header->numberOfEntries
+            + sizeof(BinaryBookMove) * header->numberOfMoves) {
+    LOG(error) << "the binary book is broken: " << path;
+    file_.close();
+    return false;
+  }
+
+  numberOfEntries_ = header->numberOfEntries;
+  numberOfMoves_ = header->numberOfMoves;
+  entries_ = reinterpret_cast<const Entry*>(data + sizeof(Header));
+  moves_ = reinterpret_cast<const BinaryBookMove*>(entries_ + numberOfEntries_);
+
+  return true;
+}
+
+void BinaryBook::close() {
+  file_.close();
+  entries_ = nullptr;
+  moves_ = nullptr;
+  numberOfEntries_ = 0;
+  numberOfMoves_ = 0;
+}
+
+BinaryBookMoves BinaryBook::get(const Position& position) const {
+  if (!isOpen()) {
+    return BinaryBookMoves();
+  }
+
+  uint64_t hash = position.getHash();
+  auto end = entries_ + numberOfEntries_;
+  auto ite = std::lower_bound(entries_, end, hash,
+                              [](const Entry& entry, uint64_t hash) {
+    return entry.hash < hash;
+  });
+
+  if (ite == end || ite->hash != hash ||
+      static_cast<uint64_t>(ite->offset) + ite->size > numberOfMoves_) {
+    return BinaryBookMoves();
+  }
+
+  return BinaryBookMoves(moves_ + ite->offset, ite->size);
+}
+
+bool BinaryBook::write(const Book& book) {
+  return write(book, BinaryBookBin);
+}
+
+bool BinaryBook::write(const Book& book, const char* path) {
+  std::vector<HashedMoves> positions;
+  positions.reserve(book.getMap().size());
+
+  for (const auto& pair : book.getMap()) {
+    Position pos;
+    if (!SfenParser::parsePosition(pair.first, pos)) {
+      return false;
+    }
+    positions.push_back({ pos.getHash(), &pair.second });
+  }
+
+  std::sort(positions.begin(), positions.end(),
+            [](const HashedMoves& lhs, const HashedMoves& rhs) {
+    return lhs.hash < rhs.hash;
+  });
+
+  std::vector<Entry> entries;
+  std::vector<BinaryBookMove> moves;
+  entries.reserve(positions.size());
+
+  for (size_t i = 0; i < positions.size(); ) {
+    uint64_t hash = positions[i].hash;
+    uint32_t offset = static_cast<uint32_t>(moves.size());
+
+    // the SFEN strings which differ only in the move number
+    // have the same hash.
+    for (; i < positions.size() && positions[i].hash == hash; i++) {
+      for (const auto& bookMove : *positions[i].moves) {
+        auto move16 = bookMove.move.serialize16();
+        auto ite = std::find_if(moves.begin() + offset, moves.end(),
+                                [move16](const BinaryBookMove& m) {
+          return m.move == move16;
+        });
+        if (ite == moves.end()) {
+          moves.push_back({ move16, bookMove.count });
+        } else {
+          ite->count = static_cast<uint16_t>(std::min<int>(
+              ite->count + bookMove.count,
+              std::numeric_limits<uint16_t>::max()));
+        }
+      }
+    }
+
+    size_t size = moves.size() - offset;
+    if (size > std::numeric_limits<uint16_t>::max()) {
+      LOG(error) << "too many moves in a position: " << size;
+      return false;
+    }
+
+    entries.push_back({ hash, offset, static_cast<uint16_t>(size), 0 });
+  }
+
+  Header header;
+  initializeHeader(header,
+                   static_cast<uint32_t>(entries.size()),
+                   static_cast<uint32_t>(moves.size()));
+
+  std::ofstream file(path, std::ios::binary | std::ios::out);
+  if (!file) {
+    LOG(error) << "could not open a file: " << path;
+    return false;
+  }
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(entries.data()),
+             sizeof(Entry) * entries.size());
+  file.write(reinterpret_cast<const char*>(moves.data()),
+             sizeof(BinaryBookMove) * moves.size());
+
+  file.close();
+
+  if (file.fail()) {
+    LOG(error) << "file I/O error: " << path;
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace sunfish
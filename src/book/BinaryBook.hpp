@@ -0,0 +1,164 @@
+/* BinaryBook.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_BOOK_BINARYBOOK_HPP__
+#define SUNFISH_BOOK_BINARYBOOK_HPP__
+
+#include "common/Def.hpp"
+#include "common/file_system/MappedFile.hpp"
+#include "core/move/Move.hpp"
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace sunfish {
+
+class Position;
+class Book;
+
+/**
+ * A move of the binary book. (32 bits)
+ */
+struct BinaryBookMove {
+  Move::RawType16 move;
+  uint16_t count;
+};
+
+/**
+ * The moves of a position in the binary book.
+ * This refers to the mapped memory and is valid while the book is open.
+ */
+class BinaryBookMoves {
+public:
+
+  BinaryBookMoves() : moves_(nullptr), size_(0) {
+  }
+
+  BinaryBookMoves(const BinaryBookMove* moves, size_t size) :
+      moves_(moves), size_(size) {
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  Move move(size_t index) const {
+    return Move::deserialize(moves_[index].move);
+  }
+
+  uint16_t count(size_t index) const {
+    return moves_[index].count;
+  }
+
+private:
+
+  const BinaryBookMove* moves_;
+  size_t size_;
+
+};
+
+/**
+ * The read-only opening book mapped into the memory.
+ *
+ *   header  : magic, version, the number of entries and moves
+ *   entries : the Zobrist hashes of the positions in ascending order,
+ *             each of which has the offset and the number of its moves
+ *   moves   : BinaryBookMove
+ *
+ * The positions are looked up by a binary search over the entries.
+ */
+class BinaryBook {
+public:
+
+  static CONSTEXPR_CONST uint32_t Version = 1;
+
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t numberOfEntries;
+    uint32_t numberOfMoves;
+  };
+
+  struct Entry {
+    uint64_t hash;
+    uint32_t offset;
+    uint16_t size;
+    uint16_t reserved;
+  };
+
+  BinaryBook() : entries_(nullptr), moves_(nullptr),
+                 numberOfEntries_(0), numberOfMoves_(0) {
+  }
+
+  BinaryBook(const BinaryBook&) = delete;
+  BinaryBook(BinaryBook&&) = delete;
+
+  static void initializeHeader(Header& header,
+                               uint32_t numberOfEntries,
+                               uint32_t numberOfMoves);
+
+  /**
+   * Get the default path of the binary book.
+   */
+  static const char* defaultPath();
+
+  /**
+   * Check whether the binary book exists at the default path.
+   */
+  static bool exists();
+
+  bool open();
+
+  bool open(const char* path);
+
+  bool open(const std::string& path) {
+    return open(path.c_str());
+  }
+
+  void close();
+
+  bool isOpen() const {
+    return entries_ != nullptr;
+  }
+
+  /**
+   * Get the moves of the specified position.
+   * An empty list is returned if the position is not found.
+   */
+  BinaryBookMoves get(const Position& position) const;
+
+  uint32_t getNumberOfEntries() const {
+    return numberOfEntries_;
+  }
+
+  uint32_t getNumberOfMoves() const {
+    return numberOfMoves_;
+  }
+
+  /**
+   * Write the text book in the binary format.
+   * The moves of the positions which have the same hash are merged.
+   */
+  static bool write(const Book& book);
+
+  static bool write(const Book& book, const char* path);
+
+  static bool write(const Book& book, const std::string& path) {
+    return write(book, path.c_str());
+  }
+
+private:
+
+  MappedFile file_;
+  const Entry* entries_;
+  const BinaryBookMove* moves_;
+  uint32_t numberOfEntries_;
+  uint32_t numberOfMoves_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_BOOK_BINARYBOOK_HPP__
@@ -0,0 +1,369 @@
+/* BinaryBookGenerator.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "book/BinaryBookGenerator.hpp"
+#include "book/BinaryBook.hpp"
+#include "common/thread/Parallel.hpp"
+#include "common/time/Timer.hpp"
+#include "core/util/PositionUtil.hpp"
+#include "logger/Logger.hpp"
+#include <fstream>
+#include <algorithm>
+#include <queue>
+#include <memory>
+#include <limits>
+#include <cstdio>
+
+namespace {
+
+using namespace sunfish;
+
+using RunRecord = BinaryBookGenerator::RunRecord;
+
+CONSTEXPR_CONST size_t ReaderBufferSize = 4 * 1024;
+
+inline bool lessRecord(const RunRecord& lhs, const RunRecord& rhs) {
+  return lhs.hash != rhs.hash ? lhs.hash < rhs.hash : lhs.move < rhs.move;
+}
+
+inline bool equalRecord(const RunRecord& lhs, const RunRecord& rhs) {
+  return lhs.hash == rhs.hash && lhs.move == rhs.move;
+}
+
+/**
+ * The buffered reader of a run file.
+ */
+class RunReader {
+public:
+
+  RunReader() : buffer_(ReaderBufferSize), size_(0), index_(0) {
+  }
+
+  RunReader(const RunReader&) = delete;
+  RunReader(RunReader&&) = delete;
+
+  bool open(const std::string& path) {
+    file_.open(path, std::ios::binary | std::ios::in);
+    if (!file_) {
+      LOG(error) << "could not open a file: " << path;
+      return false;
+    }
+    return true;
+  }
+
+  bool next(RunRecord& record) {
+    if (index_ == size_) {
+      file_.read(reinterpret_cast<char*>(buffer_.data()),
+                 sizeof(RunRecord) * buffer_.size());
+      size_ = static_cast<size_t>(file_.gcount()) / sizeof(RunRecord);
+      index_ = 0;
+      if (size_ == 0) {
+        return false;
+      }
+    }
+
+    record = buffer_[index_++];
+    return true;
+  }
+
+private:
+
+  std::ifstream file_;
+  std::vector<RunRecord> buffer_;
+  size_t size_;
+  size_t index_;
+
+};
+
+struct MergeItem {
+  RunRecord record;
+  size_t reader;
+};
+
+struct MergeItemGreater {
+  bool operator()(const MergeItem& lhs, const MergeItem& rhs) const {
+    return lessRecord(rhs.record, lhs.record);
+  }
+};
+
+bool appendFile(std::ofstream& os, const std::string& path) {
+  std::ifstream is(path, std::ios::binary | std::ios::in);
+  if (!is) {
+    LOG(error) << "could not open a file: " << path;
+    return false;
+  }
+
+  os << is.rdbuf();
+  return !os.fail();
+}
+
+} // namespace
+
+namespace sunfish {
+
+bool BinaryBookGenerator::generate() {
+  return generate(BinaryBook::defaultPath());
+}
+
+bool BinaryBookGenerator::generate(const std::string& outputPath) {
+  Timer timer;
+  timer.start();
+
+  outputPath_ = outputPath;
+  runFiles_.clear();
+  error_ = false;
+
+  if (!reader_.open(path_)) {
+    return false;
+  }
+
+  runParallel(numberOfThreads_, [this](int thread, int) {
+    generateOnThread(thread);
+  });
+
+  MSG(info) << "records  : " << reader_.size();
+  MSG(info) << "run files: " << runFiles_.size();
+
+  bool ok = !error_ && merge(outputPath);
+
+  removeRunFiles();
+
+  MSG(info) << "elapsed  : " << timer.elapsed();
+
+  return ok;
+}
+
+void BinaryBookGenerator::generateOnThread(int thread) {
+  std::vector<RunRecord> buffer;
+  buffer.reserve(runSize_);
+
+  Record record;
+  while (!error_ && reader_.next(record)) {
+    if (!generate(record, buffer) ||
+        (buffer.size() >= runSize_ && !spill(thread, buffer))) {
+      error_ = true;
+      return;
+    }
+  }
+
+  if (!buffer.empty() && !spill(thread, buffer)) {
+    error_ = true;
+  }
+}
+
+bool BinaryBookGenerator::generate(const Record& record,
+                                   std::vector<RunRecord>& buffer) {
+  Position position = record.initialPosition;
+
+  if (!handicap_ && !PositionUtil::isEvenInitialPosition(position)) {
+    return true;
+  }
+
+  for (unsigned i = 0; i < record.moveList.size(); i++) {
+    if (limit_ > 0 && i >= limit_) {
+      break;
+    }
+
+    Move move = record.moveList[i];
+    buffer.push_back({ position.getHash(), 1, move.serialize16(), 0 });
+
+    Piece captured;
+    if (!position.doMove(move, captured)) {
+      LOG(error) << "an illegal move is detected: " << move.toString(position) << "\n"
+                 << position.toString();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool BinaryBookGenerator::spill(int thread, std::vector<RunRecord>& buffer) {
+  std::sort(buffer.begin(), buffer.end(), lessRecord);
+
+  // combine the duplicated records
+  size_t size = 0;
+  for (size_t i = 0; i < buffer.size(); i++) {
+    if (size != 0 && equalRecord(buffer[size-1], buffer[i])) {
+      buffer[size-1].count += buffer[i].count;
+    } else {
+      buffer[size++] = buffer[i];
+    }
+  }
+
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    path = outputPath_ + ".run" + std::to_string(runFiles_.size())
+         + "_" + std::to_string(thread);
+    runFiles_.push_back(path);
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::out);
+  if (!file) {
+    LOG(error) << "could not open a file: " << path;
+    return false;
+  }
+
+  file.write(reinterpret_cast<const char*>(buffer.data()),
+             sizeof(RunRecord) * size);
+
+  file.close();
+
+  if (file.fail()) {
+    LOG(error) << "file I/O error: " << path;
+    return false;
+  }
+
+  buffer.clear();
+
+  return true;
+}
+
+bool BinaryBookGenerator::merge(const std::string& outputPath) {
+  std::vector<std::unique_ptr<RunReader>> readers(runFiles_.size());
+  std::priority_queue<MergeItem,
+                      std::vector<MergeItem>,
+                      MergeItemGreater> queue;
+
+  for (size_t i = 0; i < runFiles_.size(); i++) {
+    readers[i].reset(new RunReader());
+    if (!readers[i]->open(runFiles_[i])) {
+      return false;
+    }
+
+    RunRecord record;
+    if (readers[i]->next(record)) {
+      queue.push({ record, i });
+    }
+  }
+
+  // the entries and the moves are written to the separate files,
+  // because the number of entries is unknown until the end.
+  std::string entriesPath = outputPath + ".entries";
+  std::string movesPath = outputPath + ".moves";
+  runFiles_.push_back(entriesPath);
+  runFiles_.push_back(movesPath);
+
+  std::ofstream entriesFile(entriesPath, std::ios::binary | std::ios::out);
+  std::ofstream movesFile(movesPath, std::ios::binary | std::ios::out);
+  if (!entriesFile || !movesFile) {
+    LOG(error) << "could not open a file: " << outputPath;
+    return false;
+  }
+
+  uint32_t numberOfEntries = 0;
+  uint32_t numberOfMoves = 0;
+  std::vector<BinaryBookMove> moves;
+
+  auto flushPosition = [&](uint64_t hash) {
+    if (moves.empty()) {
+      return true;
+    }
+
+    if (moves.size() > std::numeric_limits<uint16_t>::max()) {
+      LOG(error) << "too many moves in a position: " << moves.size();
+      return false;
+    }
+
+    BinaryBook::Entry entry = { hash, numberOfMoves,
+                                static_cast<uint16_t>(moves.size()), 0 };
+    entriesFile.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    movesFile.write(reinterpret_cast<const char*>(moves.data()),
+                    sizeof(BinaryBookMove) * moves.size());
+    numberOfEntries++;
+    numberOfMoves += static_cast<uint32_t>(moves.size());
+    moves.clear();
+    return true;
+  };
+
+  bool hasCurrent = false;
+  RunRecord current;
+
+  auto flushMove = [&]() {
+    if (current.count >= threshold_) {
+      auto count = std::min<uint32_t>(current.count,
+                                      std::numeric_limits<uint16_t>::max());
+      moves.push_back({ current.move, static_cast<uint16_t>(count) });
+    }
+  };
+
+  while (!queue.empty()) {
+    MergeItem item = queue.top();
+    queue.pop();
+
+    RunRecord record;
+    if (readers[item.reader]->next(record)) {
+      queue.push({ record, item.reader });
+    }
+
+    if (hasCurrent && equalRecord(current, item.record)) {
+      current.count += item.record.count;
+      continue;
+    }
+
+    if (hasCurrent) {
+      flushMove();
+      if (current.hash != item.record.hash && !flushPosition(current.hash)) {
+        return false;
+      }
+    }
+
+    current = item.record;
+    hasCurrent = true;
+  }
+
+  if (hasCurrent) {
+    flushMove();
+    if (!flushPosition(current.hash)) {
+      return false;
+    }
+  }
+
+  entriesFile.close();
+  movesFile.close();
+  if (entriesFile.fail() || movesFile.fail()) {
+    LOG(error) << "file I/O error: " << outputPath;
+    return false;
+  }
+
+  std::ofstream file(outputPath, std::ios::binary | std::ios::out);
+  if (!file) {
+    LOG(error) << "could not open a file: " << outputPath;
+    return false;
+  }
+
+  BinaryBook::Header header;
+  BinaryBook::initializeHeader(header, numberOfEntries, numberOfMoves);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  // inserting an empty stream buffer sets the failbit.
+  if (numberOfEntries != 0) {
+    if (!appendFile(file, entriesPath) || !appendFile(file, movesPath)) {
+      LOG(error) << "file I/O error: " << outputPath;
+      return false;
+    }
+  }
+
+  file.close();
+
+  if (file.fail()) {
+    LOG(error) << "file I/O error: " << outputPath;
+    return false;
+  }
+
+  MSG(info) << "positions: " << numberOfEntries;
+  MSG(info) << "moves    : " << numberOfMoves;
+
+  return true;
+}
+
+void BinaryBookGenerator::removeRunFiles() {
+  for (const auto& path : runFiles_) {
+    std::remove(path.c_str());
+  }
+}
+
+} // namespace sunfish
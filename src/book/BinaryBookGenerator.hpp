@@ -0,0 +1,119 @@
+/* BinaryBookGenerator.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_BOOK_BINARYBOOKGENERATOR_HPP__
+#define SUNFISH_BOOK_BINARYBOOKGENERATOR_HPP__
+
+#include "common/Def.hpp"
+#include "core/record/RecordReader.hpp"
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <utility>
+#include <cstdint>
+
+namespace sunfish {
+
+/**
+ * The generator of the binary book for large kifu collections.
+ *
+ * Worker threads read the records and append the pairs of
+ * a position hash and a move to their own buffers.
+ * A full buffer is sorted, its duplicates are combined and it is
+ * spilled to a run file. The run files are merged into the binary
+ * book at the end. So the memory usage depends only on the run size
+ * and the number of threads.
+ */
+class BinaryBookGenerator {
+public:
+
+  static CONSTEXPR_CONST unsigned DefaultRunSize = 1024 * 1024;
+  static CONSTEXPR_CONST unsigned DefaultLimit = 20;
+
+  template <class T>
+  BinaryBookGenerator(T&& path) :
+    path_(std::forward<T>(path)),
+    limit_(0),
+    threshold_(1),
+    numberOfThreads_(1),
+    runSize_(DefaultRunSize),
+    handicap_(false) {
+  }
+
+  BinaryBookGenerator(const BinaryBookGenerator&) = delete;
+  BinaryBookGenerator(BinaryBookGenerator&&) = delete;
+
+  /**
+   * Set the maximum number of plies from the initial position.
+   */
+  void setLimit(unsigned limit) {
+    limit_ = limit;
+  }
+
+  /**
+   * Set the minimum count of the moves written to the book.
+   */
+  void setThreshold(unsigned threshold) {
+    threshold_ = threshold;
+  }
+
+  void setNumberOfThreads(int numberOfThreads) {
+    numberOfThreads_ = numberOfThreads;
+  }
+
+  /**
+   * Set the number of records which each thread buffers
+   * before spilling them to a run file.
+   */
+  void setRunSize(unsigned runSize) {
+    runSize_ = runSize;
+  }
+
+  void setHandicap(bool enable) {
+    handicap_ = enable;
+  }
+
+  bool generate();
+
+  bool generate(const std::string& outputPath);
+
+  struct RunRecord {
+    uint64_t hash;
+    uint32_t count;
+    uint16_t move;
+    uint16_t reserved;
+  };
+
+private:
+
+  void generateOnThread(int thread);
+
+  bool generate(const Record& record, std::vector<RunRecord>& buffer);
+
+  bool spill(int thread, std::vector<RunRecord>& buffer);
+
+  bool merge(const std::string& outputPath);
+
+  void removeRunFiles();
+
+  std::string path_;
+  unsigned limit_;
+  unsigned threshold_;
+  int numberOfThreads_;
+  unsigned runSize_;
+  bool handicap_;
+
+  std::string outputPath_;
+  RecordReader reader_;
+  std::atomic<bool> error_;
+  std::mutex mutex_;
+  std::vector<std::string> runFiles_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_BOOK_BINARYBOOKGENERATOR_HPP__
@@ -43,6 +43,10 @@ public:
     map_.clear();
   }
 
+  const BookMap& getMap() const {
+    return map_;
+  }
+
   bool load();
 
   bool load(std::istream& is);
@@ -4,54 +4,36 @@
  */
 
 #include "book/BookGenerator.hpp"
-#include "common/file_system/Directory.hpp"
-#include "common/file_system/FileUtil.hpp"
-#include "core/record/CsaReader.hpp"
+#include "core/record/RecordReader.hpp"
 #include "core/util/PositionUtil.hpp"
 #include "logger/Logger.hpp"
-#include <fstream>
 
 namespace sunfish {
 
 bool BookGenerator::generate() {
   book_.clear();
 
-  if (FileUtil::isDirectory(path_)) {
-    // 'path_' points to a directory
-    Directory directory(path_);
-    auto files = directory.files("*.csa");
-    for (const auto& path : files) {
-      if (!generate(path)) {
-        return false;
-      }
-    }
-    return true;
-
-  } else if (FileUtil::isFile(path_)) {
-    // 'path_' points to a file
-    return generate(path_);
-
-  } else {
-    // a specified path is not available.
-    LOG(error) << "not available path: " << path_;
+  RecordReader reader;
+  if (!reader.open(path_)) {
     return false;
   }
 
-}
+  Record record;
+  for (size_t i = 0; i < reader.size(); i++) {
+    if (!reader.read(i, record)) {
+      LOG(warning) << "skip the record: " << reader.getName(i);
+      continue;
+    }
 
-bool BookGenerator::generate(const std::string& path) {
-  std::ifstream file(path);
-  if (!file) {
-    LOG(error) << "could not open a file: " << path;
-    MSG(info) << "";
-    return false;
+    if (!generate(record)) {
+      return false;
+    }
   }
 
-  Record record;
-  CsaReader::read(file, record);
-
-  file.close();
+  return true;
+}
 
+bool BookGenerator::generate(const Record& record) {
   Position position = record.initialPosition;
 
   if (!handicap_ && !PositionUtil::isEvenInitialPosition(position)) {
@@ -7,6 +7,7 @@
 #define SUNFISH_BOOK_BOOKGENERATOR_HPP__
 
 #include "book/Book.hpp"
+#include "core/record/Record.hpp"
 #include <utility>
 
 namespace sunfish {
@@ -37,7 +38,7 @@ public:
 
 private:
 
-  bool generate(const std::string& path);
+  bool generate(const Record& record);
 
   std::string path_;
   Book book_;
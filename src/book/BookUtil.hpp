@@ -10,6 +10,7 @@
 #include "core/move/Move.hpp"
 #include "core/position/Position.hpp"
 #include "book/Book.hpp"
+#include "book/BinaryBook.hpp"
 
 namespace sunfish {
 
@@ -30,6 +31,18 @@ public:
     return bookMoves->at(idx).move;
   }
 
+  static Move select(const BinaryBook& book, const Position& position, Random& random) {
+    auto bookMoves = book.get(position);
+    if (bookMoves.size() == 0) {
+      return Move::none();
+    }
+
+    unsigned idx = random.nonuniform(bookMoves.size(), [&bookMoves](unsigned i) {
+      return bookMoves.count(i);
+    });
+    return bookMoves.move(idx);
+  }
+
 };
 
 } // namespace sunfish
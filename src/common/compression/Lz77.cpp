@@ -0,0 +1,171 @@
+/* Lz77.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "common/compression/Lz77.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+CONSTEXPR_CONST size_t MinimumMatch = 4;
+CONSTEXPR_CONST size_t MaximumOffset = 0xffff;
+CONSTEXPR_CONST int HashBits = 14;
+CONSTEXPR_CONST size_t HashSize = 1 << HashBits;
+CONSTEXPR_CONST uint32_t NoEntry = 0xffffffff;
+CONSTEXPR_CONST unsigned LengthMask = 0x0f;
+
+inline uint32_t read32(const uint8_t* p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline size_t hash(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - HashBits);
+}
+
+void writeLength(size_t length, std::vector<uint8_t>& dst) {
+  for (; length >= 0xff; length -= 0xff) {
+    dst.push_back(0xff);
+  }
+  dst.push_back(static_cast<uint8_t>(length));
+}
+
+bool readLength(const uint8_t*& p, const uint8_t* end, size_t& length) {
+  for (;;) {
+    if (p >= end) {
+      return false;
+    }
+    uint8_t value = *(p++);
+    length += value;
+    if (value != 0xff) {
+      return true;
+    }
+  }
+}
+
+/**
+ * Write a sequence.
+ * The last sequence has no match (matchLength == 0).
+ */
+void writeSequence(const uint8_t* literals,
+                   size_t literalLength,
+                   size_t offset,
+                   size_t matchLength,
+                   std::vector<uint8_t>& dst) {
+  size_t matchCode = matchLength != 0 ? matchLength - MinimumMatch : 0;
+  unsigned token = (std::min<size_t>(literalLength, LengthMask) << 4)
+                 | std::min<size_t>(matchCode, LengthMask);
+  dst.push_back(static_cast<uint8_t>(token));
+
+  if (literalLength >= LengthMask) {
+    writeLength(literalLength - LengthMask, dst);
+  }
+  dst.insert(dst.end(), literals, literals + literalLength);
+
+  if (matchLength == 0) {
+    return;
+  }
+
+  dst.push_back(static_cast<uint8_t>(offset));
+  dst.push_back(static_cast<uint8_t>(offset >> 8));
+  if (matchCode >= LengthMask) {
+    writeLength(matchCode - LengthMask, dst);
+  }
+}
+
+} // namespace
+
+namespace sunfish {
+
+void Lz77::compress(const uint8_t* src,
+                    size_t size,
+                    std::vector<uint8_t>& dst) {
+  std::vector<uint32_t> table(HashSize, NoEntry);
+
+  size_t anchor = 0;
+  size_t i = 0;
+  while (i + MinimumMatch <= size) {
+    uint32_t sequence = read32(&src[i]);
+    auto& entry = table[hash(sequence)];
+    size_t candidate = entry;
+    entry = static_cast<uint32_t>(i);
+
+    if (candidate == NoEntry ||
+        i - candidate > MaximumOffset ||
+        read32(&src[candidate]) != sequence) {
+      i++;
+      continue;
+    }
+
+    size_t length = MinimumMatch;
+    while (i + length < size && src[candidate + length] == src[i + length]) {
+      length++;
+    }
+
+    writeSequence(&src[anchor], i - anchor, i - candidate, length, dst);
+    i += length;
+    anchor = i;
+  }
+
+  writeSequence(&src[anchor], size - anchor, 0, 0, dst);
+}
+
+bool Lz77::decompress(const uint8_t* src,
+                      size_t size,
+                      std::vector<uint8_t>& dst,
+                      size_t originalSize) {
+  dst.resize(originalSize);
+
+  const uint8_t* p = src;
+  const uint8_t* end = src + size;
+  size_t n = 0;
+
+  while (p < end) {
+    unsigned token = *(p++);
+
+    size_t literalLength = token >> 4;
+    if (literalLength == LengthMask && !readLength(p, end, literalLength)) {
+      return false;
+    }
+    if (literalLength > static_cast<size_t>(end - p) ||
+        literalLength > originalSize - n) {
+      return false;
+    }
+    memcpy(&dst[n], p, literalLength);
+    p += literalLength;
+    n += literalLength;
+
+    // the last sequence
+    if (p == end) {
+      break;
+    }
+
+    if (end - p < 2) {
+      return false;
+    }
+    size_t offset = p[0] | (static_cast<size_t>(p[1]) << 8);
+    p += 2;
+
+    size_t matchLength = token & LengthMask;
+    if (matchLength == LengthMask && !readLength(p, end, matchLength)) {
+      return false;
+    }
+    matchLength += MinimumMatch;
+
+    if (offset == 0 || offset > n || matchLength > originalSize - n) {
+      return false;
+    }
+
+    // the source and the destination can overlap.
+    for (size_t i = 0; i < matchLength; i++, n++) {
+      dst[n] = dst[n - offset];
+    }
+  }
+
+  return n == originalSize;
+}
+
+} // namespace sunfish
@@ -0,0 +1,48 @@
+/* Lz77.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_COMMON_COMPRESSION_LZ77_HPP__
+#define SUNFISH_COMMON_COMPRESSION_LZ77_HPP__
+
+#include "common/Def.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace sunfish {
+
+/**
+ * A small LZ77 compressor.
+ * The format is a sequence of (literals, match) pairs like LZ4.
+ * It is fast enough to be used for streaming data of the learning.
+ */
+class Lz77 {
+public:
+
+  Lz77() = delete;
+  Lz77(const Lz77&) = delete;
+  Lz77(Lz77&&) = delete;
+
+  /**
+   * Append the compressed data of src to dst.
+   */
+  static void compress(const uint8_t* src,
+                       size_t size,
+                       std::vector<uint8_t>& dst);
+
+  /**
+   * Decompress src into dst.
+   * The originalSize must be the size of the data before compression.
+   */
+  static bool decompress(const uint8_t* src,
+                         size_t size,
+                         std::vector<uint8_t>& dst,
+                         size_t originalSize);
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_COMMON_COMPRESSION_LZ77_HPP__
@@ -0,0 +1,139 @@
+/* MappedFile.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "common/file_system/MappedFile.hpp"
+#include "logger/Logger.hpp"
+
+#if defined(WIN32)
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+namespace sunfish {
+
+#if defined(WIN32)
+
+bool MappedFile::open(const char* path) {
+  LOG(error) << "memory mapped files are not supported: " << path;
+  return false;
+}
+
+bool MappedFile::openPrivate(const char* path) {
+  LOG(error) << "memory mapped files are not supported: " << path;
+  return false;
+}
+
+bool MappedFile::create(const char* path, size_t) {
+  LOG(error) << "memory mapped files are not supported: " << path;
+  return false;
+}
+
+bool MappedFile::sync() {
+  return false;
+}
+
+void MappedFile::close() {
+}
+
+#else
+
+bool MappedFile::open(const char* path) {
+  return map(path, PROT_READ, MAP_SHARED);
+}
+
+bool MappedFile::openPrivate(const char* path) {
+  return map(path, PROT_READ | PROT_WRITE, MAP_PRIVATE);
+}
+
+bool MappedFile::map(const char* path, int prot, int flags) {
+  close();
+
+  int fd = ::open(path, O_RDONLY);
+  if (fd == -1) {
+    LOG(error) << "could not open a file: " << path;
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    LOG(error) << "could not get the size of a file: " << path;
+    ::close(fd);
+    return false;
+  }
+
+  size_t size = st.st_size;
+  if (size == 0) {
+    // mmap does not accept an empty range.
+    ::close(fd);
+    data_ = &size_;
+    size_ = 0;
+    writable_ = false;
+    return true;
+  }
+
+  void* data = mmap(nullptr, size, prot, flags, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    LOG(error) << "could not map a file: " << path;
+    return false;
+  }
+
+  data_ = data;
+  size_ = size;
+  writable_ = false;
+  return true;
+}
+
+bool MappedFile::create(const char* path, size_t size) {
+  close();
+
+  int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    LOG(error) << "could not open a file: " << path;
+    return false;
+  }
+
+  if (ftruncate(fd, size) != 0) {
+    LOG(error) << "could not extend a file: " << path;
+    ::close(fd);
+    return false;
+  }
+
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    LOG(error) << "could not map a file: " << path;
+    return false;
+  }
+
+  data_ = data;
+  size_ = size;
+  writable_ = true;
+  return true;
+}
+
+bool MappedFile::sync() {
+  if (!writable_ || size_ == 0) {
+    return true;
+  }
+  return msync(data_, size_, MS_SYNC) == 0;
+}
+
+void MappedFile::close() {
+  if (data_ != nullptr && size_ != 0) {
+    munmap(data_, size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  writable_ = false;
+}
+
+#endif
+
+} // namespace sunfish
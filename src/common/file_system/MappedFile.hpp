@@ -0,0 +1,96 @@
+/* MappedFile.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_COMMON_FILESYSTEM_MAPPEDFILE_HPP__
+#define SUNFISH_COMMON_FILESYSTEM_MAPPEDFILE_HPP__
+
+#include "common/Def.hpp"
+#include <string>
+#include <cstddef>
+
+namespace sunfish {
+
+/**
+ * A file mapped into the memory.
+ */
+class MappedFile {
+public:
+
+  MappedFile() : data_(nullptr), size_(0), writable_(false) {
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&&) = delete;
+
+  ~MappedFile() {
+    close();
+  }
+
+  /**
+   * Map an existing file read-only.
+   */
+  bool open(const char* path);
+
+  bool open(const std::string& path) {
+    return open(path.c_str());
+  }
+
+  /**
+   * Map an existing file copy-on-write.
+   * The modifications are not written back to the file.
+   */
+  bool openPrivate(const char* path);
+
+  bool openPrivate(const std::string& path) {
+    return openPrivate(path.c_str());
+  }
+
+  /**
+   * Create a zero-filled file of the specified size and map it writable.
+   */
+  bool create(const char* path, size_t size);
+
+  bool create(const std::string& path, size_t size) {
+    return create(path.c_str(), size);
+  }
+
+  /**
+   * Write the modified pages back to the file.
+   */
+  bool sync();
+
+  void close();
+
+  bool isOpen() const {
+    return data_ != nullptr;
+  }
+
+  const void* data() const {
+    return data_;
+  }
+
+  void* data() {
+    return data_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+private:
+
+#if !defined(WIN32)
+  bool map(const char* path, int prot, int flags);
+#endif
+
+  void* data_;
+  size_t size_;
+  bool writable_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_COMMON_FILESYSTEM_MAPPEDFILE_HPP__
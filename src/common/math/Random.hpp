@@ -18,6 +18,8 @@ class BaseRandom {
 public:
   BaseRandom() : rgen(static_cast<unsigned>(time(NULL))) {
   }
+  explicit BaseRandom(unsigned seed) : rgen(seed) {
+  }
   BaseRandom(const BaseRandom&) = delete;
   BaseRandom(BaseRandom&&) = delete;
 
@@ -0,0 +1,156 @@
+/* ChildProcess.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "common/process/ChildProcess.hpp"
+#include "logger/Logger.hpp"
+
+#if !defined(WIN32)
+# include <sys/types.h>
+# include <sys/wait.h>
+# include <signal.h>
+# include <unistd.h>
+# include <climits>
+# include <cerrno>
+#endif
+
+#if defined(__linux__)
+# include <sys/prctl.h>
+#endif
+
+namespace sunfish {
+
+#if defined(WIN32)
+
+bool ChildProcess::start(const std::vector<std::string>&) {
+  LOG(error) << "child processes are not supported";
+  return false;
+}
+
+bool ChildProcess::isRunning() {
+  return false;
+}
+
+void ChildProcess::wait() {
+}
+
+void ChildProcess::kill() {
+}
+
+std::string ChildProcess::executablePath() {
+  return "";
+}
+
+int ChildProcess::currentPid() {
+  return -1;
+}
+
+bool ChildProcess::exists(int) {
+  return true;
+}
+
+#else
+
+bool ChildProcess::start(const std::vector<std::string>& args) {
+  if (args.empty()) {
+    return false;
+  }
+
+  // the arguments are built before fork,
+  // because only async-signal-safe functions can be called in the child.
+  std::vector<char*> argv;
+  for (const auto& arg : args) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+
+#if defined(__linux__)
+  pid_t parent = getpid();
+#endif
+
+  pid_t pid = fork();
+  if (pid == -1) {
+    LOG(error) << "could not create a process: " << args[0];
+    return false;
+  }
+
+  if (pid == 0) {
+#if defined(__linux__)
+    // the parent may exit before prctl.
+    if (prctl(PR_SET_PDEATHSIG, SIGKILL) != 0 || getppid() != parent) {
+      _exit(127);
+    }
+#endif
+    execvp(argv[0], argv.data());
+    _exit(127);
+  }
+
+  pid_ = pid;
+  exitStatus_ = 0;
+  return true;
+}
+
+bool ChildProcess::isRunning() {
+  if (pid_ == -1) {
+    return false;
+  }
+
+  int status;
+  pid_t result = waitpid(pid_, &status, WNOHANG);
+  if (result == 0) {
+    return true;
+  }
+
+  if (result == pid_) {
+    exitStatus_ = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+  pid_ = -1;
+  return false;
+}
+
+void ChildProcess::wait() {
+  if (pid_ == -1) {
+    return;
+  }
+
+  int status;
+  if (waitpid(pid_, &status, 0) == pid_) {
+    exitStatus_ = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+  pid_ = -1;
+}
+
+void ChildProcess::kill() {
+  if (pid_ == -1) {
+    return;
+  }
+
+  ::kill(pid_, SIGKILL);
+  wait();
+}
+
+std::string ChildProcess::executablePath() {
+  char path[PATH_MAX];
+  ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (length <= 0) {
+    return "";
+  }
+  return std::string(path, length);
+}
+
+int ChildProcess::currentPid() {
+  return getpid();
+}
+
+bool ChildProcess::exists(int pid) {
+  // kill() sends the signal to a group of processes if pid <= 0.
+  if (pid <= 0) {
+    return false;
+  }
+  return ::kill(pid, 0) == 0 || errno == EPERM;
+}
+
+#endif
+
+} // namespace sunfish
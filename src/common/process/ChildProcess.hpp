@@ -0,0 +1,78 @@
+/* ChildProcess.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_COMMON_PROCESS_CHILDPROCESS_HPP__
+#define SUNFISH_COMMON_PROCESS_CHILDPROCESS_HPP__
+
+#include "common/Def.hpp"
+#include <vector>
+#include <string>
+
+namespace sunfish {
+
+class ChildProcess {
+public:
+
+  ChildProcess() : pid_(-1), exitStatus_(0) {
+  }
+
+  ChildProcess(const ChildProcess&) = delete;
+  ChildProcess(ChildProcess&&) = delete;
+
+  /**
+   * Start a process.
+   * args[0] is the program, which is searched in PATH.
+   * On Linux, the process is killed when the calling thread exits.
+   */
+  bool start(const std::vector<std::string>& args);
+
+  /**
+   * Returns true if the process is running.
+   * Otherwise the exit status can be got by getExitStatus().
+   */
+  bool isRunning();
+
+  /**
+   * Wait for the process to exit.
+   */
+  void wait();
+
+  void kill();
+
+  int getExitStatus() const {
+    return exitStatus_;
+  }
+
+  int getPid() const {
+    return pid_;
+  }
+
+  /**
+   * The path of the executable file of the current process.
+   */
+  static std::string executablePath();
+
+  /**
+   * The process ID of the current process.
+   */
+  static int currentPid();
+
+  /**
+   * Returns true if the process of the pid exists.
+   * The parent process is not compared,
+   * because it can be PID 1 or a subreaper.
+   */
+  static bool exists(int pid);
+
+private:
+
+  int pid_;
+  int exitStatus_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_COMMON_PROCESS_CHILDPROCESS_HPP__
@@ -0,0 +1,247 @@
+/* Numa.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "common/thread/Numa.hpp"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__linux__)
+# include <sched.h>
+# include <unistd.h>
+# include <sys/syscall.h>
+#endif
+
+namespace {
+
+using namespace sunfish;
+
+struct NodeInfo {
+  unsigned id;
+  std::vector<int> cpus;
+};
+
+struct Topology {
+  std::vector<NodeInfo> nodes;
+  unsigned numberOfCpus;
+#if defined(__linux__)
+  cpu_set_t processCpus;
+#endif
+};
+
+/**
+ * Parse a list like "0-3,8-11" used in sysfs.
+ */
+void parseList(const std::string& str, std::vector<int>& list) {
+  std::istringstream iss(str);
+  std::string range;
+  while (std::getline(iss, range, ',')) {
+    auto hyphen = range.find('-');
+    int first = std::atoi(range.c_str());
+    int last = hyphen != std::string::npos ? std::atoi(range.c_str() + hyphen + 1) : first;
+    for (int i = first; i <= last; i++) {
+      list.push_back(i);
+    }
+  }
+}
+
+bool readList(const std::string& path, std::vector<int>& list) {
+  std::ifstream file(path);
+  std::string line;
+  if (!std::getline(file, line)) {
+    return false;
+  }
+  parseList(line, list);
+  return true;
+}
+
+Topology detectTopology() {
+  Topology topology;
+
+#if defined(__linux__)
+  CPU_ZERO(&topology.processCpus);
+  if (sched_getaffinity(0, sizeof(topology.processCpus), &topology.processCpus) != 0) {
+    for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); cpu++) {
+      CPU_SET(cpu, &topology.processCpus);
+    }
+  }
+
+  std::vector<int> ids;
+  readList("/sys/devices/system/node/online", ids);
+  for (int id : ids) {
+    std::vector<int> cpus;
+    std::ostringstream path;
+    path << "/sys/devices/system/node/node" << id << "/cpulist";
+    if (!readList(path.str(), cpus)) {
+      continue;
+    }
+
+    NodeInfo node = { static_cast<unsigned>(id), {} };
+    for (int cpu : cpus) {
+      if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &topology.processCpus)) {
+        node.cpus.push_back(cpu);
+      }
+    }
+    if (!node.cpus.empty()) {
+      topology.nodes.push_back(node);
+    }
+  }
+
+  if (topology.nodes.empty()) {
+    // sysfs is not available.
+    NodeInfo node = { 0, {} };
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &topology.processCpus)) {
+        node.cpus.push_back(cpu);
+      }
+    }
+    topology.nodes.push_back(node);
+  }
+#else
+  NodeInfo node = { 0, {} };
+  for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); cpu++) {
+    node.cpus.push_back(cpu);
+  }
+  topology.nodes.push_back(node);
+#endif
+
+  if (topology.nodes[0].cpus.empty()) {
+    topology.nodes[0].cpus.push_back(0);
+  }
+
+  topology.numberOfCpus = 0;
+  for (const auto& node : topology.nodes) {
+    topology.numberOfCpus += node.cpus.size();
+  }
+
+  return topology;
+}
+
+const Topology& getTopology() {
+  static const Topology topology = detectTopology();
+  return topology;
+}
+
+#if defined(__linux__) && defined(SYS_mbind)
+
+// the constants of linux/mempolicy.h
+CONSTEXPR_CONST int MpolBind = 2;
+CONSTEXPR_CONST int MpolInterleave = 3;
+CONSTEXPR_CONST unsigned MpolMfMove = 1 << 1;
+
+CONSTEXPR_CONST unsigned MaxNodes = 1024;
+CONSTEXPR_CONST unsigned BitsPerLong = sizeof(unsigned long) * 8;
+
+bool bindPages(void* p, size_t size, int mode, const std::vector<unsigned>& ids) {
+  unsigned long mask[MaxNodes / BitsPerLong] = { 0 };
+  for (unsigned id : ids) {
+    if (id >= MaxNodes) {
+      return false;
+    }
+    mask[id / BitsPerLong] |= 1ul << (id % BitsPerLong);
+  }
+
+  uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+  uintptr_t begin = (reinterpret_cast<uintptr_t>(p) + pageSize - 1) & ~(pageSize - 1);
+  uintptr_t end = (reinterpret_cast<uintptr_t>(p) + size) & ~(pageSize - 1);
+  if (begin >= end) {
+    return true;
+  }
+
+  // the kernel reads (maxnode - 1) bits of the mask.
+  return syscall(SYS_mbind, begin, end - begin, mode, mask, MaxNodes + 1, MpolMfMove) == 0;
+}
+
+#endif
+
+} // namespace
+
+namespace sunfish {
+
+unsigned Numa::getNumberOfNodes() {
+  return getTopology().nodes.size();
+}
+
+unsigned Numa::getNodeOfThread(unsigned index) {
+  const auto& topology = getTopology();
+  unsigned cpu = index % topology.numberOfCpus;
+  for (unsigned node = 0; node < topology.nodes.size(); node++) {
+    unsigned size = topology.nodes[node].cpus.size();
+    if (cpu < size) {
+      return node;
+    }
+    cpu -= size;
+  }
+  return 0;
+}
+
+#if defined(__linux__)
+
+bool Numa::bindThread(unsigned node) {
+  const auto& topology = getTopology();
+  if (node >= topology.nodes.size()) {
+    return false;
+  }
+
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  for (int cpu : topology.nodes[node].cpus) {
+    CPU_SET(cpu, &cpus);
+  }
+  return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+}
+
+bool Numa::unbindThread() {
+  const auto& topology = getTopology();
+  return sched_setaffinity(0, sizeof(topology.processCpus), &topology.processCpus) == 0;
+}
+
+#else
+
+bool Numa::bindThread(unsigned) {
+  return false;
+}
+
+bool Numa::unbindThread() {
+  return false;
+}
+
+#endif
+
+#if defined(__linux__) && defined(SYS_mbind)
+
+bool Numa::bindMemory(void* p, size_t size, unsigned node) {
+  const auto& topology = getTopology();
+  if (node >= topology.nodes.size()) {
+    return false;
+  }
+  return bindPages(p, size, MpolBind, { topology.nodes[node].id });
+}
+
+bool Numa::interleaveMemory(void* p, size_t size) {
+  std::vector<unsigned> ids;
+  for (const auto& node : getTopology().nodes) {
+    ids.push_back(node.id);
+  }
+  return bindPages(p, size, MpolInterleave, ids);
+}
+
+#else
+
+bool Numa::bindMemory(void*, size_t, unsigned) {
+  return false;
+}
+
+bool Numa::interleaveMemory(void*, size_t) {
+  return false;
+}
+
+#endif
+
+} // namespace sunfish
@@ -0,0 +1,63 @@
+/* Numa.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_COMMON_THREAD_NUMA_HPP__
+#define SUNFISH_COMMON_THREAD_NUMA_HPP__
+
+#include "common/Def.hpp"
+#include <cstddef>
+
+namespace sunfish {
+
+/**
+ * The thread placement and the memory binding on the NUMA nodes.
+ *
+ * The nodes are read from /sys/devices/system/node on Linux and
+ * numbered from 0 in the order of their IDs.
+ * The CPUs out of the affinity of the process are ignored,
+ * and the nodes without the available CPUs are omitted.
+ * The other platforms are regarded as a single node,
+ * and the binding functions return false.
+ */
+class Numa {
+public:
+
+  static unsigned getNumberOfNodes();
+
+  /**
+   * Get the node of the index-th thread.
+   * The threads are packed into the nodes in the order of the CPUs,
+   * so that the second node is used only after the CPUs of the first
+   * node are occupied.
+   */
+  static unsigned getNodeOfThread(unsigned index);
+
+  /**
+   * Bind the calling thread to the CPUs of the node.
+   */
+  static bool bindThread(unsigned node);
+
+  /**
+   * Restore the affinity of the calling thread to the process.
+   */
+  static bool unbindThread();
+
+  /**
+   * Move the pages in the range to the node.
+   * The pages partially overlapping the range are kept.
+   */
+  static bool bindMemory(void* p, size_t size, unsigned node);
+
+  /**
+   * Interleave the pages in the range across all the nodes.
+   * The pages partially overlapping the range are kept.
+   */
+  static bool interleaveMemory(void* p, size_t size);
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_COMMON_THREAD_NUMA_HPP__
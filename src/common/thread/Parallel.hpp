@@ -0,0 +1,32 @@
+/* Parallel.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_COMMON_THREAD_PARALLEL_HPP__
+#define SUNFISH_COMMON_THREAD_PARALLEL_HPP__
+
+#include <thread>
+#include <vector>
+
+namespace sunfish {
+
+/**
+ * Call func(part, parts) on each of `parts' threads.
+ * The part 0 is executed on the calling thread.
+ */
+template <class T>
+void runParallel(int parts, T&& func) {
+  std::vector<std::thread> threads;
+  for (int part = 1; part < parts; part++) {
+    threads.emplace_back(func, part, parts);
+  }
+  func(0, parts);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+} // namespace sunfish
+
+#endif // SUNFISH_COMMON_THREAD_PARALLEL_HPP__
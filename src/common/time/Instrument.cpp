@@ -0,0 +1,129 @@
+/* Instrument.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "common/time/Instrument.hpp"
+
+#if SUNFISH_INSTRUMENT
+
+#include "common/string/TablePrinter.hpp"
+#include "logger/Logger.hpp"
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include <cstring>
+
+namespace {
+
+using namespace sunfish;
+
+const char* const Names[Instrument::NumberOfIds] = {
+  "generate captures",
+  "generate quiets",
+  "generate evasions",
+  "do move",
+  "undo move",
+  "evaluate",
+  "SEE",
+  "mate 1 ply",
+  "TT probe",
+  "TT store",
+  "next move",
+  "sort moves",
+};
+
+std::mutex mutex;
+std::vector<Instrument::Counters*> liveCounters;
+Instrument::Counters retiredCounters;
+uint64_t baseTime = Instrument::now();
+
+void merge(Instrument::Counters& dst, const Instrument::Counters& src) {
+  for (int i = 0; i < Instrument::NumberOfIds; i++) {
+    dst.count[i] += src.count[i];
+    dst.cycles[i] += src.cycles[i];
+  }
+}
+
+/**
+ * The counters of a thread.
+ * They are registered to be summed up by print().
+ */
+class CountersHolder {
+public:
+
+  CountersHolder() {
+    memset(&counters_, 0, sizeof(counters_));
+    std::lock_guard<std::mutex> lock(mutex);
+    liveCounters.push_back(&counters_);
+  }
+
+  ~CountersHolder() {
+    std::lock_guard<std::mutex> lock(mutex);
+    merge(retiredCounters, counters_);
+    liveCounters.erase(std::remove(liveCounters.begin(), liveCounters.end(), &counters_),
+                       liveCounters.end());
+  }
+
+  Instrument::Counters& counters() {
+    return counters_;
+  }
+
+private:
+
+  Instrument::Counters counters_;
+
+};
+
+} // namespace
+
+namespace sunfish {
+
+Instrument::Counters& Instrument::counters() {
+  thread_local CountersHolder holder;
+  return holder.counters();
+}
+
+void Instrument::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  memset(&retiredCounters, 0, sizeof(retiredCounters));
+  for (auto counters : liveCounters) {
+    memset(counters, 0, sizeof(*counters));
+  }
+  baseTime = now();
+}
+
+void Instrument::print() {
+  Counters total;
+  uint64_t elapsed;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    total = retiredCounters;
+    for (auto counters : liveCounters) {
+      merge(total, *counters);
+    }
+    elapsed = now() - baseTime;
+  }
+
+  // the ratios can exceed 100% if the probes are nested
+  // or more than one thread is run.
+  TablePrinter tp;
+  tp.row() << "component" << "calls" << "Mcycles" << "cycles/call" << "% of wall";
+  for (int i = 0; i < NumberOfIds; i++) {
+    auto count = total.count[i];
+    auto cycles = total.cycles[i];
+    tp.row() << Names[i]
+             << count
+             << (cycles / 1000000)
+             << (count != 0 ? cycles / count : 0)
+             << (elapsed != 0 ? cycles * 100 / elapsed : 0);
+  }
+
+  MSG(info) << "instrumentation:";
+  MSG(info) << "  wall: " << (elapsed / 1000000) << " Mcycles";
+  MSG(info) << tp.stringify();
+}
+
+} // namespace sunfish
+
+#endif // SUNFISH_INSTRUMENT
@@ -0,0 +1,126 @@
+/* Instrument.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_COMMON_TIME_INSTRUMENT_HPP__
+#define SUNFISH_COMMON_TIME_INSTRUMENT_HPP__
+
+#include <cstdint>
+
+#ifndef SUNFISH_INSTRUMENT
+# define SUNFISH_INSTRUMENT 0
+#endif
+
+#if SUNFISH_INSTRUMENT
+# if defined(WIN32)
+#  include <intrin.h>
+# elif defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+# else
+#  include <chrono>
+# endif
+#endif
+
+namespace sunfish {
+
+/**
+ * The cycle counters of the hot paths.
+ * The probes are compiled only if SUNFISH_INSTRUMENT is 1,
+ * and INSTRUMENT_SCOPE is expanded to nothing otherwise.
+ * The counted time of a probe includes the nested probes.
+ */
+class Instrument {
+public:
+
+  enum Id {
+    GenerateCaptures,
+    GenerateQuiets,
+    GenerateEvasions,
+    DoMove,
+    UndoMove,
+    Evaluate,
+    See,
+    Mate1Ply,
+    TTProbe,
+    TTStore,
+    NextMove,
+    SortMoves,
+    NumberOfIds,
+  };
+
+  struct Counters {
+    uint64_t count[NumberOfIds];
+    uint64_t cycles[NumberOfIds];
+  };
+
+  Instrument() = delete;
+
+#if SUNFISH_INSTRUMENT
+  static uint64_t now() {
+# if defined(WIN32) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+# else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+# endif
+  }
+
+  /**
+   * Get the counters of the current thread.
+   * They are merged into the global counters at the exit of the thread.
+   */
+  static Counters& counters();
+
+  static void clear();
+
+  /**
+   * Show the breakdown of the time.
+   */
+  static void print();
+#else
+  static void clear() {
+  }
+
+  static void print() {
+  }
+#endif
+
+};
+
+#if SUNFISH_INSTRUMENT
+
+class InstrumentScope {
+public:
+
+  explicit InstrumentScope(Instrument::Id id) :
+      id_(id),
+      begin_(Instrument::now()) {
+  }
+  InstrumentScope(const InstrumentScope&) = delete;
+  InstrumentScope(InstrumentScope&&) = delete;
+
+  ~InstrumentScope() {
+    auto& counters = Instrument::counters();
+    counters.count[id_]++;
+    counters.cycles[id_] += Instrument::now() - begin_;
+  }
+
+private:
+
+  Instrument::Id id_;
+  uint64_t begin_;
+
+};
+
+# define INSTRUMENT_SCOPE(id) ::sunfish::InstrumentScope instrumentScope__(::sunfish::Instrument::id)
+
+#else
+
+# define INSTRUMENT_SCOPE(id)
+
+#endif
+
+} // namespace sunfish
+
+#endif // SUNFISH_COMMON_TIME_INSTRUMENT_HPP__
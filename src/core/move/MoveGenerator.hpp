@@ -8,6 +8,7 @@
 
 #include "core/move/Moves.hpp"
 #include "core/position/Position.hpp"
+#include "common/time/Instrument.hpp"
 
 namespace sunfish {
 
@@ -20,6 +21,7 @@ public:
    */
   static void generateCaptures(const Position& pos, Moves& moves) {
     ASSERT(!pos.inCheck());
+    INSTRUMENT_SCOPE(GenerateCaptures);
     if (pos.getTurn() == Turn::Black) {
       generateMovesOnBoard<Turn::Black, GenerationType::Capture, false>(pos, moves, Bitboard::full());
     } else {
@@ -33,6 +35,7 @@ public:
    */
   static void generateQuiets(const Position& pos, Moves& moves) {
     ASSERT(!pos.inCheck());
+    INSTRUMENT_SCOPE(GenerateQuiets);
     if (pos.getTurn() == Turn::Black) {
       generateMovesOnBoard<Turn::Black, GenerationType::Quiet, false>(pos, moves, Bitboard::full());
       generateDrops<Turn::Black>(pos, moves, Bitboard::full());
@@ -48,6 +51,7 @@ public:
    */
   static void generateEvasions(const Position& pos, CheckState checkState, Moves& moves) {
     ASSERT(pos.inCheck());
+    INSTRUMENT_SCOPE(GenerateEvasions);
     if (pos.getTurn() == Turn::Black) {
       generateEvasions<Turn::Black>(pos, checkState, moves);
     } else {
@@ -0,0 +1,160 @@
+/* PackedPosition.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "core/position/PackedPosition.hpp"
+#include <cstring>
+
+namespace {
+
+using namespace sunfish;
+
+CONSTEXPR_CONST int PieceBits = 5;
+CONSTEXPR_CONST PieceRawType PieceMask = PieceNumber::White | PieceNumber::TypeMask;
+
+/**
+ * The number of bits of each piece type in hand.
+ */
+const int HandBits[PieceNumber::HandNum] = {
+  5, // pawn
+  3, // lance
+  3, // knight
+  3, // silver
+  3, // gold
+  2, // bishop
+  2, // rook
+};
+
+class BitWriter {
+public:
+
+  BitWriter(uint8_t* data) : data_(data), offset_(0) {
+  }
+
+  bool write(unsigned value, int bits) {
+    for (int i = 0; i < bits; i++) {
+      if (offset_ >= PackedPosition::Size * 8) {
+        return false;
+      }
+      if (value & (1u << i)) {
+        data_[offset_ / 8] |= static_cast<uint8_t>(1u << (offset_ % 8));
+      }
+      offset_++;
+    }
+    return true;
+  }
+
+private:
+
+  uint8_t* data_;
+  size_t offset_;
+
+};
+
+class BitReader {
+public:
+
+  BitReader(const uint8_t* data) : data_(data), offset_(0) {
+  }
+
+  bool read(unsigned& value, int bits) {
+    value = 0;
+    for (int i = 0; i < bits; i++) {
+      if (offset_ >= PackedPosition::Size * 8) {
+        return false;
+      }
+      if (data_[offset_ / 8] & (1u << (offset_ % 8))) {
+        value |= 1u << i;
+      }
+      offset_++;
+    }
+    return true;
+  }
+
+private:
+
+  const uint8_t* data_;
+  size_t offset_;
+
+};
+
+} // namespace
+
+namespace sunfish {
+
+PackedPosition packPosition(const MutablePosition& mp) {
+  PackedPosition packed;
+  memset(packed.data, 0, sizeof(packed.data));
+
+  BitWriter writer(packed.data);
+
+  writer.write(mp.turn == Turn::Black ? 1 : 0, 1);
+
+  SQUARE_EACH(square) {
+    Piece piece = mp.board[square.raw()];
+    if (piece.isEmpty()) {
+      writer.write(0, 1);
+    } else {
+      writer.write(1, 1);
+      writer.write(piece.raw() & PieceMask, PieceBits);
+    }
+  }
+
+  HAND_EACH(pieceType) {
+    writer.write(mp.blackHand.get(pieceType), HandBits[pieceType.raw()]);
+  }
+  HAND_EACH(pieceType) {
+    writer.write(mp.whiteHand.get(pieceType), HandBits[pieceType.raw()]);
+  }
+
+  return packed;
+}
+
+bool unpackPosition(const PackedPosition& packed, MutablePosition& mp) {
+  BitReader reader(packed.data);
+  unsigned value;
+
+  if (!reader.read(value, 1)) {
+    return false;
+  }
+  mp.turn = value ? Turn::Black : Turn::White;
+
+  SQUARE_EACH(square) {
+    if (!reader.read(value, 1)) {
+      return false;
+    }
+
+    if (value == 0) {
+      mp.board[square.raw()] = Piece::empty();
+      continue;
+    }
+
+    if (!reader.read(value, PieceBits)) {
+      return false;
+    }
+    unsigned type = value & ~static_cast<unsigned>(PieceNumber::White);
+    if (type == (PieceNumber::Promotion | PieceNumber::Gold) ||
+        type == (PieceNumber::Promotion | PieceNumber::King)) {
+      return false;
+    }
+    mp.board[square.raw()] = Piece(static_cast<PieceRawType>(value));
+  }
+
+  HAND_EACH(pieceType) {
+    if (!reader.read(value, HandBits[pieceType.raw()])) {
+      return false;
+    }
+    mp.blackHand.set(pieceType, value);
+  }
+  HAND_EACH(pieceType) {
+    if (!reader.read(value, HandBits[pieceType.raw()])) {
+      return false;
+    }
+    mp.whiteHand.set(pieceType, value);
+  }
+
+  return true;
+}
+
+} // namespace sunfish
@@ -0,0 +1,35 @@
+/* PackedPosition.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_CORE_POSITION_PACKEDPOSITION_HPP__
+#define SUNFISH_CORE_POSITION_PACKEDPOSITION_HPP__
+
+#include "common/Def.hpp"
+#include "core/position/Position.hpp"
+#include <cstdint>
+
+namespace sunfish {
+
+/**
+ * Bit-packed representation of a position.
+ *
+ *   turn   :  1 bit
+ *   board  : 81 squares (empty: 1 bit, occupied: 1 + 5 bits)
+ *   hands  : 21 bits for each side
+ *
+ * The size is at most 324 bits.
+ */
+struct PackedPosition {
+  static CONSTEXPR_CONST size_t Size = 41;
+  uint8_t data[Size];
+};
+
+PackedPosition packPosition(const MutablePosition& mp);
+
+bool unpackPosition(const PackedPosition& packed, MutablePosition& mp);
+
+} // namespace sunfish
+
+#endif // SUNFISH_CORE_POSITION_PACKEDPOSITION_HPP__
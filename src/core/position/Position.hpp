@@ -12,6 +12,7 @@
 #include "core/position/Bitboard.hpp"
 #include "core/position/Hand.hpp"
 #include "core/position/Zobrist.hpp"
+#include "common/time/Instrument.hpp"
 
 #include <array>
 #include <tuple>
@@ -303,6 +304,7 @@ public:
    * Make move
    */
   bool doMove(const Move& move, Piece& capturedPiece) {
+    INSTRUMENT_SCOPE(DoMove);
     if (turn_ == Turn::Black) {
       return doMove<Turn::Black>(move, capturedPiece);
     } else {
@@ -314,6 +316,7 @@ public:
    * Undo move
    */
   void undoMove(const Move& move, const Piece& capturedPiece) {
+    INSTRUMENT_SCOPE(UndoMove);
     if (turn_ == Turn::Black) {
       undoMove<Turn::White>(move, capturedPiece);
     } else {
@@ -49,17 +49,142 @@ InputStatus forEach(std::istream& is, T&& f) {
   }
 }
 
+/**
+ * Call f for each statement of the lines from `p' to `end'.
+ * The statements are copied into the buffer on the stack,
+ * and the comment lines are not split by commas.
+ */
+template <class T>
+InputStatus forEach(const char*& p, const char* end, T&& f) {
+  char buffer[LINE_BUFFER_SIZE];
+
+  while (p < end) {
+    const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    const char* lineEnd = eol != nullptr ? eol : end;
+    const char* next = eol != nullptr ? eol + 1 : end;
+    if (lineEnd != p && lineEnd[-1] == '\r') {
+      lineEnd--;
+    }
+
+    const char* q = p;
+    p = next;
+
+    while (true) {
+      const char* comma = q < lineEnd && q[0] != '\''
+                        ? static_cast<const char*>(memchr(q, ',', lineEnd - q))
+                        : nullptr;
+      const char* statementEnd = comma != nullptr ? comma : lineEnd;
+
+      size_t length = statementEnd - q;
+      if (length >= LINE_BUFFER_SIZE) {
+        LOG(error) << "too long line";
+        return InputStatus::Error;
+      }
+      memcpy(buffer, q, length);
+      buffer[length] = '\0';
+
+      auto status = f(buffer);
+      if (status != InputStatus::Continue) {
+        return status;
+      }
+
+      if (comma == nullptr) {
+        break;
+      }
+      q = comma + 1;
+    }
+  }
+
+  return InputStatus::Eof;
+}
+
 } // namespace
 
 namespace sunfish {
 
+bool CsaReader::read(const char* begin,
+                     const char* end,
+                     Record& record,
+                     RecordInfo* info/* = nullptr*/,
+                     const char** next/* = nullptr*/) {
+  MutablePosition mp;
+  initializeMutablePosition(mp);
+
+  if (info != nullptr) {
+    initializeRecordInfo(*info);
+  }
+
+  const char* p = begin;
+
+  auto status = forEach(p, end, [&mp, info](const char* line) {
+    if (!readPosition(line, mp, info)) {
+      return InputStatus::Error;
+    }
+
+    if (line[0] == '+' || line[0] == '-') {
+      return InputStatus::Break;
+    }
+
+    return InputStatus::Continue;
+  });
+
+  if (status != InputStatus::Break) {
+    if (next != nullptr) {
+      *next = end;
+    }
+    return false;
+  }
+
+  record.initialPosition.initialize(mp);
+  record.moveList.clear();
+  record.specialMove.clear();
+
+  Position position = record.initialPosition;
+
+  status = forEach(p, end, [&record, &position](const char* line) {
+    if (line[0] == '/') {
+      return InputStatus::Break;
+    }
+
+    if (readComment(line) ||
+        readTime(line) ||
+        readSpecialMove(line, record)) {
+      return InputStatus::Continue;
+    }
+
+    Move move;
+    if (!readMove(line, position, move)) {
+      LOG(error) << "invalid move: " << line;
+      return InputStatus::Error;
+    }
+
+    record.moveList.push_back(move);
+
+    Piece captured;
+    if (!position.doMove(move, captured)) {
+      LOG(error) << "invalid move: " << line;
+      return InputStatus::Error;
+    }
+
+    return InputStatus::Continue;
+  });
+
+  if (next != nullptr) {
+    *next = p;
+  }
+
+  return status != InputStatus::Error;
+}
+
 bool CsaReader::read(std::istream& is,
                      Record& record,
                      RecordInfo* info/* = nullptr*/) {
   MutablePosition mp;
   initializeMutablePosition(mp);
 
-  if (!readPosition(is, mp, info)) {
+  // the end of the stream is reached without the turn
+  // after the last game of a multi-game file.
+  if (!readPosition(is, mp, info) || is.eof()) {
     return false;
   }
 
@@ -69,6 +194,10 @@ bool CsaReader::read(std::istream& is,
   Position position = record.initialPosition;
 
   auto status = forEach(is, [&record, &position, info](const char* line) {
+    if (line[0] == '/') {
+      return InputStatus::Break;
+    }
+
     if (readComment(line) ||
         readTime(line) ||
         readSpecialMove(line, record)) {
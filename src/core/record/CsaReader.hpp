@@ -20,9 +20,27 @@ public:
 
   CsaReader() = delete;
 
+  /**
+   * Read a record from the stream.
+   * The stream is left at the beginning of the following record
+   * of a multi-game file.
+   */
   static bool read(std::istream& is,
                    Record& record,
                    RecordInfo* info = nullptr);
+
+  /**
+   * Read a record from the bytes in [begin, end) without
+   * allocating each line.
+   * The records in a multi-game file are separated by the line of "/",
+   * and `next' is set to the beginning of the following record.
+   * false is returned if no position is found before the end.
+   */
+  static bool read(const char* begin,
+                   const char* end,
+                   Record& record,
+                   RecordInfo* info = nullptr,
+                   const char** next = nullptr);
   static bool readPosition(std::istream& is,
                            Position& position,
                            RecordInfo* info = nullptr);
@@ -0,0 +1,110 @@
+/* RecordDatabase.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "core/record/RecordDatabase.hpp"
+#include "core/position/PackedPosition.hpp"
+#include "logger/Logger.hpp"
+#include <algorithm>
+
+namespace {
+
+using namespace sunfish;
+
+inline void put8(std::vector<uint8_t>& buffer, uint8_t value) {
+  buffer.push_back(value);
+}
+
+inline void put16(std::vector<uint8_t>& buffer, uint16_t value) {
+  buffer.push_back(static_cast<uint8_t>(value));
+  buffer.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+} // namespace
+
+namespace sunfish {
+
+const char RecordDatabase::FileMagic[4] = { 'S', 'F', 'D', 'B' };
+const char RecordDatabase::IndexMagic[4] = { 'S', 'F', 'D', 'I' };
+
+RecordDatabaseWriter::RecordDatabaseWriter() : offset_(0) {
+}
+
+RecordDatabaseWriter::~RecordDatabaseWriter() {
+  if (file_.is_open()) {
+    close();
+  }
+}
+
+bool RecordDatabaseWriter::open(const std::string& path) {
+  file_.open(path, std::ios::out | std::ios::binary);
+  if (!file_) {
+    LOG(error) << "could not open a file: " << path;
+    return false;
+  }
+
+  path_ = path;
+  offsets_.clear();
+  offset_ = 0;
+
+  uint16_t version = RecordDatabase::Version;
+  uint16_t reserved = 0;
+  return writeBytes(RecordDatabase::FileMagic, sizeof(RecordDatabase::FileMagic))
+      && writeBytes(&version, sizeof(version))
+      && writeBytes(&reserved, sizeof(reserved));
+}
+
+bool RecordDatabaseWriter::close() {
+  uint64_t indexOffset = offset_;
+  uint32_t numberOfRecords = static_cast<uint32_t>(offsets_.size());
+  bool ok = writeBytes(offsets_.data(), sizeof(uint64_t) * offsets_.size())
+         && writeBytes(&indexOffset, sizeof(indexOffset))
+         && writeBytes(&numberOfRecords, sizeof(numberOfRecords))
+         && writeBytes(RecordDatabase::IndexMagic, sizeof(RecordDatabase::IndexMagic));
+
+  file_.close();
+
+  if (!ok) {
+    LOG(error) << "file I/O error: " << path_;
+  }
+  return ok;
+}
+
+bool RecordDatabaseWriter::write(const Record& record) {
+  if (record.moveList.size() > 0xffff ||
+      record.specialMove.size() > 0xff) {
+    LOG(error) << "the record is too long";
+    return false;
+  }
+
+  static const Zobrist::Type EvenHash = Position(Position::Handicap::Even).getHash();
+  bool hasInitialPosition = record.initialPosition.getHash() != EvenHash;
+
+  buffer_.clear();
+  put16(buffer_, static_cast<uint16_t>(record.moveList.size()));
+  put8(buffer_, hasInitialPosition ? RecordDatabase::FlagInitialPosition : 0);
+  put8(buffer_, static_cast<uint8_t>(record.specialMove.size()));
+
+  if (hasInitialPosition) {
+    auto packed = packPosition(record.initialPosition.getMutablePosition());
+    buffer_.insert(buffer_.end(), packed.data, packed.data + PackedPosition::Size);
+  }
+
+  buffer_.insert(buffer_.end(), record.specialMove.begin(), record.specialMove.end());
+
+  for (const auto& move : record.moveList) {
+    put16(buffer_, move.serialize16());
+  }
+
+  offsets_.push_back(offset_);
+  return writeBytes(buffer_.data(), buffer_.size());
+}
+
+bool RecordDatabaseWriter::writeBytes(const void* data, size_t size) {
+  file_.write(reinterpret_cast<const char*>(data), size);
+  offset_ += size;
+  return !file_.fail();
+}
+
+} // namespace sunfish
@@ -0,0 +1,71 @@
+/* RecordDatabase.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_CORE_RECORD_RECORDDATABASE_HPP__
+#define SUNFISH_CORE_RECORD_RECORDDATABASE_HPP__
+
+#include "core/record/Record.hpp"
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace sunfish {
+
+/**
+ * The file format of the record database.
+ *
+ *   header  : magic and version
+ *   records : the number of moves (16 bits), flags (8 bits),
+ *             the length of the special move (8 bits),
+ *             the packed initial position if it is not the standard one,
+ *             the special move and the 16-bit moves
+ *   index   : the offset of each record (64 bits)
+ *   footer  : the offset of the index, the number of records and magic
+ */
+struct RecordDatabase {
+  static CONSTEXPR_CONST uint16_t Version = 1;
+  static CONSTEXPR_CONST uint8_t FlagInitialPosition = 0x01;
+  static CONSTEXPR_CONST size_t HeaderSize = 8;
+  static CONSTEXPR_CONST size_t FooterSize = 16;
+
+  static const char FileMagic[4];
+  static const char IndexMagic[4];
+};
+
+class RecordDatabaseWriter {
+public:
+
+  RecordDatabaseWriter();
+  RecordDatabaseWriter(const RecordDatabaseWriter&) = delete;
+  RecordDatabaseWriter(RecordDatabaseWriter&&) = delete;
+
+  ~RecordDatabaseWriter();
+
+  bool open(const std::string& path);
+
+  bool close();
+
+  bool write(const Record& record);
+
+  uint32_t getNumberOfRecords() const {
+    return static_cast<uint32_t>(offsets_.size());
+  }
+
+private:
+
+  bool writeBytes(const void* data, size_t size);
+
+  std::ofstream file_;
+  std::string path_;
+  std::vector<uint64_t> offsets_;
+  std::vector<uint8_t> buffer_;
+  uint64_t offset_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_CORE_RECORD_RECORDDATABASE_HPP__
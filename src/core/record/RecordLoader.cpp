@@ -0,0 +1,188 @@
+/* RecordLoader.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "core/record/RecordLoader.hpp"
+#include "core/record/CsaReader.hpp"
+#include "common/file_system/Directory.hpp"
+#include "common/file_system/FileUtil.hpp"
+#include "common/file_system/MappedFile.hpp"
+#include "logger/Logger.hpp"
+#include <algorithm>
+#include <fstream>
+
+namespace sunfish {
+
+RecordLoader::RecordLoader() :
+    numberOfThreads_(DefaultNumberOfThreads),
+    queueSize_(DefaultQueueSize),
+    nextFile_(0),
+    runningThreads_(0),
+    stop_(false) {
+}
+
+RecordLoader::~RecordLoader() {
+  stop();
+}
+
+bool RecordLoader::start(const std::string& path) {
+  stop();
+
+  files_.clear();
+
+  if (FileUtil::isDirectory(path)) {
+    Directory directory(path);
+    auto files = directory.files("*.csa");
+    files_.assign(files.begin(), files.end());
+  } else if (FileUtil::isFile(path)) {
+    files_.push_back(path);
+  } else {
+    LOG(error) << "not available path: " << path;
+    return false;
+  }
+
+  nextFile_ = 0;
+  stop_ = false;
+
+  int numberOfThreads = std::max(numberOfThreads_, 1);
+  runningThreads_ = numberOfThreads;
+  for (int i = 0; i < numberOfThreads; i++) {
+    threads_.emplace_back([this]() {
+      work();
+    });
+  }
+
+  return true;
+}
+
+bool RecordLoader::next(Record& record) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  notEmpty_.wait(lock, [this]() {
+    return !queue_.empty() || runningThreads_ == 0;
+  });
+
+  if (queue_.empty()) {
+    return false;
+  }
+
+  record = std::move(queue_.front());
+  queue_.pop_front();
+
+  notFull_.notify_one();
+
+  return true;
+}
+
+void RecordLoader::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  notFull_.notify_all();
+
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+
+  queue_.clear();
+  runningThreads_ = 0;
+}
+
+void RecordLoader::work() {
+  for (;;) {
+    size_t index = nextFile_++;
+    if (index >= files_.size() || !loadFile(files_[index])) {
+      break;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  runningThreads_--;
+  notEmpty_.notify_all();
+}
+
+#if defined(WIN32)
+
+bool RecordLoader::loadFile(const std::string& path) {
+  // memory mapped files are not supported.
+  std::ifstream file(path);
+  if (!file) {
+    LOG(warning) << "skip the file: " << path;
+    return true;
+  }
+
+  while (true) {
+    Record record;
+    if (!CsaReader::read(file, record)) {
+      if (!record.moveList.empty()) {
+        LOG(warning) << "the record is incomplete: " << path;
+      }
+      break;
+    }
+
+    if (!push(std::move(record))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+#else
+
+bool RecordLoader::loadFile(const std::string& path) {
+  MappedFile file;
+  if (!file.open(path)) {
+    LOG(warning) << "skip the file: " << path;
+    return true;
+  }
+
+  const char* p = static_cast<const char*>(file.data());
+  const char* end = p + file.size();
+
+  while (p < end) {
+    Record record;
+    const char* next;
+    if (!CsaReader::read(p, end, record, nullptr, &next)) {
+      // the following games are not read, because the end of
+      // the broken game is unknown.
+      if (!record.moveList.empty()) {
+        LOG(warning) << "the record is incomplete: " << path;
+      }
+      break;
+    }
+
+    if (!push(std::move(record))) {
+      return false;
+    }
+
+    p = next;
+  }
+
+  return true;
+}
+
+#endif
+
+bool RecordLoader::push(Record&& record) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  notFull_.wait(lock, [this]() {
+    return queue_.size() < queueSize_ || stop_;
+  });
+
+  if (stop_) {
+    return false;
+  }
+
+  queue_.push_back(std::move(record));
+
+  notEmpty_.notify_one();
+
+  return true;
+}
+
+} // namespace sunfish
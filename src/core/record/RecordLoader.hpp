@@ -0,0 +1,93 @@
+/* RecordLoader.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_CORE_RECORD_RECORDLOADER_HPP__
+#define SUNFISH_CORE_RECORD_RECORDLOADER_HPP__
+
+#include "core/record/Record.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <string>
+
+namespace sunfish {
+
+/**
+ * Load the records of CSA files on the worker threads.
+ * Each file is mapped into the memory and all games in it are parsed,
+ * while RecordReader reads only the first game of each file.
+ * A broken game is skipped as RecordReader does,
+ * and the games after it in the same file are not read.
+ * The loaded records are passed through a bounded queue,
+ * so the order of records is not deterministic.
+ */
+class RecordLoader {
+public:
+
+  static CONSTEXPR_CONST int DefaultNumberOfThreads = 4;
+  static CONSTEXPR_CONST size_t DefaultQueueSize = 1024;
+
+  RecordLoader();
+  RecordLoader(const RecordLoader&) = delete;
+  RecordLoader(RecordLoader&&) = delete;
+
+  ~RecordLoader();
+
+  void setNumberOfThreads(int numberOfThreads) {
+    numberOfThreads_ = numberOfThreads;
+  }
+
+  void setQueueSize(size_t queueSize) {
+    queueSize_ = queueSize;
+  }
+
+  /**
+   * Start loading a directory of CSA files or a CSA file.
+   */
+  bool start(const std::string& path);
+
+  /**
+   * Get the next record.
+   * false is returned after all records are taken.
+   */
+  bool next(Record& record);
+
+  /**
+   * Stop the worker threads.
+   */
+  void stop();
+
+  size_t getNumberOfFiles() const {
+    return files_.size();
+  }
+
+private:
+
+  void work();
+
+  bool loadFile(const std::string& path);
+
+  bool push(Record&& record);
+
+  int numberOfThreads_;
+  size_t queueSize_;
+  std::vector<std::string> files_;
+  std::atomic<size_t> nextFile_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable notEmpty_;
+  std::condition_variable notFull_;
+  std::deque<Record> queue_;
+  int runningThreads_;
+  bool stop_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_CORE_RECORD_RECORDLOADER_HPP__
@@ -0,0 +1,250 @@
+/* RecordReader.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "core/record/RecordReader.hpp"
+#include "core/record/RecordDatabase.hpp"
+#include "core/record/CsaReader.hpp"
+#include "core/position/PackedPosition.hpp"
+#include "common/file_system/Directory.hpp"
+#include "common/file_system/FileUtil.hpp"
+#include "logger/Logger.hpp"
+#include <fstream>
+#include <sstream>
+#include <cstring>
+
+namespace {
+
+using namespace sunfish;
+
+CONSTEXPR_CONST size_t RecordHeaderSize = 4;
+
+inline uint16_t get16(const uint8_t* p) {
+  return p[0] | (static_cast<uint16_t>(p[1]) << 8);
+}
+
+inline uint64_t get64(const uint8_t* p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+bool isDatabaseFile(const std::string& path) {
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  char magic[4];
+  file.read(magic, sizeof(magic));
+  return !file.fail() &&
+         memcmp(magic, RecordDatabase::FileMagic, sizeof(magic)) == 0;
+}
+
+} // namespace
+
+namespace sunfish {
+
+RecordReader::RecordReader() :
+    isDatabase_(false),
+    data_(nullptr),
+    index_(nullptr),
+    indexOffset_(0),
+    numberOfRecords_(0),
+    next_(0) {
+}
+
+bool RecordReader::open(const std::string& path) {
+  close();
+
+  path_ = path;
+
+  if (FileUtil::isDirectory(path)) {
+    // 'path' points to a directory
+    Directory directory(path);
+    auto files = directory.files("*.csa");
+    files_.assign(files.begin(), files.end());
+    return true;
+
+  } else if (FileUtil::isFile(path)) {
+    if (isDatabaseFile(path)) {
+      return openDatabase(path);
+    }
+
+    // 'path' points to a CSA file
+    files_.push_back(path);
+    return true;
+
+  } else {
+    // a specified path is not available.
+    LOG(error) << "not available path: " << path;
+    return false;
+  }
+}
+
+bool RecordReader::openDatabase(const std::string& path) {
+  if (!file_.open(path)) {
+    return false;
+  }
+
+  data_ = static_cast<const uint8_t*>(file_.data());
+  size_t size = file_.size();
+
+  if (size < RecordDatabase::HeaderSize + RecordDatabase::FooterSize) {
+    LOG(error) << "invalid record database: " << path;
+    close();
+    return false;
+  }
+
+  uint16_t version = get16(data_ + 4);
+  if (version != RecordDatabase::Version) {
+    LOG(error) << "unsupported version of record database: " << version;
+    close();
+    return false;
+  }
+
+  const uint8_t* footer = data_ + size - RecordDatabase::FooterSize;
+  uint64_t indexOffset = get64(footer);
+  uint32_t numberOfRecords;
+  memcpy(&numberOfRecords, footer + 8, sizeof(numberOfRecords));
+
+  if (memcmp(footer + 12, RecordDatabase::IndexMagic, 4) != 0 ||
+      indexOffset < RecordDatabase::HeaderSize ||
+      indexOffset + sizeof(uint64_t) * numberOfRecords
+      != size - RecordDatabase::FooterSize) {
+    LOG(error) << "the index of record database is broken: " << path;
+    close();
+    return false;
+  }
+
+  isDatabase_ = true;
+  index_ = data_ + indexOffset;
+  indexOffset_ = indexOffset;
+  numberOfRecords_ = numberOfRecords;
+  return true;
+}
+
+void RecordReader::close() {
+  file_.close();
+  isDatabase_ = false;
+  data_ = nullptr;
+  index_ = nullptr;
+  indexOffset_ = 0;
+  numberOfRecords_ = 0;
+  files_.clear();
+  next_ = 0;
+}
+
+bool RecordReader::read(size_t index, Record& record) const {
+  if (index >= size()) {
+    return false;
+  }
+
+  return isDatabase_ ? readDatabase(index, record) : readFile(index, record);
+}
+
+bool RecordReader::next(Record& record) {
+  for (;;) {
+    size_t index = next_++;
+    if (index >= size()) {
+      return false;
+    }
+
+    if (read(index, record)) {
+      return true;
+    }
+
+    LOG(warning) << "skip the record: " << getName(index);
+  }
+}
+
+std::string RecordReader::getName(size_t index) const {
+  if (!isDatabase_) {
+    return index < files_.size() ? files_[index] : path_;
+  }
+
+  std::ostringstream oss;
+  oss << path_ << '#' << index;
+  return oss.str();
+}
+
+bool RecordReader::readDatabase(size_t index, Record& record) const {
+  uint64_t offset = get64(index_ + sizeof(uint64_t) * index);
+  if (offset < RecordDatabase::HeaderSize ||
+      offset + RecordHeaderSize > indexOffset_) {
+    LOG(error) << "a record of record database is broken: " << getName(index);
+    return false;
+  }
+
+  const uint8_t* p = data_ + offset;
+  const uint8_t* end = data_ + indexOffset_;
+  unsigned numberOfMoves = get16(p);
+  unsigned flags = p[2];
+  unsigned specialMoveLength = p[3];
+  p += RecordHeaderSize;
+
+  size_t positionSize = (flags & RecordDatabase::FlagInitialPosition)
+                      ? PackedPosition::Size : 0;
+  if (static_cast<size_t>(end - p) <
+      positionSize + specialMoveLength + numberOfMoves * 2) {
+    LOG(error) << "a record of record database is broken: " << getName(index);
+    return false;
+  }
+
+  if (flags & RecordDatabase::FlagInitialPosition) {
+    PackedPosition packed;
+    memcpy(packed.data, p, PackedPosition::Size);
+    p += PackedPosition::Size;
+
+    MutablePosition mp;
+    if (!unpackPosition(packed, mp)) {
+      LOG(error) << "a record of record database is broken: " << getName(index);
+      return false;
+    }
+    record.initialPosition.initialize(mp);
+  } else {
+    record.initialPosition.initialize(Position::Handicap::Even);
+  }
+
+  record.specialMove.assign(reinterpret_cast<const char*>(p), specialMoveLength);
+  p += specialMoveLength;
+
+  record.moveList.resize(numberOfMoves);
+  for (unsigned i = 0; i < numberOfMoves; i++, p += 2) {
+    record.moveList[i] = Move::deserialize(get16(p));
+  }
+
+  return true;
+}
+
+bool RecordReader::readFile(size_t index, Record& record) const {
+  const auto& path = files_[index];
+
+  // only the first game is read from a multi-game file.
+  record.specialMove.clear();
+
+#if defined(WIN32)
+  // memory mapped files are not supported.
+  std::ifstream file(path);
+  if (!file) {
+    LOG(error) << "could not open a file: " << path;
+    return false;
+  }
+
+  bool ok = CsaReader::read(file, record);
+#else
+  MappedFile file;
+  if (!file.open(path)) {
+    return false;
+  }
+
+  const char* begin = static_cast<const char*>(file.data());
+  bool ok = CsaReader::read(begin, begin + file.size(), record);
+#endif
+
+  if (!ok) {
+    LOG(warning) << "the record is incomplete: " << path;
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace sunfish
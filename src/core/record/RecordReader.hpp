@@ -0,0 +1,98 @@
+/* RecordReader.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_CORE_RECORD_RECORDREADER_HPP__
+#define SUNFISH_CORE_RECORD_RECORDREADER_HPP__
+
+#include "core/record/Record.hpp"
+#include "common/file_system/MappedFile.hpp"
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace sunfish {
+
+/**
+ * Read the records from a record database, a directory of CSA files
+ * or a CSA file.
+ * read() and next() can be called concurrently.
+ *
+ * A CSA file is indexed as a single record without parsing it,
+ * so only the first game of a multi-game file is read.
+ * RecordLoader reads all the games, and the record database
+ * converted by csa2db indexes each of them.
+ */
+class RecordReader {
+public:
+
+  RecordReader();
+  RecordReader(const RecordReader&) = delete;
+  RecordReader(RecordReader&&) = delete;
+
+  /**
+   * Open a record database, a directory or a CSA file.
+   */
+  bool open(const std::string& path);
+
+  void close();
+
+  /**
+   * Get the number of records.
+   */
+  size_t size() const {
+    return isDatabase_ ? numberOfRecords_ : files_.size();
+  }
+
+  bool isDatabase() const {
+    return isDatabase_;
+  }
+
+  /**
+   * Read the record of the specified index.
+   * false is returned if the record is broken or incomplete.
+   * The moves before an error of a CSA file are left in the record.
+   */
+  bool read(size_t index, Record& record) const;
+
+  /**
+   * Read the next record.
+   * The records which could not be read are skipped.
+   * false is returned at the end.
+   */
+  bool next(Record& record);
+
+  /**
+   * Get the name of the record to report errors.
+   */
+  std::string getName(size_t index) const;
+
+  void rewind() {
+    next_ = 0;
+  }
+
+private:
+
+  bool openDatabase(const std::string& path);
+
+  bool readDatabase(size_t index, Record& record) const;
+
+  bool readFile(size_t index, Record& record) const;
+
+  std::string path_;
+  bool isDatabase_;
+  MappedFile file_;
+  const uint8_t* data_;
+  const uint8_t* index_;
+  uint64_t indexOffset_;
+  uint32_t numberOfRecords_;
+  std::vector<std::string> files_;
+  std::atomic<size_t> next_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_CORE_RECORD_RECORDREADER_HPP__
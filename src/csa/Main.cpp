@@ -6,9 +6,11 @@
 #include "common/console/Console.hpp"
 #include "common/program_options/ProgramOptions.hpp"
 #include "common/resource/Resource.hpp"
+#include "common/string/StringUtil.hpp"
 #include "core/util/CoreUtil.hpp"
 #include "search/util/SearchUtil.hpp"
 #include "csa/client/CsaClient.hpp"
+#include "csa/server/MockServer.hpp"
 #include "logger/Logger.hpp"
 #include <iostream>
 #include <fstream>
@@ -31,6 +33,7 @@ int main(int argc, char** argv, char**) {
   // program options
   ProgramOptions po;
   po.addOption("silent", "s", "silent mode");
+  po.addOption("mock", "play the specified number of games against a mock server on the loopback interface", true);
   po.addOption("help", "h", "show this help");
   po.parse(argc, argv);
 
@@ -67,10 +70,38 @@ int main(int argc, char** argv, char**) {
     MSG(warning) << "WARNING: "  << invalidArgument.reason << ": `" << invalidArgument.arg << "'";
   }
 
+  // the log is written on a background thread
+  // not to block the search threads.
+  AsyncLogger::start();
+
   // CSA client
   CsaClient client;
 
+  // mock server
+  MockServer mockServer;
+  bool mock = po.has("mock");
+  if (mock) {
+    int games = StringUtil::toInt(po.getValue("mock"), 1);
+    mockServer.setNumberOfGames(games);
+    if (!mockServer.start()) {
+      AsyncLogger::stop();
+      return 1;
+    }
+    client.setServer("127.0.0.1", mockServer.getPort());
+    client.setRepeat(games);
+  }
+
   bool ok = client.start();
 
+  if (mock) {
+    mockServer.stop();
+    ok = ok &&
+         mockServer.getNumberOfErrors() == 0 &&
+         mockServer.getNumberOfIllegalMoves() == 0;
+  }
+
+  // the log file is closed at the end of this function.
+  AsyncLogger::stop();
+
   return ok ? 0 : 1;
 }
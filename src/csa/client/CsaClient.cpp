@@ -32,6 +32,8 @@ CONSTEXPR_CONST int DefaultLimit     = 0;
 CONSTEXPR_CONST int DefaultRepeat    = 1000;
 CONSTEXPR_CONST int DefaultPonder    = 1;
 CONSTEXPR_CONST int DefaultUseBook   = 1;
+CONSTEXPR_CONST int DefaultNuma      = 0;
+CONSTEXPR_CONST int DefaultReplicateEval = 0;
 CONSTEXPR_CONST int DefaultHashMem   = 64;
 CONSTEXPR_CONST int DefaultMarginMs  = 1000;
 
@@ -77,7 +79,11 @@ bool CsaClient::start() {
     return false;
   }
 
-  book_.load();
+  if (BinaryBook::exists()) {
+    binaryBook_.open();
+  } else {
+    book_.load();
+  }
 
   if (!searcher_) {
     auto dataSourceType = Evaluator::sharedEvaluator()->dataSourceType();
@@ -110,6 +116,8 @@ void CsaClient::readConfigFromIniFile() {
   config_.limit    = StringUtil::toInt(getValue(ini, "Search", "Limit"), DefaultLimit);
   config_.repeat   = StringUtil::toInt(getValue(ini, "Search", "Repeat"), DefaultRepeat);
   config_.worker   = StringUtil::toInt(getValue(ini, "Search", "Worker"), std::thread::hardware_concurrency());
+  config_.numa     = StringUtil::toInt(getValue(ini, "Search", "Numa"), DefaultNuma);
+  config_.replicateEval = StringUtil::toInt(getValue(ini, "Search", "ReplicateEval"), DefaultReplicateEval);
   config_.ponder   = StringUtil::toInt(getValue(ini, "Search", "Ponder"), DefaultPonder);
   config_.useBook     = StringUtil::toInt(getValue(ini, "Search", "UseBook"), DefaultUseBook);
   config_.hashMem  = StringUtil::toInt(getValue(ini, "Search", "HashMem"), DefaultHashMem);
@@ -122,6 +130,15 @@ void CsaClient::readConfigFromIniFile() {
 
   config_.kifuDir = getValue(ini, "File", "KifuDir");
 
+  if (!hostOverride_.empty()) {
+    config_.host = hostOverride_;
+    config_.port = portOverride_;
+  }
+
+  if (repeatOverride_ > 0) {
+    config_.repeat = repeatOverride_;
+  }
+
   MSG(info) << "Configurations";
   MSG(info) << "  Server";
   MSG(info) << "    Host     : " << config_.host;
@@ -134,6 +151,8 @@ void CsaClient::readConfigFromIniFile() {
   MSG(info) << "    Limit   : " << config_.limit;
   MSG(info) << "    Repeat  : " << config_.repeat;
   MSG(info) << "    Worker  : " << config_.worker;
+  MSG(info) << "    Numa    : " << config_.numa;
+  MSG(info) << "    ReplicateEval: " << config_.replicateEval;
   MSG(info) << "    Ponder  : " << config_.ponder;
   MSG(info) << "    UseBook : " << config_.useBook;
   MSG(info) << "    HashMem : " << config_.hashMem;
@@ -181,6 +200,17 @@ void CsaClient::play() {
     return;
   }
 
+  // the received lines are queued by the reader thread.
+  SocketReader::AutoStopper as(reader_);
+  if (!reader_.start()) {
+    LOG(error) << "failed to start the socket reader";
+    return;
+  }
+
+  latencyCount_ = 0;
+  latencyTotalUs_ = 0;
+  latencyMaxUs_ = 0;
+
   bool loginOk = login();
   if (!loginOk) {
     LOG(error) << "login failed";
@@ -209,6 +239,7 @@ void CsaClient::play() {
     ScopedThread searchThread;
     bool isMyTurn = gameSummary_.myTurn == position_.getTurn();
     if (isMyTurn) {
+      turnStartTime_ = lastReceivedTime_;
       runSearch(searchThread);
     } else if (config_.ponder) {
       runPonder(searchThread);
@@ -243,6 +274,8 @@ void CsaClient::play() {
 
   writeRecord();
 
+  showLatency();
+
   bool logoutOk = logout();
   if (!logoutOk) {
     LOG(error) << "logout failed";
@@ -601,10 +634,12 @@ bool CsaClient::onMove() {
 void CsaClient::runSearch(ScopedThread& searchThread) {
   // check opening book
   if (config_.useBook) {
-    Move bookMove = BookUtil::select(book_, position_, random_);
+    Move bookMove = binaryBook_.isOpen()
+        ? BookUtil::select(binaryBook_, position_, random_)
+        : BookUtil::select(book_, position_, random_);
     if (!bookMove.isNone()) {
       MSG(info) << "opening book hit";
-      send(bookMove.toString(position_));
+      sendMove(bookMove.toString(position_));
       return;
     }
   }
@@ -643,6 +678,8 @@ void CsaClient::search() {
   }
 
   config.numberOfThreads = config_.worker;
+  config.numa = config_.numa != 0;
+  config.replicateEval = config_.replicateEval != 0;
 
   searcher_->setConfig(config);
 
@@ -652,7 +689,7 @@ void CsaClient::search() {
   auto& result = searcher_->getResult();
 
   if (result.move.isNone()) {
-    send("%TORYO");
+    sendMove("%TORYO");
     return;
   }
 
@@ -681,7 +718,7 @@ void CsaClient::search() {
     }
   }
 
-  send(oss.str());
+  sendMove(oss.str());
 }
 
 void CsaClient::runPonder(ScopedThread& searchThread) {
@@ -701,6 +738,8 @@ void CsaClient::ponder() {
   config.maximumTimeMs = SearchConfig::InfinityTime;
   config.optimumTimeMs = SearchConfig::InfinityTime;
   config.numberOfThreads = config_.worker;
+  config.numa = config_.numa != 0;
+  config.replicateEval = config_.replicateEval != 0;
 
   searcher_->setConfig(config);
 
@@ -735,22 +774,48 @@ bool CsaClient::send(const T& str) {
   return true;
 }
 
-bool CsaClient::receive() {
-  if (!socket_.receiveString(lastReceivedString_)) {
+bool CsaClient::sendMove(const std::string& str) {
+  if (!send(str)) {
     return false;
   }
 
-  // chomp
-  if (lastReceivedString_.length() != 0 &&
-      lastReceivedString_.back() == '\n') {
-    lastReceivedString_.resize(lastReceivedString_.length() - 1);
+  auto latencyUs = std::chrono::duration_cast<std::chrono::microseconds>(
+      Clock::now() - turnStartTime_).count();
+  latencyCount_++;
+  latencyTotalUs_ += latencyUs;
+  latencyMaxUs_ = std::max<int64_t>(latencyMaxUs_, latencyUs);
+
+  MSG(info) << "latency: " << (latencyUs / 1000.0) << " msec";
+
+  return true;
+}
+
+bool CsaClient::receive() {
+  SocketReader::Message message;
+  if (!reader_.receive(message)) {
+    return false;
   }
 
+  lastReceivedString_ = std::move(message.line);
+  lastReceivedTime_ = message.receivedTime;
+
   MSG(receive) << lastReceivedString_;
 
   return true;
 }
 
+void CsaClient::showLatency() {
+  if (latencyCount_ == 0) {
+    return;
+  }
+
+  MSG(info) << "Latency";
+  MSG(info) << "  Moves  : " << latencyCount_;
+  MSG(info) << "  Average: " << (latencyTotalUs_ / latencyCount_ / 1000.0) << " msec";
+  MSG(info) << "  Maximum: " << (latencyMaxUs_ / 1000.0) << " msec";
+  MSG(info) << "";
+}
+
 bool CsaClient::writeRecord() {
   std::ostringstream path;
   path << config_.kifuDir;
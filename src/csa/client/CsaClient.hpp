@@ -10,11 +10,14 @@
 #include "search/Searcher.hpp"
 #include "core/record/Record.hpp"
 #include "book/Book.hpp"
+#include "book/BinaryBook.hpp"
 #include "csa/client/Socket.hpp"
+#include "csa/client/SocketReader.hpp"
 #include <string>
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <cstdint>
 
 namespace sunfish {
 
@@ -36,6 +39,8 @@ public:
     int limit;
     int repeat;
     int worker;
+    int numa;
+    int replicateEval;
     int ponder;
     int useBook;
     int hashMem;
@@ -70,12 +75,28 @@ public:
     int increment;
   };
 
-  CsaClient() = default;
+  CsaClient() : reader_(socket_), portOverride_(0), repeatOverride_(0) {
+  }
 
   CsaClient(const CsaClient&) = delete;
 
   CsaClient(CsaClient&&) = delete;
 
+  /**
+   * Connect to the specified server instead of the one in csa.ini.
+   */
+  void setServer(const std::string& host, int port) {
+    hostOverride_ = host;
+    portOverride_ = port;
+  }
+
+  /**
+   * Play the specified number of games instead of Search.Repeat.
+   */
+  void setRepeat(int repeat) {
+    repeatOverride_ = repeat;
+  }
+
   bool start();
 
 private:
@@ -121,14 +142,31 @@ private:
   template <class T>
   bool send(const T& str);
 
+  /**
+   * Send my move and record the latency from receiving the command
+   * which started my turn.
+   */
+  bool sendMove(const std::string& str);
+
   bool receive();
 
+  void showLatency();
+
   bool writeRecord();
 
 private:
 
+  using Clock = SocketReader::Clock;
+
   Socket socket_;
+  SocketReader reader_;
   std::string lastReceivedString_;
+  Clock::time_point lastReceivedTime_;
+  Clock::time_point turnStartTime_;
+
+  std::string hostOverride_;
+  int portOverride_;
+  int repeatOverride_;
 
   Config config_;
   GameSummary gameSummary_;
@@ -138,11 +176,16 @@ private:
   int blackTime_;
   int whiteTime_;
 
+  unsigned latencyCount_;
+  int64_t latencyTotalUs_;
+  int64_t latencyMaxUs_;
+
   std::unique_ptr<Searcher> searcher_;
   std::atomic<bool> searcherIsStarted_;
   std::mutex sendMutex_;
 
   Book book_;
+  BinaryBook binaryBook_;
 
   Random random_;
 
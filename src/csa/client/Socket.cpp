@@ -18,6 +18,8 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <errno.h>
 
 namespace sunfish {
@@ -105,31 +107,47 @@ void Socket::disconnect() {
   MSG(info) << "disconnected from " << host_ << ':' << port_;
 }
 
-bool Socket::receiveString(std::string& out) {
-  for (;;) {
-    if (getline(receivedStringStream_, out)) {
-      return true;
-    }
+bool Socket::setNonBlocking() {
+  int flags = fcntl(sock_, F_GETFL, 0);
+  if (flags == -1 || fcntl(sock_, F_SETFL, flags | O_NONBLOCK) == -1) {
+    LOG(error) << "an error occured in fcntl function. (errno: " << errno << ")";
+    return false;
+  }
+  return true;
+}
 
-    char buffer[1024];
-    ssize_t size = recv(sock_,
-                        buffer,
-                        sizeof(buffer),
-                        0);
+bool Socket::sendString(const std::string& str) {
+  const char* p = str.c_str();
+  size_t length = str.length();
+
+  while (length != 0) {
+#if defined(MSG_NOSIGNAL)
+    ssize_t size = ::send(sock_, p, length, MSG_NOSIGNAL);
+#else
+    ssize_t size = ::send(sock_, p, length, 0);
+#endif
     if (size == -1) {
-      return false;
+      if (errno == EINTR) {
+        continue;
+      }
+
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        return false;
+      }
+
+      // the send buffer is full
+      struct pollfd pfd = { sock_, POLLOUT, 0 };
+      if (poll(&pfd, 1, -1) == -1 && errno != EINTR) {
+        return false;
+      }
+      continue;
     }
 
-    receivedStringStream_.str(std::string(buffer, size));
-    receivedStringStream_.clear(std::stringstream::goodbit);
+    p += size;
+    length -= size;
   }
-}
 
-bool Socket::sendString(const std::string& str) {
-  return ::send(sock_,
-                str.c_str(),
-                str.length(),
-                0) != -1;
+  return true;
 }
 
 } // namespace sunfish
@@ -8,7 +8,6 @@
 
 #include "common/Def.hpp"
 
-#include <sstream>
 #include <string>
 
 namespace sunfish {
@@ -63,8 +62,25 @@ public:
 
   void disconnect();
 
-  bool receiveString(std::string& out);
+  bool isOpened() const {
+    return opened_;
+  }
+
+  SocketType getDescriptor() const {
+    return sock_;
+  }
 
+  /**
+   * Make the socket non-blocking.
+   * The received data are read by SocketReader.
+   */
+  bool setNonBlocking();
+
+  /**
+   * Send the string.
+   * This waits for the socket to be writable
+   * even if the socket is non-blocking.
+   */
   bool sendString(const std::string& str);
 
 private:
@@ -80,8 +96,6 @@ private:
   SocketType sock_;
   bool opened_;
 
-  std::istringstream receivedStringStream_;
-
 };
 
 } // namespace sunfish
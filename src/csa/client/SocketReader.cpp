@@ -0,0 +1,186 @@
+/* SocketReader.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "csa/client/SocketReader.hpp"
+#include "csa/client/Socket.hpp"
+#include "logger/Logger.hpp"
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <errno.h>
+
+namespace {
+
+CONSTEXPR_CONST size_t ReceiveBufferSize = 4 * 1024;
+
+} // namespace
+
+namespace sunfish {
+
+SocketReader::SocketReader(Socket& socket) :
+    socket_(socket),
+    wakeFds_{ -1, -1 },
+    closed_(true) {
+}
+
+SocketReader::~SocketReader() {
+  stop();
+}
+
+bool SocketReader::start() {
+  stop();
+
+  if (!socket_.setNonBlocking()) {
+    return false;
+  }
+
+  // stop() writes to this pipe to wake the reader thread up.
+  if (pipe(wakeFds_) == -1) {
+    LOG(error) << "an error occured in pipe function. (errno: " << errno << ")";
+    return false;
+  }
+
+  messages_.clear();
+  closed_ = false;
+
+  thread_ = std::thread([this]() {
+    run();
+  });
+
+  return true;
+}
+
+void SocketReader::stop() {
+  if (thread_.joinable()) {
+    char c = 0;
+    while (write(wakeFds_[1], &c, 1) == -1 && errno == EINTR) {
+    }
+    thread_.join();
+  }
+
+  if (wakeFds_[0] != -1) {
+    ::close(wakeFds_[0]);
+    ::close(wakeFds_[1]);
+    wakeFds_[0] = -1;
+    wakeFds_[1] = -1;
+  }
+
+  close();
+}
+
+bool SocketReader::receive(Message& message) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  cv_.wait(lock, [this]() {
+    return !messages_.empty() || closed_;
+  });
+
+  if (messages_.empty()) {
+    return false;
+  }
+
+  message = std::move(messages_.front());
+  messages_.pop_front();
+  return true;
+}
+
+void SocketReader::run() {
+  std::string buffer;
+
+  for (;;) {
+    struct pollfd fds[2] = {
+      { socket_.getDescriptor(), POLLIN, 0 },
+      { wakeFds_[0], POLLIN, 0 },
+    };
+
+    if (poll(fds, 2, -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG(error) << "an error occured in poll function. (errno: " << errno << ")";
+      break;
+    }
+
+    if (fds[1].revents != 0) {
+      break;
+    }
+
+    if (fds[0].revents != 0 && !readSocket(buffer)) {
+      break;
+    }
+  }
+
+  close();
+}
+
+bool SocketReader::readSocket(std::string& buffer) {
+  char data[ReceiveBufferSize];
+  bool ok = true;
+
+  for (;;) {
+    ssize_t size = recv(socket_.getDescriptor(), data, sizeof(data), 0);
+    if (size == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        LOG(error) << "an error occured in recv function. (errno: " << errno << ")";
+        ok = false;
+      }
+      break;
+    }
+
+    if (size == 0) {
+      // the connection is closed by the server.
+      ok = false;
+      break;
+    }
+
+    buffer.append(data, size);
+  }
+
+  auto receivedTime = Clock::now();
+  size_t begin = 0;
+  std::deque<Message> messages;
+
+  for (;;) {
+    size_t end = buffer.find('\n', begin);
+    if (end == std::string::npos) {
+      break;
+    }
+
+    size_t length = end - begin;
+    if (length != 0 && buffer[end-1] == '\r') {
+      length--;
+    }
+
+    // the empty lines are sent to keep the connection alive.
+    if (length != 0) {
+      messages.push_back({ buffer.substr(begin, length), receivedTime });
+    }
+
+    begin = end + 1;
+  }
+  buffer.erase(0, begin);
+
+  if (!messages.empty()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& message : messages) {
+      messages_.push_back(std::move(message));
+    }
+    cv_.notify_one();
+  }
+
+  return ok;
+}
+
+void SocketReader::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  closed_ = true;
+  cv_.notify_all();
+}
+
+} // namespace sunfish
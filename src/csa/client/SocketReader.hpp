@@ -0,0 +1,93 @@
+/* SocketReader.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_CSA_CLIENT_SOCKETREADER_HPP__
+#define SUNFISH_CSA_CLIENT_SOCKETREADER_HPP__
+
+#include "common/Def.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <deque>
+#include <string>
+
+namespace sunfish {
+
+class Socket;
+
+/**
+ * Read the socket on a dedicated thread.
+ * The thread waits for the non-blocking socket with poll(2),
+ * splits the received data into lines and pushes them to the queue
+ * with the time at which they are received.
+ */
+class SocketReader {
+public:
+
+  using Clock = std::chrono::steady_clock;
+
+  struct Message {
+    std::string line;
+    Clock::time_point receivedTime;
+  };
+
+  class AutoStopper {
+  public:
+
+    AutoStopper(SocketReader& reader) : reader_(reader) {
+    }
+
+    ~AutoStopper() {
+      reader_.stop();
+    }
+
+  private:
+
+    SocketReader& reader_;
+
+  };
+
+  explicit SocketReader(Socket& socket);
+  SocketReader(const SocketReader&) = delete;
+  SocketReader(SocketReader&&) = delete;
+
+  ~SocketReader();
+
+  /**
+   * Start reading the connected socket.
+   */
+  bool start();
+
+  void stop();
+
+  /**
+   * Pop the next line.
+   * This blocks until a line is received,
+   * and false is returned if the connection is closed.
+   */
+  bool receive(Message& message);
+
+private:
+
+  void run();
+
+  bool readSocket(std::string& buffer);
+
+  void close();
+
+  Socket& socket_;
+  int wakeFds_[2];
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Message> messages_;
+  bool closed_;
+  std::thread thread_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_CSA_CLIENT_SOCKETREADER_HPP__
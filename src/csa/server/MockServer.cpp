@@ -0,0 +1,350 @@
+/* MockServer.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "csa/server/MockServer.hpp"
+#include "core/position/Position.hpp"
+#include "core/move/Move.hpp"
+#include "core/record/CsaReader.hpp"
+#include "common/string/StringUtil.hpp"
+#include "logger/Logger.hpp"
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <errno.h>
+
+namespace {
+
+using namespace sunfish;
+
+CONSTEXPR_CONST size_t ReceiveBufferSize = 4 * 1024;
+
+void closeSocket(int sock) {
+  if (sock != -1) {
+    shutdown(sock, SHUT_RDWR);
+    close(sock);
+  }
+}
+
+} // namespace
+
+namespace sunfish {
+
+MockServer::MockServer() :
+    port_(0),
+    numberOfGames_(1),
+    byoyomi_(DefaultByoyomi),
+    maxMoves_(DefaultMaxMoves),
+    listenSocket_(-1),
+    socket_(-1),
+    stop_(false) {
+}
+
+MockServer::~MockServer() {
+  stop();
+}
+
+bool MockServer::start() {
+  stop();
+
+  listenSocket_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenSocket_ == -1) {
+    LOG(error) << "an error occured in socket function. (errno: " << errno << ")";
+    return false;
+  }
+
+  int reuse = 1;
+  setsockopt(listenSocket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  // only the connections from the loopback interface are accepted.
+  struct sockaddr_in sin;
+  memset(&sin, 0, sizeof(sin));
+  sin.sin_family = AF_INET;
+  sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  sin.sin_port = htons(port_);
+  if (bind(listenSocket_, (struct sockaddr*)(&sin), sizeof(sin)) == -1 ||
+      listen(listenSocket_, 1) == -1) {
+    LOG(error) << "an error occured in bind/listen function. (errno: " << errno << ")";
+    closeSocket(listenSocket_);
+    listenSocket_ = -1;
+    return false;
+  }
+
+  socklen_t length = sizeof(sin);
+  if (getsockname(listenSocket_, (struct sockaddr*)(&sin), &length) == -1) {
+    LOG(error) << "an error occured in getsockname function. (errno: " << errno << ")";
+    closeSocket(listenSocket_);
+    listenSocket_ = -1;
+    return false;
+  }
+  port_ = ntohs(sin.sin_port);
+
+  MSG(info) << "mock server is listening on 127.0.0.1:" << port_;
+
+  games_ = 0;
+  illegalMoves_ = 0;
+  errors_ = 0;
+  moves_ = 0;
+  latencyTotalUs_ = 0;
+  latencyMaxUs_ = 0;
+  stop_ = false;
+
+  thread_ = std::thread([this]() {
+    run();
+  });
+
+  return true;
+}
+
+void MockServer::stop() {
+  if (thread_.joinable()) {
+    // the blocking accept and recv are interrupted by shutdown.
+    stop_ = true;
+    shutdown(listenSocket_, SHUT_RDWR);
+    int sock = socket_;
+    if (sock != -1) {
+      shutdown(sock, SHUT_RDWR);
+    }
+    thread_.join();
+    showResult();
+  }
+
+  closeSocket(listenSocket_);
+  listenSocket_ = -1;
+}
+
+void MockServer::run() {
+  for (int game = 0; game < numberOfGames_ && !stop_; game++) {
+    int sock = accept(listenSocket_, nullptr, nullptr);
+    if (sock == -1) {
+      if (!stop_) {
+        LOG(error) << "an error occured in accept function. (errno: " << errno << ")";
+      }
+      break;
+    }
+
+    socket_ = sock;
+    buffer_.clear();
+
+    if (play(game)) {
+      games_++;
+    } else {
+      errors_++;
+    }
+
+    socket_ = -1;
+    closeSocket(sock);
+  }
+}
+
+bool MockServer::play(int game) {
+  std::string line;
+
+  if (!receiveLine(line) || line.compare(0, 6, "LOGIN ") != 0) {
+    LOG(error) << "mock server: LOGIN is expected: " << line;
+    return false;
+  }
+
+  auto user = StringUtil::splitOnce(line.substr(6), ' ').first;
+  if (!sendLine("LOGIN:" + user + " OK")) {
+    return false;
+  }
+
+  // the client plays black and white alternately.
+  Turn clientTurn = game % 2 == 0 ? Turn::Black : Turn::White;
+  std::string gameId = "mock-" + std::to_string(game);
+  Position position(Position::Handicap::Even);
+
+  std::ostringstream summary;
+  summary << "BEGIN Game_Summary\n"
+          << "Protocol_Version:1.1\n"
+          << "Protocol_Mode:Server\n"
+          << "Format:Shogi 1.0\n"
+          << "Declaration:Jishogi 1.1\n"
+          << "Game_ID:" << gameId << "\n"
+          << "Name+:" << (clientTurn == Turn::Black ? user : "mock") << "\n"
+          << "Name-:" << (clientTurn == Turn::White ? user : "mock") << "\n"
+          << "Your_Turn:" << (clientTurn == Turn::Black ? '+' : '-') << "\n"
+          << "To_Move:+\n"
+          << "Max_Moves:" << maxMoves_ << "\n"
+          << "BEGIN Time\n"
+          << "Time_Unit:1sec\n"
+          << "Total_Time:0\n"
+          << "Byoyomi:" << byoyomi_ << "\n"
+          << "Least_Time_Per_Move:0\n"
+          << "END Time\n"
+          << "BEGIN Position\n"
+          << position.toString()
+          << "END Position\n"
+          << "END Game_Summary";
+  if (!sendLine(summary.str())) {
+    return false;
+  }
+
+  if (!receiveLine(line) || line != "AGREE") {
+    LOG(error) << "mock server: AGREE is expected: " << line;
+    return false;
+  }
+
+  if (!sendLine("START:" + gameId)) {
+    return false;
+  }
+
+  auto sentTime = Clock::now();
+
+  for (int ply = 0; ; ply++) {
+    if (ply >= maxMoves_) {
+      if (!sendLine("#MAX_MOVES\n#CENSORED")) {
+        return false;
+      }
+      break;
+    }
+
+    if (position.getTurn() != clientTurn) {
+      Move move;
+      if (!searcher_.search(position, move)) {
+        if (!sendLine("%TORYO,T0\n#RESIGN\n#WIN")) {
+          return false;
+        }
+        break;
+      }
+
+      if (!sendLine(move.toString(position) + ",T0")) {
+        return false;
+      }
+      sentTime = Clock::now();
+
+      Piece captured;
+      position.doMove(move, captured);
+      continue;
+    }
+
+    if (!receiveLine(line)) {
+      LOG(error) << "mock server: the connection is closed in the game.";
+      return false;
+    }
+
+    auto latencyUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - sentTime).count();
+    auto usedSec = std::to_string(latencyUs / 1000000);
+
+    // the comment of floodgate mode is ignored.
+    auto mstr = StringUtil::splitOnce(line, ',').first;
+
+    if (mstr == "%TORYO") {
+      if (!sendLine("%TORYO,T" + usedSec + "\n#RESIGN\n#LOSE")) {
+        return false;
+      }
+      break;
+    }
+
+    Move move;
+    Piece captured;
+    if (!CsaReader::readMove(mstr.c_str(), position, move) ||
+        move.toString(position) != mstr ||
+        !position.doMove(move, captured)) {
+      LOG(error) << "mock server: illegal move: " << line;
+      illegalMoves_++;
+      if (!sendLine("#ILLEGAL_MOVE\n#LOSE")) {
+        return false;
+      }
+      break;
+    }
+
+    moves_++;
+    latencyTotalUs_ += latencyUs;
+    latencyMaxUs_ = std::max<int64_t>(latencyMaxUs_, latencyUs);
+
+    if (!sendLine(mstr + ",T" + usedSec)) {
+      return false;
+    }
+    sentTime = Clock::now();
+  }
+
+  // the client sends LOGOUT after the game.
+  while (receiveLine(line)) {
+    if (line == "LOGOUT") {
+      sendLine("LOGOUT:completed");
+      break;
+    }
+  }
+
+  return true;
+}
+
+bool MockServer::sendLine(const std::string& line) {
+  std::string data = line + "\n";
+  const char* p = data.c_str();
+  size_t length = data.length();
+
+  while (length != 0) {
+#if defined(MSG_NOSIGNAL)
+    ssize_t size = send(socket_, p, length, MSG_NOSIGNAL);
+#else
+    ssize_t size = send(socket_, p, length, 0);
+#endif
+    if (size == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    p += size;
+    length -= size;
+  }
+
+  return true;
+}
+
+bool MockServer::receiveLine(std::string& line) {
+  line.clear();
+
+  for (;;) {
+    size_t end = buffer_.find('\n');
+    if (end != std::string::npos) {
+      line = buffer_.substr(0, end);
+      buffer_.erase(0, end + 1);
+      if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+      }
+
+      // the empty lines are sent to keep the connection alive.
+      if (line.empty()) {
+        continue;
+      }
+      return true;
+    }
+
+    char data[ReceiveBufferSize];
+    ssize_t size = recv(socket_, data, sizeof(data), 0);
+    if (size == -1 && errno == EINTR) {
+      continue;
+    }
+    if (size <= 0) {
+      return false;
+    }
+    buffer_.append(data, size);
+  }
+}
+
+void MockServer::showResult() {
+  MSG(info) << "Mock Server";
+  MSG(info) << "  Games        : " << games_;
+  MSG(info) << "  Errors       : " << errors_;
+  MSG(info) << "  Illegal Moves: " << illegalMoves_;
+  MSG(info) << "  Client Moves : " << moves_;
+  if (moves_ != 0) {
+    MSG(info) << "  Latency";
+    MSG(info) << "    Average: " << (latencyTotalUs_ / moves_ / 1000.0) << " msec";
+    MSG(info) << "    Maximum: " << (latencyMaxUs_ / 1000.0) << " msec";
+  }
+  MSG(info) << "";
+}
+
+} // namespace sunfish
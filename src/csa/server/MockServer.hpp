@@ -0,0 +1,125 @@
+/* MockServer.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_CSA_SERVER_MOCKSERVER_HPP__
+#define SUNFISH_CSA_SERVER_MOCKSERVER_HPP__
+
+#include "common/Def.hpp"
+#include "search/RandomSearcher.hpp"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <cstdint>
+
+namespace sunfish {
+
+/**
+ * A minimal stand-in of the CSA server which listens on the loopback
+ * interface to test CsaClient without a real shogi server.
+ * The server plays the random moves against the client,
+ * checks the legality of the moves of the client
+ * and measures the time from sending a move to receiving the reply.
+ */
+class MockServer {
+public:
+
+  static CONSTEXPR_CONST int DefaultByoyomi = 1;
+  static CONSTEXPR_CONST int DefaultMaxMoves = 256;
+
+  MockServer();
+  MockServer(const MockServer&) = delete;
+  MockServer(MockServer&&) = delete;
+
+  ~MockServer();
+
+  /**
+   * Set the port number.
+   * An ephemeral port is used if 0 is specified.
+   */
+  void setPort(int port) {
+    port_ = port;
+  }
+
+  int getPort() const {
+    return port_;
+  }
+
+  void setNumberOfGames(int numberOfGames) {
+    numberOfGames_ = numberOfGames;
+  }
+
+  void setByoyomi(int byoyomi) {
+    byoyomi_ = byoyomi;
+  }
+
+  void setMaxMoves(int maxMoves) {
+    maxMoves_ = maxMoves;
+  }
+
+  /**
+   * Start listening and serve the games on a background thread.
+   */
+  bool start();
+
+  /**
+   * Stop the server and show the results.
+   * The game in progress is interrupted.
+   */
+  void stop();
+
+  /**
+   * Get the number of the illegal moves which the client sent.
+   */
+  unsigned getNumberOfIllegalMoves() const {
+    return illegalMoves_;
+  }
+
+  /**
+   * Get the number of the games which were not played to the end.
+   */
+  unsigned getNumberOfErrors() const {
+    return errors_;
+  }
+
+private:
+
+  using Clock = std::chrono::steady_clock;
+
+  void run();
+
+  bool play(int game);
+
+  bool sendLine(const std::string& line);
+
+  bool receiveLine(std::string& line);
+
+  void showResult();
+
+  int port_;
+  int numberOfGames_;
+  int byoyomi_;
+  int maxMoves_;
+
+  int listenSocket_;
+  std::atomic<int> socket_;
+  std::string buffer_;
+  std::atomic<bool> stop_;
+  std::thread thread_;
+
+  RandomSearcher searcher_;
+
+  unsigned games_;
+  std::atomic<unsigned> illegalMoves_;
+  std::atomic<unsigned> errors_;
+  unsigned moves_;
+  int64_t latencyTotalUs_;
+  int64_t latencyMaxUs_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_CSA_SERVER_MOCKSERVER_HPP__
@@ -8,6 +8,8 @@
 #include "core/util/CoreUtil.hpp"
 #include "search/util/SearchUtil.hpp"
 #include "expt/solve/Solver.hpp"
+#include "expt/analyze/Analyzer.hpp"
+#include "expt/selfplay/SelfPlay.hpp"
 #include "expt/mgtest/MoveGenerationTest.hpp"
 #include "logger/Logger.hpp"
 #include <string>
@@ -22,11 +24,34 @@ int main(int argc, char** argv, char**) {
   // program options
   ProgramOptions po;
   po.addOption("solve", "run a solver", true);
+  po.addOption("analyze", "analyze the records of a directory or a record database", true);
+  po.addOption("selfplay", "play the specified number of games between two engine configurations", true);
   po.addOption("mgtest", "run a cross-check test of move generation");
-  po.addOption("time", "t", "a muximum time of search in seconds (This option will used when the --solve option is specified.)", true);
-  po.addOption("depth", "d", "a muximum depth of search (This option will used when the --solve option is specified.)", true);
-  po.addOption("threads", "r", "a number of search threads (This option will used when the --solve option is specified.)", true);
+  po.addOption("time", "t", "a muximum time of search in seconds (This option will used when the --solve or --analyze option is specified.)", true);
+  po.addOption("depth", "d", "a muximum depth of search (This option will used when the --solve or --analyze option is specified.)", true);
+  po.addOption("threads", "r", "a number of search threads (This option will used when the --solve, --analyze or --selfplay option is specified.)", true);
+  po.addOption("searchers", "a number of independent searchers which run concurrently (This option will used when the --solve or --analyze option is specified.)", true);
+  po.addOption("hash", "a size of TT of each searcher in MiB (This option will used when the --analyze or --selfplay option is specified.)", true);
+  po.addOption("output", "o", "an output file (This option will used when the --analyze option is specified.)", true);
+  po.addOption("tt-load", "a snapshot of TT loaded before the analysis (This option will used when the --analyze option is specified.)", true);
+  po.addOption("tt-save", "a file which TT is saved to after the analysis (This option will used when the --analyze option is specified.)", true);
+  po.addOption("format", "an output format: csv or jsonl (This option will used when the --analyze option is specified.)", true);
+  po.addOption("trace", "write the trace of the search tree to the specified file (This option will used when the --solve option is specified.)", true);
+  po.addOption("trace-capacity", "a maximum number of trace events of each thread in a search (This option will used when the --trace option is specified.)", true);
+  po.addOption("trace-sample", "trace one of the specified number of the subtrees of ply 1 (This option will used when the --trace option is specified.)", true);
   po.addOption("no-interrupt", "ni", "If this option is specified, it is disabled to interrupt. (This option will used when the --solve option is specified.)", false);
+  po.addOption("concurrency", "a number of games played concurrently (This option will used when the --selfplay option is specified.)", true);
+  po.addOption("total-time", "a total time of each player in milliseconds (This option will used when the --selfplay option is specified.)", true);
+  po.addOption("byoyomi", "a byoyomi in milliseconds (This option will used when the --selfplay option is specified.)", true);
+  po.addOption("increment", "an increment in milliseconds (This option will used when the --selfplay option is specified.)", true);
+  po.addOption("max-moves", "a number of moves to finish a game as a draw (This option will used when the --selfplay option is specified.)", true);
+  po.addOption("openings", "a directory or a record database of the openings (This option will used when the --selfplay option is specified.)", true);
+  po.addOption("book", "select the openings from the book (This option will used when the --selfplay option is specified.)");
+  po.addOption("opening-moves", "a number of moves of each opening (This option will used when the --selfplay option is specified.)", true);
+  po.addOption("eval-a", "an evaluation function of the engine A (This option will used when the --selfplay option is specified.)", true);
+  po.addOption("eval-b", "an evaluation function of the engine B (This option will used when the --selfplay option is specified.)", true);
+  po.addOption("threads-a", "a number of search threads of the engine A (This option will used when the --selfplay option is specified.)", true);
+  po.addOption("threads-b", "a number of search threads of the engine B (This option will used when the --selfplay option is specified.)", true);
   po.addOption("help", "h", "show this help");
   po.parse(argc, argv);
 
@@ -70,6 +95,18 @@ int main(int argc, char** argv, char**) {
     if (po.has("no-interrupt")) {
       config.noInterrupt = true;
     }
+    if (po.has("searchers")) {
+      config.numberOfSearchers = std::stoi(po.getValue("searchers"));
+    }
+    if (po.has("trace")) {
+      config.tracePath = po.getValue("trace");
+    }
+    if (po.has("trace-capacity")) {
+      config.traceCapacity = std::stoul(po.getValue("trace-capacity"));
+    }
+    if (po.has("trace-sample")) {
+      config.traceSampleRate = std::stoul(po.getValue("trace-sample"));
+    }
     solver.setConfig(config);
 
     std::string targetDirectory = po.getValue("solve");
@@ -77,6 +114,106 @@ int main(int argc, char** argv, char**) {
     return ok ? 0 : 1;
   }
 
+  // analyzer
+  if (po.has("analyze")) {
+    Analyzer analyzer;
+
+    auto config = analyzer.getConfig();
+    if (po.has("time")) {
+      config.maximumTimeSeconds = std::stoi(po.getValue("time"));
+    }
+    if (po.has("depth")) {
+      config.maximumDepth = std::stoi(po.getValue("depth"));
+    }
+    if (po.has("threads")) {
+      config.numberOfThreads = std::stoi(po.getValue("threads"));
+    }
+    if (po.has("searchers")) {
+      config.numberOfSearchers = std::stoi(po.getValue("searchers"));
+    }
+    if (po.has("hash")) {
+      config.hashMem = std::stoi(po.getValue("hash"));
+    }
+    if (po.has("tt-load")) {
+      config.ttLoadPath = po.getValue("tt-load");
+    }
+    if (po.has("tt-save")) {
+      config.ttSavePath = po.getValue("tt-save");
+    }
+    if (po.has("format")) {
+      std::string format = po.getValue("format");
+      if (format == "csv") {
+        config.format = Analyzer::Format::Csv;
+      } else if (format == "jsonl") {
+        config.format = Analyzer::Format::Jsonl;
+      } else {
+        MSG(error) << "unknown format: " << format;
+        return 1;
+      }
+    }
+    analyzer.setConfig(config);
+
+    std::string outputPath = po.has("output") ? po.getValue("output") : "";
+    bool ok = analyzer.analyze(po.getValue("analyze"), outputPath);
+    return ok ? 0 : 1;
+  }
+
+  // self-play
+  if (po.has("selfplay")) {
+    SelfPlay selfPlay;
+
+    auto config = selfPlay.getConfig();
+    config.numberOfGames = std::stoi(po.getValue("selfplay"));
+    if (po.has("concurrency")) {
+      config.numberOfConcurrentGames = std::stoi(po.getValue("concurrency"));
+    }
+    if (po.has("total-time")) {
+      config.totalTimeMs = std::stoi(po.getValue("total-time"));
+    }
+    if (po.has("byoyomi")) {
+      config.byoyomiMs = std::stoi(po.getValue("byoyomi"));
+    }
+    if (po.has("increment")) {
+      config.incrementMs = std::stoi(po.getValue("increment"));
+    }
+    if (po.has("max-moves")) {
+      config.maxMoves = std::stoi(po.getValue("max-moves"));
+    }
+    if (po.has("openings")) {
+      config.openingPath = po.getValue("openings");
+    }
+    if (po.has("book")) {
+      config.useBook = true;
+    }
+    if (po.has("opening-moves")) {
+      config.openingMoves = std::stoi(po.getValue("opening-moves"));
+    }
+    for (auto& engine : config.engines) {
+      if (po.has("threads")) {
+        engine.numberOfThreads = std::stoi(po.getValue("threads"));
+      }
+      if (po.has("hash")) {
+        engine.hashMem = std::stoi(po.getValue("hash"));
+      }
+    }
+    if (po.has("eval-a")) {
+      config.engines[0].evalPath = po.getValue("eval-a");
+    }
+    if (po.has("eval-b")) {
+      config.engines[1].evalPath = po.getValue("eval-b");
+    }
+    if (po.has("threads-a")) {
+      config.engines[0].numberOfThreads = std::stoi(po.getValue("threads-a"));
+    }
+    if (po.has("threads-b")) {
+      config.engines[1].numberOfThreads = std::stoi(po.getValue("threads-b"));
+    }
+    selfPlay.setConfig(config);
+
+    bool ok = selfPlay.play();
+    return ok ? 0 : 1;
+  }
+
   // move generation test
   if (po.has("mgtest")) {
     MoveGenerationTest mgtest;
@@ -0,0 +1,275 @@
+/* Analyzer.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "expt/analyze/Analyzer.hpp"
+#include "search/eval/Evaluator.hpp"
+#include "common/thread/Parallel.hpp"
+#include "common/time/Timer.hpp"
+#include "logger/Logger.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace sunfish;
+
+const char* const CsvHeader = "game,ply,move,best,score,depth,nodes,elapsed,pv";
+
+std::string quoteCsv(const std::string& str) {
+  std::string quoted = "\"";
+  for (auto c : str) {
+    if (c == '"') {
+      quoted += '"';
+    }
+    quoted += c;
+  }
+  quoted += '"';
+  return quoted;
+}
+
+std::string quoteJson(const std::string& str) {
+  std::string quoted = "\"";
+  for (auto c : str) {
+    switch (c) {
+    case '"' : quoted += "\\\""; break;
+    case '\\': quoted += "\\\\"; break;
+    case '\n': quoted += "\\n"; break;
+    case '\r': quoted += "\\r"; break;
+    case '\t': quoted += "\\t"; break;
+    default  : quoted += c; break;
+    }
+  }
+  quoted += '"';
+  return quoted;
+}
+
+std::string pvToString(const Position& position, const PV& pv) {
+  Position pos = position;
+  std::ostringstream oss;
+  for (unsigned i = 0; i < pv.size(); i++) {
+    Move move = pv.getMove(i);
+    if (i != 0) {
+      oss << ' ';
+    }
+    oss << move.toString(pos);
+
+    Piece captured;
+    if (!pos.doMove(move, captured)) {
+      break;
+    }
+  }
+  return oss.str();
+}
+
+} // namespace
+
+namespace sunfish {
+
+Analyzer::Analyzer() : os_(nullptr) {
+  config_.maximumDepth = 18;
+  config_.maximumTimeSeconds = 1;
+  config_.numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+  config_.numberOfSearchers = 0;
+  config_.hashMem = DefaultHashMem;
+  config_.format = Format::Csv;
+}
+
+bool Analyzer::analyze(const std::string& path,
+                       const std::string& outputPath) {
+  Timer timer;
+  timer.start();
+
+  if (!reader_.open(path)) {
+    return false;
+  }
+
+  std::ofstream fout;
+  if (!outputPath.empty()) {
+    fout.open(outputPath, std::ios::out);
+    if (!fout) {
+      LOG(error) << "could not open a file: " << outputPath;
+      return false;
+    }
+    os_ = &fout;
+  } else {
+    os_ = &std::cout;
+  }
+
+  if (config_.format == Format::Csv) {
+    *os_ << CsvHeader << '\n';
+  }
+
+  // the thread budget is split between the searchers.
+  int numberOfThreads = std::max(config_.numberOfThreads, 1);
+  int numberOfSearchers = config_.numberOfSearchers > 0
+                        ? config_.numberOfSearchers
+                        : numberOfThreads;
+  numberOfSearchers = std::min(numberOfSearchers, numberOfThreads);
+  numberOfSearchers = std::min<int>(numberOfSearchers, reader_.size());
+  numberOfSearchers = std::max(numberOfSearchers, 1);
+  int threadsPerSearcher = std::max(numberOfThreads / numberOfSearchers, 1);
+
+  MSG(info) << "records             : " << reader_.size();
+  MSG(info) << "searchers           : " << numberOfSearchers;
+  MSG(info) << "threads per searcher: " << threadsPerSearcher;
+
+  // the evaluator is loaded only once and shared by all the searchers.
+  evaluator_ = Evaluator::sharedEvaluator();
+
+  std::vector<std::unique_ptr<Searcher>> searchers(numberOfSearchers);
+  for (auto& searcher : searchers) {
+    searcher.reset(new Searcher(evaluator_));
+    searcher->setHandler(this);
+    searcher->ttResizeMB(config_.hashMem);
+    if (!config_.ttLoadPath.empty() && !searcher->ttLoad(config_.ttLoadPath)) {
+      return false;
+    }
+
+    auto config = searcher->getConfig();
+    config.maximumTimeMs = config_.maximumTimeSeconds * 1000;
+    config.optimumTimeMs = SearchConfig::InfinityTime;
+    config.numberOfThreads = threadsPerSearcher;
+    searcher->setConfig(config);
+  }
+
+  next_ = 0;
+  completed_ = 0;
+  positions_ = 0;
+  nodes_ = 0;
+
+  runParallel(numberOfSearchers, [this, &searchers](int part, int) {
+    analyzeOnThread(*searchers[part]);
+  });
+
+  os_->flush();
+  bool ok = !os_->fail();
+  if (!ok) {
+    LOG(error) << "file I/O error: " << outputPath;
+  }
+  os_ = nullptr;
+
+  if (!config_.ttSavePath.empty()) {
+    if (numberOfSearchers > 1) {
+      MSG(warning) << "only TT of the first searcher is saved.";
+    }
+    ok = searchers[0]->ttSave(config_.ttSavePath) && ok;
+  }
+
+  float elapsed = timer.elapsed();
+  MSG(info) << "--------------------- completed ---------------------";
+  MSG(info) << "records  : " << completed_;
+  MSG(info) << "positions: " << positions_;
+  MSG(info) << "elapsed  : " << elapsed;
+  MSG(info) << "nps      : " << static_cast<uint64_t>(nodes_ / elapsed);
+
+  return ok;
+}
+
+void Analyzer::analyzeOnThread(Searcher& searcher) {
+  std::ostringstream oss;
+
+  for (;;) {
+    size_t index = next_++;
+    if (index >= reader_.size()) {
+      break;
+    }
+
+    Record record;
+    if (!reader_.read(index, record)) {
+      LOG(warning) << "skip the record: " << reader_.getName(index);
+      continue;
+    }
+
+    auto name = reader_.getName(index);
+
+    // the rows of a record are written at once
+    // not to interleave them with the other records.
+    oss.str("");
+    analyzeRecord(searcher, name, record, oss);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      *os_ << oss.str();
+    }
+
+    size_t completed = ++completed_;
+    MSG(info) << "[" << completed << "/" << reader_.size() << "] " << name;
+  }
+}
+
+void Analyzer::analyzeRecord(Searcher& searcher,
+                             const std::string& name,
+                             const Record& record,
+                             std::ostream& os) {
+  // each record starts from the snapshot if it is given.
+  if (config_.ttLoadPath.empty()) {
+    searcher.clean();
+  } else {
+    // TT is cleared if the snapshot could not be loaded.
+    searcher.cleanGame();
+    searcher.ttLoad(config_.ttLoadPath);
+  }
+
+  // the moves before the position are given to the searcher
+  // to detect the repetitions.
+  Record history;
+  history.initialPosition = record.initialPosition;
+  Position position = record.initialPosition;
+  int depth = config_.maximumDepth * Searcher::Depth1Ply;
+
+  for (unsigned ply = 0; ply < record.moveList.size(); ply++) {
+    Move move = record.moveList[ply];
+
+    searcher.idsearch(position, depth, &history);
+
+    const auto& result = searcher.getResult();
+    const auto& info = searcher.getInfo();
+    uint64_t nodes = info.nodes + info.quiesNodes;
+    positions_++;
+    nodes_ += nodes;
+
+    auto moveString = move.toString(position);
+    auto bestString = result.move.isNone() ? "%TORYO" : result.move.toString(position);
+    auto pvString = pvToString(position, result.pv);
+
+    if (config_.format == Format::Csv) {
+      os << quoteCsv(name) << ','
+         << (ply + 1) << ','
+         << moveString << ','
+         << bestString << ','
+         << result.score.raw() << ','
+         << (result.depth / Searcher::Depth1Ply) << ','
+         << nodes << ','
+         << std::fixed << std::setprecision(3) << result.elapsed << ','
+         << quoteCsv(pvString) << '\n';
+    } else {
+      os << "{\"game\":" << quoteJson(name)
+         << ",\"ply\":" << (ply + 1)
+         << ",\"move\":" << quoteJson(moveString)
+         << ",\"best\":" << quoteJson(bestString)
+         << ",\"score\":" << result.score.raw()
+         << ",\"depth\":" << (result.depth / Searcher::Depth1Ply)
+         << ",\"nodes\":" << nodes
+         << ",\"elapsed\":" << std::fixed << std::setprecision(3) << result.elapsed
+         << ",\"pv\":" << quoteJson(pvString)
+         << "}\n";
+    }
+
+    Piece captured;
+    if (!position.doMove(move, captured)) {
+      LOG(error) << "an illegal move is detected: " << move.toString(position) << "\n"
+                 << position.toString();
+      return;
+    }
+    history.moveList.push_back(move);
+  }
+}
+
+} // namespace sunfish
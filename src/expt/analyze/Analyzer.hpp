@@ -0,0 +1,123 @@
+/* Analyzer.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_EXPT_ANALYZE_ANALYZER_HPP__
+#define SUNFISH_EXPT_ANALYZE_ANALYZER_HPP__
+
+#include "core/record/Record.hpp"
+#include "core/record/RecordReader.hpp"
+#include "search/Searcher.hpp"
+#include <ostream>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+
+namespace sunfish {
+
+class Evaluator;
+
+/**
+ * Analyze each position of the records and write the results
+ * in CSV or JSON Lines format.
+ * The records are distributed to the independent searchers
+ * which share the evaluator and have their own TTs.
+ */
+class Analyzer : public SearchHandler {
+public:
+
+  enum class Format {
+    Csv,
+    Jsonl,
+  };
+
+  struct Config {
+    int maximumDepth;
+    SearchConfig::TimeType maximumTimeSeconds;
+
+    /**
+     * The number of threads which are split between the searchers.
+     */
+    int numberOfThreads;
+
+    /**
+     * The number of the records analyzed concurrently.
+     */
+    int numberOfSearchers;
+
+    /**
+     * The size of TT of each searcher in MiB.
+     */
+    int hashMem;
+
+    /**
+     * The snapshot of TT which is loaded by each searcher
+     * in place of allocating TT of hashMem.
+     * It is loaded again before each record.
+     */
+    std::string ttLoadPath;
+
+    /**
+     * The file which TT is saved to at the end.
+     * Only TT of the first searcher is saved.
+     */
+    std::string ttSavePath;
+
+    Format format;
+  };
+
+  static CONSTEXPR_CONST int DefaultHashMem = 64;
+
+  Analyzer();
+  Analyzer(const Analyzer&) = delete;
+  Analyzer(Analyzer&&) = delete;
+
+  /**
+   * Analyze the records of a directory, a record database or a CSA file.
+   * The results are written to the standard output
+   * if an empty path is specified.
+   */
+  bool analyze(const std::string& path,
+               const std::string& outputPath);
+
+  const Config& getConfig() const {
+    return config_;
+  }
+
+  void setConfig(const Config& config) {
+    config_ = config;
+  }
+
+  // the progress of each search is not shown.
+  void onStart(const Searcher&) override {}
+  void onUpdatePV(const Searcher&, const PV&, float, int, Score) override {}
+  void onFailLow(const Searcher&, const PV&, float, int, Score) override {}
+  void onFailHigh(const Searcher&, const PV&, float, int, Score) override {}
+  void onIterateEnd(const Searcher&, float, int) override {}
+
+private:
+
+  void analyzeOnThread(Searcher& searcher);
+
+  void analyzeRecord(Searcher& searcher,
+                     const std::string& name,
+                     const Record& record,
+                     std::ostream& os);
+
+  Config config_;
+  std::shared_ptr<Evaluator> evaluator_;
+  RecordReader reader_;
+  std::ostream* os_;
+  std::mutex mutex_;
+  std::atomic<size_t> next_;
+  std::atomic<size_t> completed_;
+  std::atomic<uint64_t> positions_;
+  std::atomic<uint64_t> nodes_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_EXPT_ANALYZE_ANALYZER_HPP__
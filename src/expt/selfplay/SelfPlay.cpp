@@ -0,0 +1,358 @@
+/* SelfPlay.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "expt/selfplay/SelfPlay.hpp"
+#include "search/eval/Evaluator.hpp"
+#include "search/eval/FeatureTemplates.hpp"
+#include "book/Book.hpp"
+#include "book/BinaryBook.hpp"
+#include "book/BookUtil.hpp"
+#include "core/record/RecordReader.hpp"
+#include "common/math/Random.hpp"
+#include "common/thread/Parallel.hpp"
+#include "common/time/Timer.hpp"
+#include "logger/Logger.hpp"
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+using namespace sunfish;
+
+CONSTEXPR_CONST SearchConfig::TimeType MarginMs = 50;
+CONSTEXPR_CONST int RepetitionCount = 4;
+
+const char* const EngineNames[2] = { "A", "B" };
+
+/**
+ * Calculate the time for a move as the CSA client does.
+ */
+void setTime(SearchConfig& config,
+             SearchConfig::TimeType remainingTimeMs,
+             SearchConfig::TimeType byoyomiMs,
+             SearchConfig::TimeType incrementMs) {
+  auto maximumTimeMs = remainingTimeMs + byoyomiMs;
+  config.maximumTimeMs = maximumTimeMs > MarginMs * 2
+                       ? maximumTimeMs - MarginMs
+                       : std::max(maximumTimeMs / 2, 1u);
+  config.optimumTimeMs = std::max(remainingTimeMs / 50,
+                         std::min(remainingTimeMs, byoyomiMs + incrementMs))
+                       + byoyomiMs;
+
+  if (remainingTimeMs == 0 && incrementMs == 0) {
+    config.optimumTimeMs = SearchConfig::InfinityTime;
+  }
+}
+
+/**
+ * Convert a winning rate to the Elo rating difference.
+ */
+double toElo(double rate) {
+  return 400.0 * std::log10(rate / (1.0 - rate));
+}
+
+} // namespace
+
+namespace sunfish {
+
+SelfPlay::SelfPlay() {
+  config_.numberOfGames = 100;
+  config_.numberOfConcurrentGames = 1;
+  config_.totalTimeMs = 0;
+  config_.byoyomiMs = 1000;
+  config_.incrementMs = 0;
+  config_.maxMoves = 256;
+  config_.useBook = false;
+  config_.openingMoves = 16;
+  for (auto& engine : config_.engines) {
+    engine.numberOfThreads = 1;
+    engine.hashMem = DefaultHashMem;
+  }
+}
+
+bool SelfPlay::play() {
+  if (!loadEvaluators() || !generateOpenings()) {
+    return false;
+  }
+
+  int concurrency = std::min(config_.numberOfConcurrentGames,
+                             config_.numberOfGames);
+  concurrency = std::max(concurrency, 1);
+
+  MSG(info) << "games     : " << config_.numberOfGames;
+  MSG(info) << "concurrent: " << concurrency;
+  MSG(info) << "openings  : " << openings_.size();
+  MSG(info) << "time      : " << config_.totalTimeMs << " + "
+                              << config_.byoyomiMs << " (+"
+                              << config_.incrementMs << ") msec";
+  for (int i = 0; i < 2; i++) {
+    const auto& engine = config_.engines[i];
+    MSG(info) << "engine " << EngineNames[i] << "  : "
+              << (engine.evalPath.empty() ? "eval.bin" : engine.evalPath)
+              << ", " << engine.numberOfThreads << " threads, "
+              << engine.hashMem << " MiB";
+  }
+  MSG(info) << "";
+
+  next_ = 0;
+  wins_ = 0;
+  losses_ = 0;
+  draws_ = 0;
+  blackWins_ = 0;
+  memset(stats_, 0, sizeof(stats_));
+
+  runParallel(concurrency, [this](int, int) {
+    playOnThread();
+  });
+
+  showResult();
+
+  return true;
+}
+
+bool SelfPlay::loadEvaluators() {
+  for (int i = 0; i < 2; i++) {
+    const auto& path = config_.engines[i].evalPath;
+    if (path.empty()) {
+      evaluators_[i] = Evaluator::sharedEvaluator();
+      continue;
+    }
+
+    auto fv = std::unique_ptr<Evaluator::FVType>(new Evaluator::FVType);
+    if (!load(path.c_str(), *fv)) {
+      LOG(error) << "could not load the evaluation function: " << path;
+      return false;
+    }
+
+    evaluators_[i] = std::make_shared<Evaluator>(Evaluator::InitType::Zero);
+    optimize(*fv, evaluators_[i]->ofv());
+    evaluators_[i]->onChanged(Evaluator::DataSourceType::Custom);
+  }
+
+  return true;
+}
+
+bool SelfPlay::generateOpenings() {
+  // each opening is played twice with the colors swapped.
+  size_t numberOfOpenings = (config_.numberOfGames + 1) / 2;
+  openings_.clear();
+  openings_.resize(numberOfOpenings);
+
+  for (auto& opening : openings_) {
+    opening.initialPosition.initialize(Position::Handicap::Even);
+  }
+
+  if (!config_.openingPath.empty()) {
+    RecordReader reader;
+    if (!reader.open(config_.openingPath)) {
+      return false;
+    }
+
+    if (reader.size() == 0) {
+      LOG(error) << "no records: " << config_.openingPath;
+      return false;
+    }
+
+    for (size_t i = 0; i < numberOfOpenings; i++) {
+      auto& opening = openings_[i];
+      if (!reader.read(i % reader.size(), opening)) {
+        LOG(error) << "could not read the record: " << reader.getName(i % reader.size());
+        return false;
+      }
+
+      if (opening.moveList.size() > static_cast<size_t>(config_.openingMoves)) {
+        opening.moveList.resize(config_.openingMoves);
+      }
+      opening.specialMove.clear();
+    }
+
+  } else if (config_.useBook) {
+    Book book;
+    BinaryBook binaryBook;
+    if (BinaryBook::exists()) {
+      binaryBook.open();
+    } else {
+      book.load();
+    }
+
+    Random random;
+    for (auto& opening : openings_) {
+      Position position = opening.initialPosition;
+      for (int ply = 0; ply < config_.openingMoves; ply++) {
+        Move move = binaryBook.isOpen()
+            ? BookUtil::select(binaryBook, position, random)
+            : BookUtil::select(book, position, random);
+        Piece captured;
+        if (move.isNone() || !position.doMove(move, captured)) {
+          break;
+        }
+        opening.moveList.push_back(move);
+      }
+    }
+  }
+
+  return true;
+}
+
+void SelfPlay::playOnThread() {
+  // the two searchers are reused through the games of this thread.
+  std::unique_ptr<Searcher> searchers[2];
+  for (int i = 0; i < 2; i++) {
+    searchers[i].reset(new Searcher(evaluators_[i]));
+    searchers[i]->setHandler(this);
+    searchers[i]->ttResizeMB(config_.engines[i].hashMem);
+
+    auto config = searchers[i]->getConfig();
+    config.numberOfThreads = config_.engines[i].numberOfThreads;
+    searchers[i]->setConfig(config);
+  }
+
+  for (;;) {
+    int game = next_++;
+    if (game >= config_.numberOfGames) {
+      break;
+    }
+
+    // the engine A plays black in the even games.
+    int blackEngine = game % 2 == 0 ? 0 : 1;
+    int whiteEngine = blackEngine ^ 1;
+    Searcher* players[2] = { searchers[blackEngine].get(), searchers[whiteEngine].get() };
+    EngineStats stats[2] = { { 0, 0.0 }, { 0, 0.0 } };
+    const char* reason = "";
+
+    players[0]->clean();
+    players[1]->clean();
+    Winner winner = playGame(players, openings_[game / 2], stats, reason);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_[blackEngine].nodes += stats[0].nodes;
+    stats_[blackEngine].elapsed += stats[0].elapsed;
+    stats_[whiteEngine].nodes += stats[1].nodes;
+    stats_[whiteEngine].elapsed += stats[1].elapsed;
+
+    const char* result;
+    if (winner == Winner::Draw) {
+      draws_++;
+      result = "draw";
+    } else if ((winner == Winner::Black) == (blackEngine == 0)) {
+      wins_++;
+      result = "A wins";
+    } else {
+      losses_++;
+      result = "B wins";
+    }
+    if (winner == Winner::Black) {
+      blackWins_++;
+    }
+
+    MSG(info) << "[" << (wins_ + losses_ + draws_) << "/" << config_.numberOfGames << "] "
+              << "game " << (game + 1) << " (black: " << EngineNames[blackEngine] << "): "
+              << result << " by " << reason;
+  }
+}
+
+SelfPlay::Winner SelfPlay::playGame(Searcher* searchers[2],
+                                    const Record& opening,
+                                    EngineStats stats[2],
+                                    const char*& reason) {
+  Record record = opening;
+  Position position = generatePosition(record, -1);
+  SearchConfig::TimeType remainingTimeMs[2] = { config_.totalTimeMs, config_.totalTimeMs };
+
+  std::unordered_map<Zobrist::Type, int> repetitions;
+  repetitions[position.getHash()]++;
+
+  for (;;) {
+    if (record.moveList.size() >= static_cast<size_t>(config_.maxMoves)) {
+      reason = "max moves";
+      return Winner::Draw;
+    }
+
+    int color = position.getTurn() == Turn::Black ? 0 : 1;
+    Winner opponent = color == 0 ? Winner::White : Winner::Black;
+    auto& searcher = *searchers[color];
+
+    auto config = searcher.getConfig();
+    setTime(config, remainingTimeMs[color], config_.byoyomiMs, config_.incrementMs);
+    searcher.setConfig(config);
+
+    Timer timer;
+    timer.start();
+    searcher.idsearch(position, Searcher::DepthInfinity, &record);
+    auto elapsedMs = timer.elapsedMs();
+
+    const auto& result = searcher.getResult();
+    const auto& info = searcher.getInfo();
+    stats[color].nodes += info.nodes + info.quiesNodes;
+    stats[color].elapsed += elapsedMs * 1.0e-3;
+
+    if (result.move.isNone()) {
+      reason = "resign";
+      return opponent;
+    }
+
+    if (elapsedMs > remainingTimeMs[color] + config_.byoyomiMs) {
+      reason = "time up";
+      return opponent;
+    }
+    remainingTimeMs[color] -= std::min(elapsedMs, remainingTimeMs[color]);
+    remainingTimeMs[color] += config_.incrementMs;
+
+    Move move = result.move;
+    Piece captured;
+    if (!position.doMove(move, captured)) {
+      LOG(error) << "an illegal move is detected: " << move.toString(position) << "\n"
+                 << position.toString();
+      reason = "illegal move";
+      return opponent;
+    }
+    record.moveList.push_back(move);
+
+    // the perpetual check is also regarded as a draw.
+    if (++repetitions[position.getHash()] >= RepetitionCount) {
+      reason = "repetition";
+      return Winner::Draw;
+    }
+  }
+}
+
+void SelfPlay::showResult() {
+  unsigned games = wins_ + losses_ + draws_;
+  if (games == 0) {
+    return;
+  }
+
+  double rate = (wins_ + draws_ * 0.5) / games;
+
+  // the standard error of the score per game
+  double variance = (wins_ * (1.0 - rate) * (1.0 - rate)
+                   + draws_ * (0.5 - rate) * (0.5 - rate)
+                   + losses_ * rate * rate) / games;
+  double error = std::sqrt(variance / games);
+  double lower = std::max(rate - 1.96 * error, 1.0e-6);
+  double upper = std::min(rate + 1.96 * error, 1.0 - 1.0e-6);
+
+  MSG(info) << "--------------------- completed ---------------------";
+  MSG(info) << "games     : " << games;
+  MSG(info) << "A-B-draw  : " << wins_ << " - " << losses_ << " - " << draws_;
+  MSG(info) << "black wins: " << blackWins_;
+  MSG(info) << "score of A: " << (rate * 100.0) << "%";
+  if (rate > 0.0 && rate < 1.0) {
+    MSG(info) << "elo of A  : " << toElo(rate)
+              << " (95%: " << toElo(lower) << " - " << toElo(upper) << ")";
+  } else {
+    MSG(info) << "elo of A  : " << (rate > 0.0 ? "+inf" : "-inf");
+  }
+  for (int i = 0; i < 2; i++) {
+    auto nps = stats_[i].elapsed != 0.0
+             ? static_cast<uint64_t>(stats_[i].nodes / stats_[i].elapsed)
+             : 0;
+    MSG(info) << "nps of " << EngineNames[i] << "  : " << nps;
+  }
+}
+
+} // namespace sunfish
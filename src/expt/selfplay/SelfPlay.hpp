@@ -0,0 +1,133 @@
+/* SelfPlay.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_EXPT_SELFPLAY_SELFPLAY_HPP__
+#define SUNFISH_EXPT_SELFPLAY_SELFPLAY_HPP__
+
+#include "core/record/Record.hpp"
+#include "search/Searcher.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+namespace sunfish {
+
+class Evaluator;
+
+/**
+ * Play the games between two engine configurations in-process
+ * to measure the difference of the playing strength.
+ * The games are played concurrently, and each opening is played twice
+ * with the colors swapped.
+ */
+class SelfPlay : public SearchHandler {
+public:
+
+  struct EngineConfig {
+    /**
+     * The path of the evaluation function.
+     * The shared eval.bin is used if it is empty.
+     */
+    std::string evalPath;
+    int numberOfThreads;
+    int hashMem;
+  };
+
+  struct Config {
+    int numberOfGames;
+    int numberOfConcurrentGames;
+
+    /**
+     * The time control shared by both engines.
+     */
+    SearchConfig::TimeType totalTimeMs;
+    SearchConfig::TimeType byoyomiMs;
+    SearchConfig::TimeType incrementMs;
+
+    /**
+     * The game is a draw when it reaches this number of moves.
+     */
+    int maxMoves;
+
+    /**
+     * The openings are taken from the records of this path,
+     * or selected from the book if useBook is true.
+     */
+    std::string openingPath;
+    bool useBook;
+    int openingMoves;
+
+    EngineConfig engines[2];
+  };
+
+  static CONSTEXPR_CONST int DefaultHashMem = 64;
+
+  SelfPlay();
+  SelfPlay(const SelfPlay&) = delete;
+  SelfPlay(SelfPlay&&) = delete;
+
+  bool play();
+
+  const Config& getConfig() const {
+    return config_;
+  }
+
+  void setConfig(const Config& config) {
+    config_ = config;
+  }
+
+  // the progress of each search is not shown.
+  void onStart(const Searcher&) override {}
+  void onUpdatePV(const Searcher&, const PV&, float, int, Score) override {}
+  void onFailLow(const Searcher&, const PV&, float, int, Score) override {}
+  void onFailHigh(const Searcher&, const PV&, float, int, Score) override {}
+  void onIterateEnd(const Searcher&, float, int) override {}
+
+private:
+
+  enum class Winner {
+    Black,
+    White,
+    Draw,
+  };
+
+  struct EngineStats {
+    uint64_t nodes;
+    double elapsed;
+  };
+
+  bool loadEvaluators();
+
+  bool generateOpenings();
+
+  void playOnThread();
+
+  Winner playGame(Searcher* searchers[2],
+                  const Record& opening,
+                  EngineStats stats[2],
+                  const char*& reason);
+
+  void showResult();
+
+  Config config_;
+  std::shared_ptr<Evaluator> evaluators_[2];
+  std::vector<Record> openings_;
+
+  std::atomic<int> next_;
+  std::mutex mutex_;
+  unsigned wins_;
+  unsigned losses_;
+  unsigned draws_;
+  unsigned blackWins_;
+  EngineStats stats_[2];
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_EXPT_SELFPLAY_SELFPLAY_HPP__
@@ -5,97 +5,169 @@
 
 #include "expt/solve/Solver.hpp"
 #include "common/Def.hpp"
-#include "common/file_system/Directory.hpp"
 #include "common/file_system/FileUtil.hpp"
 #include "common/string/StringUtil.hpp"
-#include "core/record/CsaReader.hpp"
+#include "common/thread/Parallel.hpp"
+#include "common/time/Instrument.hpp"
+#include "core/record/RecordReader.hpp"
 #include "logger/Logger.hpp"
 
-#include <fstream>
+#include <atomic>
 #include <cstdlib>
 
+namespace {
+
+using namespace sunfish;
+
+void mergeResult(Solver::Result& dst, const Solver::Result& src) {
+  dst.corrected   += src.corrected;
+  dst.incorrected += src.incorrected;
+  dst.mate        += src.mate;
+  dst.nodes       += src.nodes;
+  dst.elapsed     += src.elapsed;
+  for (int i = 0; i < Solver::MaxDepthOfNodeCount; i++) {
+    dst.nodesEachDepth[i].nodes  += src.nodesEachDepth[i].nodes;
+    dst.nodesEachDepth[i].sample += src.nodesEachDepth[i].sample;
+  }
+}
+
+} // namespace
+
 namespace sunfish {
 
 Solver::Solver() {
-  searcher_.setHandler(this);
   config_.muximumDepth = 18;
   config_.muximumTimeSeconds = 3;
   config_.numberOfThreads = 1;
   config_.noInterrupt = false;
+  config_.numberOfSearchers = 1;
+  config_.traceCapacity = SearchTraceWriter::DefaultCapacity;
+  config_.traceSampleRate = SearchTraceWriter::DefaultSampleRate;
 }
 
 bool Solver::solve(const char* path) {
   memset(&result_, 0, sizeof(Result));
+  Instrument::clear();
 
-  if (FileUtil::isDirectory(path)) {
-    // 'path' points to a directory
-    Directory directory(path);
-    auto files = directory.files("*.csa");
-    int n = 0;
-    for (const auto& path : files) {
-      n++;
-      MSG(info) << "------------------------ [" << n << "] ------------------------";
-      if (!solveCsaFile(path.c_str())) {
-        return false;
-      }
-    }
-
-  } else if (FileUtil::isFile(path)) {
-    // 'path' points to a file
-    if (!solveCsaFile(path)) {
+  if (!config_.tracePath.empty()) {
+    traceWriter_.reset(new SearchTraceWriter());
+    traceWriter_->setCapacity(config_.traceCapacity);
+    traceWriter_->setSampleRate(config_.traceSampleRate);
+    if (!traceWriter_->open(config_.tracePath)) {
       return false;
     }
+  }
 
-  } else {
-    // a specified path is not available.
-    LOG(error) << "not exists: " << path;
+  bool ok = config_.numberOfSearchers > 1
+          ? solveParallel(path)
+          : solveSerial(path);
+
+  if (traceWriter_) {
+    ok = traceWriter_->close() && ok;
+    traceWriter_.reset();
+  }
+
+  if (!ok) {
     return false;
   }
 
-  MSG(info) << "--------------------- completed ---------------------";
+  printSummary();
+  Instrument::print();
 
-  auto percentage = [](float n, float d) {
-    return n / d * 100.0f;
-  };
-  auto total = result_.corrected + result_.incorrected;
-  MSG(info) << "summary:";
-  MSG(info) << "  total     : " << total;
-  MSG(info) << "  correct   : " << result_.corrected
-                              << " (" << percentage(result_.corrected, total) << "%)";
-  MSG(info) << "  incorrect : " << result_.incorrected
-                              << " (" << percentage(result_.incorrected, total) << "%)";
-  MSG(info) << "  nps       : " << static_cast<uint64_t>(result_.nodes / result_.elapsed);
-  for (int i = 0; i < MaxDepthOfNodeCount; i++) {
-    if (result_.nodesEachDepth[i].sample != 0) {
-      MSG(info) << "  nodes " << std::setw(2) << (i+1) << "  : "
-        << (result_.nodesEachDepth[i].nodes / result_.nodesEachDepth[i].sample)
-        << " (" << result_.nodesEachDepth[i].sample << ")";
+  return true;
+}
+
+bool Solver::solveSerial(const char* path) {
+  RecordReader reader;
+  if (!reader.open(path)) {
+    return false;
+  }
+
+  Worker worker(config_, true, traceWriter_.get());
+
+  bool multiple = reader.isDatabase() || FileUtil::isDirectory(path);
+
+  for (size_t n = 0; n < reader.size(); n++) {
+    if (multiple) {
+      MSG(info) << "------------------------ [" << (n+1) << "] ------------------------";
+    }
+
+    MSG(info) << "[" << reader.getName(n) << "]";
+    MSG(info) << "";
+
+    Record record;
+    if (!reader.read(n, record)) {
+      MSG(info) << "";
+      return false;
+    }
+
+    if (!solveRecord(worker, record)) {
+      return false;
     }
   }
 
+  result_ = worker.getResult();
+
   return true;
 }
 
-bool Solver::solveCsaFile(const char* path) {
-  MSG(info) << "[" << path << "]";
+bool Solver::solveParallel(const char* path) {
+  std::vector<Problem> problems;
+  if (!readProblems(path, problems)) {
+    return false;
+  }
+
+  int numberOfSearchers = std::min<int>(config_.numberOfSearchers, problems.size());
+  numberOfSearchers = std::max(numberOfSearchers, 1);
+
+  MSG(info) << "problems : " << problems.size();
+  MSG(info) << "searchers: " << numberOfSearchers;
   MSG(info) << "";
 
-  std::ifstream file(path);
-  if (!file) {
-    LOG(error) << "could not open a file: " << path;
-    MSG(info) << "";
-    return false;
+  std::vector<std::unique_ptr<Worker>> workers(numberOfSearchers);
+  for (auto& worker : workers) {
+    worker.reset(new Worker(config_, false, traceWriter_.get()));
   }
 
-  Record record;
-  CsaReader::read(file, record);
+  std::atomic<size_t> next(0);
+  std::mutex mutex;
+
+  runParallel(numberOfSearchers, [&](int part, int) {
+    auto& worker = *workers[part];
+    for (;;) {
+      size_t index = next++;
+      if (index >= problems.size()) {
+        break;
+      }
+
+      const auto& problem = problems[index];
+      worker.solve(problem.position, problem.correct);
+
+      // the result of each position is shown at once
+      // not to interleave it with the others.
+      std::lock_guard<std::mutex> lock(mutex);
+      MSG(info) << "------------------------ [" << (index+1) << "] ------------------------";
+      MSG(info) << "[" << problem.name << "]";
+      MSG(info) << "";
+      MSG(info) << StringUtil::chomp(problem.position.toString());
+      worker.printResult(problem.position, problem.correct);
+    }
+  });
+
+  for (const auto& worker : workers) {
+    mergeResult(result_, worker->getResult());
+  }
 
-  file.close();
+  return true;
+}
 
+bool Solver::solveRecord(Worker& worker, const Record& record) {
   Position position = record.initialPosition;
 
   for (const auto& move : record.moveList) {
-    solve(position, move);
+    MSG(info) << StringUtil::chomp(position.toString());
+    worker.solve(position, move);
+    worker.printResult(position, move);
 
     Piece captured;
     if (!position.doMove(move, captured)) {
@@ -109,9 +181,70 @@ bool Solver::solveCsaFile(const char* path) {
   return true;
 }
 
-bool Solver::solve(const Position& position, Move correct) {
-  MSG(info) << StringUtil::chomp(position.toString());
+bool Solver::readProblems(const char* path, std::vector<Problem>& problems) {
+  RecordReader reader;
+  if (!reader.open(path)) {
+    return false;
+  }
+
+  for (size_t n = 0; n < reader.size(); n++) {
+    Record record;
+    if (!reader.read(n, record)) {
+      LOG(error) << "could not read the record: " << reader.getName(n);
+      return false;
+    }
+
+    Position position = record.initialPosition;
+
+    for (const auto& move : record.moveList) {
+      problems.push_back({ reader.getName(n), position, move });
+
+      Piece captured;
+      if (!position.doMove(move, captured)) {
+        LOG(error) << "an illegal move is detected: " << move.toString(position) << "\n"
+                   << position.toString();
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void Solver::printSummary() {
+  MSG(info) << "--------------------- completed ---------------------";
+
+  auto percentage = [](float n, float d) {
+    return n / d * 100.0f;
+  };
+  auto total = result_.corrected + result_.incorrected;
+  MSG(info) << "summary:";
+  MSG(info) << "  total     : " << total;
+  MSG(info) << "  correct   : " << result_.corrected
+                              << " (" << percentage(result_.corrected, total) << "%)";
+  MSG(info) << "  incorrect : " << result_.incorrected
+                              << " (" << percentage(result_.incorrected, total) << "%)";
+  MSG(info) << "  nps       : " << static_cast<uint64_t>(result_.nodes / result_.elapsed);
+  for (int i = 0; i < MaxDepthOfNodeCount; i++) {
+    if (result_.nodesEachDepth[i].sample != 0) {
+      MSG(info) << "  nodes " << std::setw(2) << (i+1) << "  : "
+        << (result_.nodesEachDepth[i].nodes / result_.nodesEachDepth[i].sample)
+        << " (" << result_.nodesEachDepth[i].sample << ")";
+    }
+  }
+}
+
+Solver::Worker::Worker(const Config& config,
+                       bool verbose,
+                       SearchTraceWriter* traceWriter) :
+    config_(config),
+    verbose_(verbose) {
+  searcher_.setHandler(this);
+  searcher_.setTraceWriter(traceWriter);
+  memset(&result_, 0, sizeof(Result));
+}
 
+void Solver::Worker::solve(const Position& position, Move correct) {
   auto config = searcher_.getConfig();
   config.maximumTimeMs = config_.muximumTimeSeconds * 1000;
   config.optimumTimeMs = SearchConfig::InfinityTime;
@@ -140,6 +273,12 @@ bool Solver::solve(const Position& position, Move correct) {
     result_.nodes += info.nodes + info.quiesNodes;
     result_.elapsed += result.elapsed;
   }
+}
+
+void Solver::Worker::printResult(const Position& position, Move correct) {
+  auto& result = searcher_.getResult();
+  auto& info = searcher_.getInfo();
+  bool isCorrect = result.move == correct;
 
   printSearchInfo(MSG(info), info, result.elapsed);
   MSG(info) << "";
@@ -147,12 +286,12 @@ bool Solver::solve(const Position& position, Move correct) {
   MSG(info) << "correct: " << correct.toString(position);
   MSG(info) << "result : " << (isCorrect ? "correct" : "incorrect");
   MSG(info) << "";
-
-  return true;
 }
 
-void Solver::onUpdatePV(const Searcher& searcher, const PV& pv, float elapsed, int depth, Score score) {
-  LoggingSearchHandler::onUpdatePV(searcher, pv, elapsed, depth, score);
+void Solver::Worker::onUpdatePV(const Searcher& searcher, const PV& pv, float elapsed, int depth, Score score) {
+  if (verbose_) {
+    LoggingSearchHandler::onUpdatePV(searcher, pv, elapsed, depth, score);
+  }
   if (!config_.noInterrupt &&
       depth >= 5 &&
       pv.size() >= 1 &&
@@ -161,7 +300,23 @@ void Solver::onUpdatePV(const Searcher& searcher, const PV& pv, float elapsed, i
   }
 }
 
-void Solver::onIterateEnd(const Searcher& searcher, float elapsed, int depth) {
+void Solver::Worker::onFailLow(const Searcher& searcher, const PV& pv, float elapsed, int depth, Score score) {
+  if (verbose_) {
+    LoggingSearchHandler::onFailLow(searcher, pv, elapsed, depth, score);
+  } else {
+    onUpdatePV(searcher, pv, elapsed, depth, score);
+  }
+}
+
+void Solver::Worker::onFailHigh(const Searcher& searcher, const PV& pv, float elapsed, int depth, Score score) {
+  if (verbose_) {
+    LoggingSearchHandler::onFailHigh(searcher, pv, elapsed, depth, score);
+  } else {
+    onUpdatePV(searcher, pv, elapsed, depth, score);
+  }
+}
+
+void Solver::Worker::onIterateEnd(const Searcher& searcher, float elapsed, int depth) {
   LoggingSearchHandler::onIterateEnd(searcher, elapsed, depth);
   auto& info = searcher.getInfo();
   auto realDepth = depth / Searcher::Depth1Ply;
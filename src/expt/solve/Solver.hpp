@@ -8,13 +8,17 @@
 
 #include "core/position/Position.hpp"
 #include "core/move/Move.hpp"
+#include "core/record/Record.hpp"
 #include "search/Searcher.hpp"
 #include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
 #include <cstdint>
 
 namespace sunfish {
 
-class Solver : LoggingSearchHandler {
+class Solver {
 public:
 
   struct Config {
@@ -22,6 +26,21 @@ public:
     SearchConfig::TimeType muximumTimeSeconds;
     int numberOfThreads;
     bool noInterrupt;
+
+    /**
+     * The number of the positions solved concurrently.
+     * Each of them is searched by an independent Searcher
+     * with its own TT and `numberOfThreads' threads.
+     */
+    int numberOfSearchers;
+
+    /**
+     * The file of the search trace.
+     * The trace is disabled if it is empty.
+     */
+    std::string tracePath;
+    size_t traceCapacity;
+    unsigned traceSampleRate;
   };
 
   struct Nodes {
@@ -56,22 +75,64 @@ public:
     config_ = config;
   }
 
-  void onUpdatePV(const Searcher& searcher, const PV& pv, float elapsed, int depth, Score score) override;
+private:
 
-  void onIterateEnd(const Searcher& searcher, float elapsed, int depth) override;
+  struct Problem {
+    std::string name;
+    Position position;
+    Move correct;
+  };
 
-private:
+  /**
+   * A searcher and the result of the positions which it solved.
+   * The progress of the search is logged only if `verbose' is true.
+   */
+  class Worker : public LoggingSearchHandler {
+  public:
+
+    Worker(const Config& config, bool verbose, SearchTraceWriter* traceWriter);
+
+    void solve(const Position& position, Move correct);
+
+    void printResult(const Position& position, Move correct);
+
+    const Result& getResult() const {
+      return result_;
+    }
+
+    void onUpdatePV(const Searcher& searcher, const PV& pv, float elapsed, int depth, Score score) override;
+
+    void onFailLow(const Searcher& searcher, const PV& pv, float elapsed, int depth, Score score) override;
+
+    void onFailHigh(const Searcher& searcher, const PV& pv, float elapsed, int depth, Score score) override;
+
+    void onIterateEnd(const Searcher& searcher, float elapsed, int depth) override;
+
+  private:
+
+    const Config& config_;
+    bool verbose_;
+    Searcher searcher_;
+    Result result_;
+    Move correct_;
+
+  };
+
+  bool solveSerial(const char* path);
+
+  bool solveParallel(const char* path);
+
+  bool solveRecord(Worker& worker, const Record& record);
 
-  bool solveCsaFile(const char* path);
+  bool readProblems(const char* path, std::vector<Problem>& problems);
 
-  bool solve(const Position& position, Move correct);
+  void printSummary();
 
 private:
 
-  Searcher searcher_;
   Config config_;
   Result result_;
-  Move correct_;
+  std::unique_ptr<SearchTraceWriter> traceWriter_;
 
 };
 
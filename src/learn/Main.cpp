@@ -6,9 +6,11 @@
 #include "common/console/Console.hpp"
 #include "common/program_options/ProgramOptions.hpp"
 #include "common/resource/Resource.hpp"
+#include "common/string/StringUtil.hpp"
 #include "core/util/CoreUtil.hpp"
 #include "search/util/SearchUtil.hpp"
 #include "learn/batch/BatchLearning.hpp"
+#include "learn/online/OnlineLearning.hpp"
 #include "logger/Logger.hpp"
 #include <iostream>
 #include <fstream>
@@ -30,6 +32,9 @@ int main(int argc, char** argv, char**) {
 
   // program options
   ProgramOptions po;
+  po.addOption("online", "o", "mini-batch online learning");
+  po.addOption("shard", "run as a worker process of the sharded batch learning", true);
+  po.addOption("coordinator", "the pid of the coordinator of the sharded batch learning (--shard)", true);
   po.addOption("silent", "s", "silent mode");
   po.addOption("help", "h", "show this help");
   po.parse(argc, argv);
@@ -67,8 +72,18 @@ int main(int argc, char** argv, char**) {
     MSG(warning) << "WARNING: "  << invalidArgument.reason << ": `" << invalidArgument.arg << "'";
   }
 
-  BatchLearning batch;
-  bool ok = batch.run();
+  bool ok;
+  if (po.has("shard")) {
+    BatchLearning batch;
+    ok = batch.runShard(StringUtil::toInt(po.getValue("shard"), -1),
+                        StringUtil::toInt(po.getValue("coordinator"), -1));
+  } else if (po.has("online")) {
+    OnlineLearning online;
+    ok = online.run();
+  } else {
+    BatchLearning batch;
+    ok = batch.run();
+  }
 
   return ok ? 0 : 1;
 }
@@ -4,20 +4,18 @@
  */
 
 #include "learn/batch/BatchLearning.hpp"
+#include "learn/batch/TrainingDataGenerator.hpp"
+#include "learn/batch/Shard.hpp"
 #include "search/eval/FeatureTemplates.hpp"
 #include "search/eval/Material.hpp"
-#include "search/Searcher.hpp"
-#include "core/move/MoveGenerator.hpp"
-#include "core/record/CsaReader.hpp"
-#include "common/file_system/Directory.hpp"
+#include "common/process/ChildProcess.hpp"
 #include "common/resource/Resource.hpp"
 #include "common/string/TablePrinter.hpp"
 #include "common/string/StringUtil.hpp"
+#include "common/thread/Parallel.hpp"
 #include "logger/Logger.hpp"
 #include <atomic>
-#include <sstream>
-#include <utility>
-#include <mutex>
+#include <chrono>
 #include <cmath>
 
 #define DEBUG_PRINT 0
@@ -32,39 +30,17 @@ CONSTEXPR_CONST float DefaultNorm = 1.0e-2f;
 CONSTEXPR_CONST int MaximumUpdateCount = 32;
 CONSTEXPR_CONST int MinimumUpdateCount = 8;
 
-CONSTEXPR_CONST int16_t Int16Max = 32767;
-CONSTEXPR_CONST int16_t Int16Min = -32768;
-
-std::string trainingDataPath(unsigned tn) {
-  std::ostringstream oss;
-  oss << "out/training" << tn << ".dat";
-  return oss.str();
-}
-
-CONSTEXPR_CONST int SearchWindow =  256;
-
-inline float gain() {
-  return 7.0f / SearchWindow;
-}
-
-inline float sigmoid(float x) {
-  if (x <= -SearchWindow) { return 0.0f; }
-  if (x >=  SearchWindow) { return 1.0f; }
-  return 1.0 / (1.0 + std::exp(x * -gain()));
-}
+CONSTEXPR_CONST size_t UpdateBlockSize = 64 * 1024;
 
-inline float dsigmoid(float x) {
-  float s = sigmoid(x);
-  return (s - s * s) * gain();
-}
+/**
+ * The number of times a worker process is restarted in an iteration.
+ */
+CONSTEXPR_CONST int MaximumWorkerRestarts = 3;
 
-inline float loss(float x) {
-  return sigmoid(x);
-}
+CONSTEXPR_CONST int ShardPollingIntervalMs = 10;
 
-inline float gradient(float x) {
-  return dsigmoid(x);
-}
+CONSTEXPR_CONST int16_t Int16Max = 32767;
+CONSTEXPR_CONST int16_t Int16Min = -32768;
 
 inline float norm(int16_t x, float n) {
   if      (x > 0) { return -n; }
@@ -76,42 +52,12 @@ inline float norm(int16_t x, float n) {
 
 namespace sunfish {
 
-class RecordQueue {
-public:
-
-  using QueueType = Directory::Files;
-
-  template <class T>
-  RecordQueue(T&& files) : files_(std::forward<T>(files)) {
-    iterator_ = files_.begin();
-  }
-
-  RecordQueue() = delete;
-  RecordQueue(const RecordQueue&) = delete;
-  RecordQueue(RecordQueue&&) = delete;
-
-  bool pop(const std::string** path) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (iterator_ == files_.end()) {
-      return false;
-    }
-    *path = &(*iterator_);
-    iterator_++;
-    return true;
-  }
-
-private:
-
-  QueueType files_;
-  QueueType::iterator iterator_;
-  std::mutex mutex_;
-
-};
-
 BatchLearning::BatchLearning() :
     evaluator_(std::make_shared<Evaluator>(Evaluator::InitType::Zero)),
     fv_(new Evaluator::FVType),
-    gradient_(new Gradient) {
+    gradient_(new Gradient),
+    pass_(0),
+    generation_(0) {
 }
 
 bool BatchLearning::run() {
@@ -126,7 +72,17 @@ bool BatchLearning::run() {
     return false;
   }
 
+  if (config_.numShards != 0 && !startWorkers()) {
+    stopWorkers();
+    return false;
+  }
+
   bool ok = iterate();
+
+  if (config_.numShards != 0) {
+    stopWorkers();
+  }
+
   if (!ok) {
     return false;
   }
@@ -148,6 +104,9 @@ void BatchLearning::readConfigFromIniFile() {
   config_.numThreads        = StringUtil::toInt(getValue(ini, "Learn", "NumThreads"), std::thread::hardware_concurrency());
   config_.depth             = StringUtil::toInt(getValue(ini, "Learn", "Depth"), DefaultDepth);
   config_.norm              = StringUtil::toFloat(getValue(ini, "Learn", "Norm"), DefaultNorm);
+  config_.compressTrainingData = StringUtil::toInt(getValue(ini, "Learn", "CompressTrainingData"), 0);
+  config_.numShards         = StringUtil::toInt(getValue(ini, "Learn", "NumShards"), 0);
+  config_.workerCommand     = getValue(ini, "Learn", "WorkerCommand");
 
   MSG(info) << "KifuDir         : " << config_.kifuDir;
   MSG(info) << "Iteration       : " << config_.iteration;
@@ -156,6 +115,9 @@ void BatchLearning::readConfigFromIniFile() {
   MSG(info) << "NumThreads      : " << config_.numThreads;
   MSG(info) << "Depth           : " << config_.depth;
   MSG(info) << "Norm            : " << config_.norm;
+  MSG(info) << "CompressTrainingData: " << config_.compressTrainingData;
+  MSG(info) << "NumShards       : " << config_.numShards;
+  MSG(info) << "WorkerCommand   : " << config_.workerCommand;
 }
 
 bool BatchLearning::validateConfig() {
@@ -164,6 +126,11 @@ bool BatchLearning::validateConfig() {
     return false;
   }
 
+  if (config_.numShards < 0) {
+    LOG(error) << "NumShards shall not be less than 0.";
+    return false;
+  }
+
   return true;
 }
 
@@ -190,6 +157,8 @@ bool BatchLearning::iterate() {
 
       MSG(info) << "adjusting parameters..";
 
+      memset(reinterpret_cast<void*>(&phaseTimes_), 0, sizeof(phaseTimes_));
+
       float lossFirst = 0.0f;
       float lossLast = 0.0f;
       for (int uc = 0; uc < updateCount; uc++) {
@@ -214,7 +183,10 @@ bool BatchLearning::iterate() {
       save(*fv_);
 
       MSG(info) << "";
-      MSG(info) << "loss = " << lossFirst << " - " << lossLast;
+      MSG(info) << "loss = " << lossFirst << " - " << lossLast
+                << " (elapsed=" << timer_.elapsed() << ")";
+
+      printPhaseTimes();
 
       printParametersSummary();
     }
@@ -225,375 +197,533 @@ bool BatchLearning::iterate() {
 }
 
 bool BatchLearning::generateTrainingData() {
-  Directory directory(config_.kifuDir.c_str());
-  auto files = directory.files("*.csa");
+  TrainingDataGenerator::Config config;
+  config.kifuDir = config_.kifuDir;
+  config.numThreads = config_.numThreads;
+  config.depth = config_.depth;
+  config.compress = config_.compressTrainingData;
+
+  TrainingDataGenerator generator(evaluator_, config);
+  if (!generator.generate()) {
+    return false;
+  }
+
+  leafCaches_.clear();
+  generation_++;
+  std::fill(workerRestarts_.begin(), workerRestarts_.end(), 0);
 
-  if (files.size() == 0) {
-    LOG(error) << ".csa files not found";
+  failLoss_ = generator.getFailLoss();
+  numberOfData_ = generator.getNumberOfData();
+
+  return true;
+}
+
+bool BatchLearning::generateGradient() {
+  auto og = std::unique_ptr<OptimizedGradient>(new OptimizedGradient);
+  memset(reinterpret_cast<void*>(og.get()), 0, sizeof(OptimizedGradient));
+  memset(reinterpret_cast<void*>(mgradient_), 0, sizeof(MaterialGradient));
+  loss_ = 0.0f;
+
+  bool ok = config_.numShards != 0
+          ? collectShardGradients(*og)
+          : generateGradient(*og, 0, 1);
+  if (!ok) {
     return false;
   }
+  loss_ += failLoss_;
 
-  RecordQueue recordQueue(std::move(files));
-  std::vector<GenTrDataThread> threads(config_.numThreads);
+  Timer phaseTimer;
+  phaseTimer.start();
+  runParallel(config_.numThreads, [this, &og](int part, int parts) {
+    expand(*gradient_, *og, part, parts);
+  });
+  phaseTimes_.expand += phaseTimer.elapsed();
 
-  for (unsigned tn = 0; tn < threads.size(); tn++) {
-    auto& th = threads[tn];
+  phaseTimer.start();
+  runParallel(config_.numThreads, [this](int part, int parts) {
+    symmetrize(*gradient_, [](float& g1, float& g2) {
+      g1 = g2 = g1 + g2;
+    }, part, parts);
+  });
+  phaseTimes_.symmetrize += phaseTimer.elapsed();
+
+  return true;
+}
+
+bool BatchLearning::generateGradient(OptimizedGradient& og,
+                                     int shard,
+                                     int shards) {
+  Timer timer;
+  timer.start();
+
+  std::vector<GenGradThread> threads(config_.numThreads);
 
-    auto path = trainingDataPath(tn);
-    th.os.open(path, std::ios::out | std::ios::binary);
-    if (!th.os) {
-      LOG(error) << "could not open a file: " << path;
+  bool cached = !leafCaches_.empty();
+  if (!cached) {
+    if (!assignTrainingData(threads, shard, shards)) {
       return false;
     }
+    leafCaches_.resize(config_.numThreads);
+  }
+
+  for (unsigned tn = 0; tn < threads.size(); tn++) {
+    auto& th = threads[tn];
 
-    th.recordQueue = &recordQueue;
-    th.searcher.reset(new Searcher(evaluator_));
-    th.failLoss = 0;
-    th.numberOfData = 0;
+    th.leafCache = &leafCaches_[tn];
+    memset(reinterpret_cast<void*>(&th.mg), 0, sizeof(th.mg));
+    th.loss = 0.0f;
   }
 
   for (unsigned tn = 0; tn < threads.size(); tn++) {
     auto& th = threads[tn];
-    th.thread = std::thread([this, &th]() {
-      generateTrainingData(th);
+    th.thread = std::thread([this, &th, cached]() {
+      th.ok = cached || readTrainingData(th);
+      if (th.ok) {
+        generateGradient(th);
+      }
     });
   }
 
+  bool ok = true;
   for (auto& th : threads) {
     if (th.thread.joinable()) {
       th.thread.join();
     }
+    ok = ok && th.ok;
   }
 
-  failLoss_ = 0;
-  numberOfData_ = 0;
+  if (!ok) {
+    // the partial leaf caches must not be reused.
+    leafCaches_.clear();
+    return false;
+  }
+
+  if (!cached) {
+    size_t size = 0;
+    for (const auto& leafCache : leafCaches_) {
+      size += leafCache.positions.size() * sizeof(MutablePosition);
+      size += leafCache.records.size() * sizeof(LeafRecord);
+    }
+    MSG(info) << "leaf cache: " << (size / 1024 / 1024) << "MB";
+  }
+
+  size_t numberOfBlocks = 0;
+  for (const auto& th : threads) {
+    numberOfBlocks += th.bg.numberOfBlocks();
+  }
+  size_t memorySize = numberOfBlocks * sizeof(GradientBlock)
+                    + sizeof(OptimizedGradient);
+
   for (auto& th : threads) {
-    failLoss_ += th.failLoss;
-    numberOfData_ += th.numberOfData;
+    loss_ += th.loss;
+    madd(mgradient_, th.mg);
   }
+  float gradientTime = timer.elapsed();
+  phaseTimes_.gradient += gradientTime;
+
+  Timer phaseTimer;
+  phaseTimer.start();
+  reduceGradient(threads, og);
+  threads.clear();
+  phaseTimes_.reduce += phaseTimer.elapsed();
+
+  MSG(info) << "gradient: blocks=" << numberOfBlocks
+            << " memory=" << (memorySize / 1024 / 1024) << "MB"
+            << " elapsed=" << gradientTime;
 
   return true;
 }
 
-void BatchLearning::generateTrainingData(GenTrDataThread& th) {
-  for (;;) {
-    const std::string* path;
-    if (!th.recordQueue->pop(&path)) {
-      break;
-    }
-    generateTrainingData(th, *path);
-  }
-}
+bool BatchLearning::collectShardGradients(OptimizedGradient& og) {
+  Timer timer;
+  timer.start();
 
-void BatchLearning::generateTrainingData(GenTrDataThread& th,
-                                         const std::string& path) {
-  std::ifstream file(path);
-  if (!file) {
-    LOG(error) << "could not open a file: " << path;
-    return;
+  pass_++;
+
+  ShardParamsHeader header;
+  header.stop = 0;
+  header.pass = pass_;
+  header.generation = generation_;
+  if (!writeShardParams(header, *fv_)) {
+    return false;
   }
-  Record record;
-  CsaReader::read(file, record);
-  file.close();
 
-  th.searcher->clean();
+  std::vector<std::unique_ptr<ShardGradientFile>> files(config_.numShards);
+  int remaining = config_.numShards;
+  while (remaining != 0) {
+    for (int shard = 0; shard < config_.numShards; shard++) {
+      if (files[shard]) {
+        continue;
+      }
 
-  Position pos = record.initialPosition;
-  for (const auto& move : record.moveList) {
-    generateTrainingData(th, pos, move);
+      std::unique_ptr<ShardGradientFile> file(new ShardGradientFile);
+      if (file->open(shard) && file->header().pass == pass_) {
+        files[shard] = std::move(file);
+        remaining--;
+        continue;
+      }
 
-    Piece captured;
-    if (!pos.doMove(move, captured)) {
-      LOG(error) << "an illegal move is detected: " << move.toString(pos) << "\n"
-                 << pos.toString();
-      return;
+      // The worker restarted reads the parameters of this pass
+      // and rebuilds its leaf cache.
+      auto& worker = *workers_[shard];
+      if (!worker.isRunning()) {
+        if (workerRestarts_[shard] >= MaximumWorkerRestarts) {
+          LOG(error) << "the worker " << shard << " failed too many times";
+          return false;
+        }
+        workerRestarts_[shard]++;
+        LOG(warning) << "the worker " << shard << " exited with status "
+                     << worker.getExitStatus() << ", restarting..";
+        if (!startWorker(shard)) {
+          return false;
+        }
+      }
     }
+
+    if (remaining != 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(ShardPollingIntervalMs));
+    }
+  }
+
+  for (const auto& file : files) {
+    loss_ += file->header().loss;
+    madd(mgradient_, file->header().mg);
   }
+  float gradientTime = timer.elapsed();
+  phaseTimes_.gradient += gradientTime;
+
+  // Each king square is reduced by only one thread,
+  // and the shards are added in order.
+  Timer phaseTimer;
+  phaseTimer.start();
+  runParallel(config_.numThreads, [&files, &og](int part, int parts) {
+    for (int king = part; king < Square::N; king += parts) {
+      for (const auto& file : files) {
+        addRows(og, king, file->gradient());
+      }
+    }
+  });
+  for (auto& file : files) {
+    file->remove();
+  }
+  phaseTimes_.reduce += phaseTimer.elapsed();
+
+  MSG(info) << "gradient: shards=" << config_.numShards
+            << " elapsed=" << gradientTime;
+
+  return true;
 }
 
-void BatchLearning::generateTrainingData(GenTrDataThread& th,
-                                         Position& pos,
-                                         Move bestMove) {
-  int depth = Searcher::Depth1Ply * config_.depth + Searcher::Depth1Ply / 2;
-  Score alpha;
-  Score beta;
-  struct Data {
-    Move move;
-    PV pv;
-  };
-  std::vector<Data> results;
+bool BatchLearning::startWorkers() {
+  removeShardFiles(config_.numShards);
 
-  {
-    int newDepth = depth;
-    if (pos.isCheck(bestMove)){
-      newDepth += Searcher::Depth1Ply;
+  workers_.clear();
+  workerRestarts_.assign(config_.numShards, 0);
+  for (int shard = 0; shard < config_.numShards; shard++) {
+    workers_.emplace_back(new ChildProcess);
+    if (!startWorker(shard)) {
+      return false;
     }
+  }
+  return true;
+}
 
-    Piece captured;
-    if (!pos.doMove(bestMove, captured)) {
-      LOG(error) << "an illegal move is detected: " << bestMove.toString(pos) << "\n"
-                 << pos.toString();
-      return;
+bool BatchLearning::startWorker(int shard) {
+  std::vector<std::string> args;
+  for (const auto& arg : StringUtil::split(config_.workerCommand, ' ')) {
+    if (!arg.empty()) {
+      args.push_back(arg);
     }
+  }
+  args.push_back(ChildProcess::executablePath());
+  args.push_back("--shard");
+  args.push_back(std::to_string(shard));
+  args.push_back("--coordinator");
+  args.push_back(std::to_string(ChildProcess::currentPid()));
+
+  if (!workers_[shard]->start(args)) {
+    return false;
+  }
 
-    th.searcher->search(pos,
-                        newDepth,
-                        -Score::mate(),
-                        Score::mate());
-    auto& result = th.searcher->getResult();
+  MSG(info) << "the worker " << shard << " started: pid=" << workers_[shard]->getPid();
+  return true;
+}
 
-    pos.undoMove(bestMove, captured);
+void BatchLearning::stopWorkers() {
+  ShardParamsHeader header;
+  header.stop = 1;
+  header.pass = ++pass_;
+  header.generation = generation_;
+  writeShardParams(header, *fv_);
 
-    if (result.score >= Score::mate() ||
-        result.score <= -Score::mate()) {
-      return;
-    }
-    alpha = -result.score - SearchWindow;
-    beta = -result.score + SearchWindow;
-    results.push_back({ bestMove, result.pv });
+  for (auto& worker : workers_) {
+    worker->wait();
+  }
+  workers_.clear();
+}
+
+bool BatchLearning::runShard(int shard, int coordinator) {
+  readConfigFromIniFile();
+  if (!validateConfig()) {
+    return false;
   }
 
-  Moves moves;
-  auto cs = pos.getCheckState();
-  if (!isCheck(cs)) {
-    MoveGenerator::generateCaptures(pos, moves);
-    MoveGenerator::generateQuiets(pos, moves);
-  } else {
-    MoveGenerator::generateEvasions(pos, cs, moves);
+  if (shard < 0 || shard >= config_.numShards) {
+    LOG(error) << "invalid shard number: " << shard;
+    return false;
   }
 
-  for (auto& move : moves) {
-    if (move == bestMove) {
+  if (coordinator <= 0) {
+    LOG(error) << "invalid pid of the coordinator: " << coordinator;
+    return false;
+  }
+
+  int64_t lastPass = 0;
+  int64_t generation = 0;
+  for (;;) {
+    if (!ChildProcess::exists(coordinator)) {
+      LOG(error) << "the coordinator has exited";
+      return false;
+    }
+
+    ShardParamsHeader header;
+    if (!readShardParamsHeader(header) || header.pass <= lastPass) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(ShardPollingIntervalMs));
       continue;
     }
 
-    int newDepth = depth;
-    if (pos.isCheck(move)){
-      newDepth += Searcher::Depth1Ply;
+    if (header.stop) {
+      return true;
     }
 
-    Piece captured;
-    if (!pos.doMove(move, captured)) {
-      continue;
+    if (!readShardParams(header, *fv_)) {
+      return false;
     }
-    th.searcher->search(pos,
-                        newDepth,
-                        -beta,
-                        -alpha);
-    pos.undoMove(move, captured);
+    runParallel(config_.numThreads, [this](int part, int parts) {
+      optimize(*fv_, evaluator_->ofv(), part, parts);
+    });
+    evaluator_->onChanged(Evaluator::DataSourceType::Custom);
 
-    auto& result = th.searcher->getResult();
+    // The training data is regenerated on each iteration.
+    if (header.generation != generation) {
+      leafCaches_.clear();
+      generation = header.generation;
+    }
 
-    // fail-low
-    if (-result.score <= alpha) {
-      continue;
+    ShardGradientFile file;
+    if (!file.create(shard)) {
+      return false;
     }
 
-    // fail-high
-    if (-result.score >= beta) {
-      th.failLoss++;
-      continue;
+    memset(reinterpret_cast<void*>(mgradient_), 0, sizeof(MaterialGradient));
+    loss_ = 0.0f;
+    if (!generateGradient(file.gradient(), shard, config_.numShards)) {
+      return false;
     }
 
-    results.push_back({ move, result.pv });
-  }
+    file.header().pass = header.pass;
+    file.header().loss = loss_;
+    memcpy(file.header().mg, mgradient_, sizeof(MaterialGradient));
+    if (!file.commit()) {
+      return false;
+    }
 
-  th.numberOfData++;
+    lastPass = header.pass;
+  }
+}
 
-  if (results.size() == 1) {
-    return;
+void BatchLearning::reduceGradient(std::vector<GenGradThread>& threads,
+                                   OptimizedGradient& og) {
+  // Each king square is reduced by only one thread,
+  // and the blocks are added in the order of the threads.
+  std::vector<std::thread> reducers;
+  for (unsigned rn = 0; rn < threads.size(); rn++) {
+    reducers.emplace_back([&threads, &og, rn]() {
+      for (int king = rn; king < Square::N; king += threads.size()) {
+        for (const auto& th : threads) {
+          auto block = th.bg.getBlock(king);
+          if (block != nullptr) {
+            addBlock(og, king, *block);
+          }
+        }
+      }
+    });
   }
 
-  auto mp = pos.getMutablePosition();
-  th.os.write(reinterpret_cast<char*>(&mp), sizeof(MutablePosition));
+  for (auto& reducer : reducers) {
+    reducer.join();
+  }
+}
 
-  for (const auto& result : results) {
-    uint8_t length = result.pv.size() + 1;
-    th.os.write(reinterpret_cast<char*>(&length), sizeof(uint8_t));
-    uint16_t firstMove = result.move.serialize16();
-    th.os.write(reinterpret_cast<char*>(&firstMove), sizeof(uint16_t));
-    for (unsigned i = 0; i < result.pv.size(); i++) {
-      uint16_t move = result.pv.getMove(i).serialize16();
-      th.os.write(reinterpret_cast<char*>(&move), sizeof(uint16_t));
+void BatchLearning::generateGradient(GenGradThread& th) {
+  const auto& leafCache = *th.leafCache;
+  std::vector<Position> positions;
+  std::vector<Score> scores;
+
+  for (const auto& record : leafCache.records) {
+    positions.clear();
+    for (uint32_t i = record.begin; i < record.end; i++) {
+      positions.emplace_back(leafCache.positions[i]);
     }
+
+    generateGradient(th, record.rootTurn, positions, scores);
   }
-  uint8_t end = 0;
-  th.os.write(reinterpret_cast<char*>(&end), sizeof(uint8_t));
 }
 
-bool BatchLearning::generateGradient() {
-  std::vector<GenGradThread> threads(config_.numThreads);
-
-  for (unsigned tn = 0; tn < threads.size(); tn++) {
-    auto& th = threads[tn];
+void BatchLearning::generateGradient(GenGradThread& th,
+                                     Turn rootTurn,
+                                     const std::vector<Position>& positions,
+                                     std::vector<Score>& scores) {
+  extractGradient(*evaluator_, rootTurn, positions, scores, th.bg, th.mg, th.loss);
+}
 
-    auto path = trainingDataPath(tn);
-    th.is.open(path, std::ios::in | std::ios::binary);
-    if (!th.is) {
-      LOG(error) << "could not open a file: " << path;
+bool BatchLearning::assignTrainingData(std::vector<GenGradThread>& threads,
+                                       int shard,
+                                       int shards) {
+  struct Block {
+    unsigned fileIndex;
+    size_t blockIndex;
+    uint32_t numberOfRecords;
+  };
+  std::vector<Block> blocks;
+  uint64_t numberOfRecords = 0;
+
+  // each file of the training data is written by a thread
+  // of generateTrainingData.
+  for (int fn = 0; fn < config_.numThreads; fn++) {
+    TrainingDataReader reader;
+    if (!reader.open(TrainingDataGenerator::trainingDataPath(fn))) {
       return false;
     }
-
-    memset(reinterpret_cast<void*>(&th.og), 0, sizeof(th.og));
-    memset(reinterpret_cast<void*>(&th.mg), 0, sizeof(th.mg));
-    th.loss = 0.0f;
+    const auto& fileBlocks = reader.getBlocks();
+    for (size_t bn = 0; bn < fileBlocks.size(); bn++) {
+      blocks.push_back({ static_cast<unsigned>(fn), bn, fileBlocks[bn].numberOfRecords });
+      numberOfRecords += fileBlocks[bn].numberOfRecords;
+    }
   }
 
-  for (unsigned tn = 0; tn < threads.size(); tn++) {
-    auto& th = threads[tn];
-    th.thread = std::thread([this, &th]() {
-      generateGradient(th);
-    });
-  }
+  // split the blocks into contiguous ranges
+  // which have almost the same number of records.
+  // The ranges are numbered through all shards,
+  // and this process takes the ranges of its own shard.
+  size_t slots = threads.size() * shards;
+  uint64_t offset = 0;
+  for (const auto& block : blocks) {
+    size_t slot = offset * slots / std::max(numberOfRecords, static_cast<uint64_t>(1));
+    offset += block.numberOfRecords;
 
-  for (auto& th : threads) {
-    if (th.thread.joinable()) {
-      th.thread.join();
+    if (slot / threads.size() != static_cast<size_t>(shard)) {
+      continue;
     }
-  }
 
-  loss_ = failLoss_;
-  auto og = std::unique_ptr<OptimizedGradient>(new OptimizedGradient);
-  memset(reinterpret_cast<void*>(og.get()), 0, sizeof(OptimizedGradient));
-  memset(reinterpret_cast<void*>(mgradient_), 0, sizeof(MaterialGradient));
-  for (auto& th : threads) {
-    loss_ += th.loss;
-    add(*og, th.og);
-    madd(mgradient_, th.mg);
+    auto& ranges = threads[slot % threads.size()].ranges;
+    if (!ranges.empty() &&
+        ranges.back().fileIndex == block.fileIndex &&
+        ranges.back().endBlock == block.blockIndex) {
+      ranges.back().endBlock++;
+    } else {
+      ranges.push_back({ block.fileIndex, block.blockIndex, block.blockIndex + 1 });
+    }
   }
-  expand(*gradient_, *og);
-  symmetrize(*gradient_, [](float& g1, float& g2) {
-    g1 = g2 = g1 + g2;
-  });
 
   return true;
 }
 
-void BatchLearning::generateGradient(GenGradThread& th) {
-  for (;;) {
-    MutablePosition mp;
-    th.is.read(reinterpret_cast<char*>(&mp), sizeof(MutablePosition));
+bool BatchLearning::readTrainingData(GenGradThread& th) {
+  MutablePosition mp;
+  std::vector<std::vector<Move>> trainingData;
 
-    if (th.is.eof()) {
-      return;
+  for (const auto& range : th.ranges) {
+    auto path = TrainingDataGenerator::trainingDataPath(range.fileIndex);
+    TrainingDataReader reader;
+    if (!reader.open(path)) {
+      LOG(error) << "could not read the training data: " << path;
+      return false;
     }
+    reader.setBlockRange(range.beginBlock, range.endBlock);
 
-    std::vector<std::vector<Move>> trainingData;
-    for (;;) {
-      uint8_t length;
-      th.is.read(reinterpret_cast<char*>(&length), sizeof(uint8_t));
-      if (length == 0) { break; }
-
-      std::vector<Move> pv(length);
-      for (unsigned i = 0; i < length; i++) {
-        uint16_t move;
-        th.is.read(reinterpret_cast<char*>(&move), sizeof(uint16_t));
-        pv[i] = Move::deserialize(move);
-      }
-      trainingData.push_back(std::move(pv));
+    while (reader.read(mp, trainingData)) {
+      readTrainingData(th, Position(mp), trainingData);
     }
 
-    generateGradient(th, Position(mp), trainingData);
+    if (reader.isError()) {
+      LOG(error) << "the training data is broken: " << path;
+      return false;
+    }
   }
+
+  return true;
 }
 
-void BatchLearning::generateGradient(GenGradThread& th,
+void BatchLearning::readTrainingData(GenGradThread& th,
                                      const Position& rootPos,
                                      const std::vector<std::vector<Move>>& trainingData) {
-  Position pos0 = rootPos;
-  Score score0;
-  {
-    const auto& pv = trainingData[0];
-    for (auto& move : pv) {
-      Piece captured;
-      if (!pos0.doMove(move, captured)) {
-        LOG(error) << "an illegal move is detected:\n"
-                   << pos0.toString()
-                   << move.toString(pos0);
-        return;
-      }
-    }
-    Score materialScore = evaluator_->calculateMaterialScore(pos0);
-    score0 = evaluator_->calculateTotalScore(materialScore,
-                                             pos0);
-    if (rootPos.getTurn() == Turn::White) {
-      score0 = -score0;
-    }
-  }
+  auto& leafCache = *th.leafCache;
+  auto begin = leafCache.positions.size();
 
-  float d0 = 0.0f;
-  for (unsigned i = 1; i < trainingData.size(); i++) {
+  for (const auto& pv : trainingData) {
     Position pos = rootPos;
-    const auto& pv = trainingData[i];
     for (auto& move : pv) {
       Piece captured;
       if (!pos.doMove(move, captured)) {
         LOG(error) << "an illegal move is detected:\n"
                    << pos.toString()
                    << move.toString(pos);
+        leafCache.positions.resize(begin);
         return;
       }
     }
-
-    Score materialScore = evaluator_->calculateMaterialScore(pos);
-    auto score = evaluator_->calculateTotalScore(materialScore,
-                                                 pos);
-    if (rootPos.getTurn() == Turn::White) {
-      score = -score;
-    }
-
-    auto diff = score - score0;
-    float l = loss(diff.raw());
-    float d = gradient(diff.raw());
-
-    th.loss += l;
-
-    if (rootPos.getTurn() == Turn::White) {
-      d = -d;
-    }
-    operate<FeatureOperationType::Extract>(th.og, pos, -d);
-    extractMaterial(th.mg, pos, -d);
-    d0 += d;
+    leafCache.positions.push_back(pos.getMutablePosition());
   }
-  operate<FeatureOperationType::Extract>(th.og, pos0, d0);
-  extractMaterial(th.mg, pos0, d0);
+
+  leafCache.records.push_back({
+    static_cast<uint32_t>(begin),
+    static_cast<uint32_t>(leafCache.positions.size()),
+    rootPos.getTurn(),
+  });
 }
 
 void BatchLearning::updateParameters() {
-  each(*fv_, *gradient_, [this](int16_t& e, float& g) {
-    float n = norm(e, config_.norm);
-    int16_t step = random_.bit() + random_.bit();
-    if      (g + n > 0.0f && e <= Int16Max - step) { e += step; }
-    else if (g + n < 0.0f && e >= Int16Min + step) { e -= step; }
-    else if (g + n != 0.0f) { LOG(warning) << "A parameter is out of bounce."; }
+  Timer phaseTimer;
+  phaseTimer.start();
+
+  // Each block of the parameters has its own random number sequence,
+  // so that the result does not depend on the number of threads.
+  unsigned seed = random_.int32();
+  size_t size = sizeof(Evaluator::FVType) / sizeof(int16_t);
+  size_t numberOfBlocks = (size + UpdateBlockSize - 1) / UpdateBlockSize;
+  runParallel(config_.numThreads, [this, seed, size, numberOfBlocks](int part, int parts) {
+    auto fv = reinterpret_cast<int16_t*>(fv_.get());
+    auto gradient = reinterpret_cast<float*>(gradient_.get());
+    for (size_t b = part; b < numberOfBlocks; b += parts) {
+      Random random(seed + b);
+      size_t end = std::min((b + 1) * UpdateBlockSize, size);
+      for (size_t i = b * UpdateBlockSize; i < end; i++) {
+        int16_t& e = fv[i];
+        float g = gradient[i];
+        float n = norm(e, config_.norm);
+        int16_t step = random.bit() + random.bit();
+        if      (g + n > 0.0f && e <= Int16Max - step) { e += step; }
+        else if (g + n < 0.0f && e >= Int16Min + step) { e -= step; }
+        else if (g + n != 0.0f) { LOG(warning) << "A parameter is out of bounce."; }
+      }
+    }
   });
+  phaseTimes_.update += phaseTimer.elapsed();
 
-  symmetrize(*fv_, [](int16_t& e1, int16_t& e2) {
-    e1 = e2;
+  phaseTimer.start();
+  runParallel(config_.numThreads, [this](int part, int parts) {
+    symmetrize(*fv_, [](int16_t& e1, int16_t& e2) {
+      e1 = e2;
+    }, part, parts);
   });
+  phaseTimes_.symmetrize += phaseTimer.elapsed();
 
-  optimize(*fv_, evaluator_->ofv());
-
-  std::array<float*, 13> m = {
-    &mgradient_[PieceNumber::Pawn],
-    &mgradient_[PieceNumber::Lance],
-    &mgradient_[PieceNumber::Knight],
-    &mgradient_[PieceNumber::Silver],
-    &mgradient_[PieceNumber::Gold],
-    &mgradient_[PieceNumber::Bishop],
-    &mgradient_[PieceNumber::Rook],
-    &mgradient_[PieceNumber::Tokin],
-    &mgradient_[PieceNumber::ProLance],
-    &mgradient_[PieceNumber::ProKnight],
-    &mgradient_[PieceNumber::ProSilver],
-    &mgradient_[PieceNumber::Horse],
-    &mgradient_[PieceNumber::Dragon],
-  };
-  std::sort(m.begin(), m.end(), [](float* lhs, float* rhs) {
-    return *lhs < *rhs;
+  phaseTimer.start();
+  runParallel(config_.numThreads, [this](int part, int parts) {
+    optimize(*fv_, evaluator_->ofv(), part, parts);
   });
-  random_.shuffle(m.begin(), m.begin() + 6);
-  random_.shuffle(m.begin() + 6, m.end());
+  phaseTimes_.optimize += phaseTimer.elapsed();
 
 #if DEBUG_PRINT
   Score mprev[PieceNumber::Num];
@@ -602,24 +732,7 @@ void BatchLearning::updateParameters() {
   memcpy(mgprev, mgradient_, sizeof(mgprev));
 #endif // DEBUG_PRINT
 
-  *m[ 0] = *m[ 1]          = -2.0f;
-  *m[ 2] = *m[ 3] = *m[ 4] = -1.0f;
-  *m[ 5] = *m[ 6] = *m[ 7] =  0.0f;
-  *m[ 8] = *m[ 9] = *m[10] =  1.0f;
-  *m[11] = *m[12]          =  2.0f;
-  PIECE_TYPE_EACH(pieceType) {
-    material::scores[pieceType.raw()] += mgradient_[pieceType.raw()];
-    material::scores[pieceType.white().raw()] = material::scores[pieceType.raw()];
-  }
-  PIECE_EACH(piece) {
-    if (piece.type() == PieceType::king()) {
-      continue;
-    }
-    material::exchangeScores[piece.raw()]
-      = material::scores[piece.raw()] + material::scores[piece.unpromote().raw()];
-    material::promotionScores[piece.raw()]
-      = material::scores[piece.promote().raw()] - material::scores[piece.unpromote().raw()];
-  }
+  updateMaterial(mgradient_, random_);
 
 #if DEBUG_PRINT
   TablePrinter tp;
@@ -642,6 +755,16 @@ void BatchLearning::updateParameters() {
   evaluator_->onChanged(Evaluator::DataSourceType::Custom);
 }
 
+void BatchLearning::printPhaseTimes() {
+  MSG(info) << "elapsed time of each phase (sec):";
+  MSG(info) << "  gradient  : " << phaseTimes_.gradient;
+  MSG(info) << "  reduce    : " << phaseTimes_.reduce;
+  MSG(info) << "  expand    : " << phaseTimes_.expand;
+  MSG(info) << "  symmetrize: " << phaseTimes_.symmetrize;
+  MSG(info) << "  update    : " << phaseTimes_.update;
+  MSG(info) << "  optimize  : " << phaseTimes_.optimize;
+}
+
 void BatchLearning::printParametersSummary() {
   auto summary = summarize(*fv_);
   TablePrinter tp;
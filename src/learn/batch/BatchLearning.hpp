@@ -8,7 +8,9 @@
 
 #include "common/time/Timer.hpp"
 #include "common/math/Random.hpp"
+#include "common/process/ChildProcess.hpp"
 #include "core/move/Move.hpp"
+#include "core/position/Position.hpp"
 #include "search/eval/Evaluator.hpp"
 #include "learn/batch/Gradient.hpp"
 #include <thread>
@@ -20,10 +22,6 @@
 
 namespace sunfish {
 
-class Position;
-class Searcher;
-class RecordQueue;
-
 class BatchLearning {
 public:
 
@@ -35,25 +33,57 @@ public:
     int numThreads;
     int depth;
     float norm;
+    bool compressTrainingData;
+    int numShards;
+    std::string workerCommand;
   };
 
 private:
 
-  struct GenTrDataThread {
-    std::thread thread;
-    RecordQueue* recordQueue;
-    std::ofstream os;
-    std::unique_ptr<Searcher> searcher;
-    int failLoss;
-    int numberOfData;
+  /**
+   * The blocks [beginBlock, endBlock) of a training data file.
+   */
+  struct TrainingDataRange {
+    unsigned fileIndex;
+    size_t beginBlock;
+    size_t endBlock;
+  };
+
+  struct LeafRecord {
+    uint32_t begin;
+    uint32_t end;
+    Turn rootTurn;
+  };
+
+  /**
+   * The leaf positions of the training data.
+   * This is built on the first pass and reused by the later passes.
+   */
+  struct LeafCache {
+    std::vector<MutablePosition> positions;
+    std::vector<LeafRecord> records;
+  };
+
+  /**
+   * The elapsed seconds of the phases in an iteration.
+   */
+  struct PhaseTimes {
+    float gradient;
+    float reduce;
+    float expand;
+    float symmetrize;
+    float update;
+    float optimize;
   };
 
   struct GenGradThread {
     std::thread thread;
-    std::ifstream is;
-    OptimizedGradient og;
+    std::vector<TrainingDataRange> ranges;
+    LeafCache* leafCache;
+    BlockedGradient bg;
     MaterialGradient mg;
     float loss;
+    bool ok;
   };
 
 public:
@@ -62,6 +92,12 @@ public:
 
   bool run();
 
+  /**
+   * Run as the worker process of the shard.
+   * The worker exits when the coordinator of the pid has exited.
+   */
+  bool runShard(int shard, int coordinator);
+
 private:
 
   void readConfigFromIniFile();
@@ -72,20 +108,37 @@ private:
 
   bool generateTrainingData();
 
-  void generateTrainingData(GenTrDataThread& th);
+  bool generateGradient();
 
-  void generateTrainingData(GenTrDataThread& th,
-                            const std::string& path);
+  bool generateGradient(OptimizedGradient& og,
+                        int shard,
+                        int shards);
 
-  void generateTrainingData(GenTrDataThread& th,
-                            Position& pos,
-                            Move bestMove);
+  bool collectShardGradients(OptimizedGradient& og);
 
-  bool generateGradient();
+  bool startWorkers();
+
+  bool startWorker(int shard);
+
+  void stopWorkers();
 
   void generateGradient(GenGradThread& th);
 
   void generateGradient(GenGradThread& th,
+                        Turn rootTurn,
+                        const std::vector<Position>& positions,
+                        std::vector<Score>& scores);
+
+  void reduceGradient(std::vector<GenGradThread>& threads,
+                      OptimizedGradient& og);
+
+  bool assignTrainingData(std::vector<GenGradThread>& threads,
+                          int shard,
+                          int shards);
+
+  bool readTrainingData(GenGradThread& th);
+
+  void readTrainingData(GenGradThread& th,
                         const Position& rootPos,
                         const std::vector<std::vector<Move>>& trainingData);
 
@@ -93,6 +146,8 @@ private:
 
   void printParametersSummary();
 
+  void printPhaseTimes();
+
 private:
 
   Config config_;
@@ -108,6 +163,15 @@ private:
   std::unique_ptr<Gradient> gradient_;
   MaterialGradient mgradient_;
 
+  std::vector<LeafCache> leafCaches_;
+
+  PhaseTimes phaseTimes_;
+
+  std::vector<std::unique_ptr<ChildProcess>> workers_;
+  std::vector<int> workerRestarts_;
+  int64_t pass_;
+  int64_t generation_;
+
 };
 
 } // namespace sunfish
@@ -4,10 +4,93 @@
  */
 
 #include "learn/batch/Gradient.hpp"
+#include "search/eval/Evaluator.hpp"
+#include "search/eval/FeatureTemplates.hpp"
+#include "search/eval/Material.hpp"
 #include "core/position/Position.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <cmath>
+
+namespace {
+
+using namespace sunfish;
+
+inline float gain() {
+  return 7.0f / LearningWindow;
+}
+
+inline float sigmoid(float x) {
+  if (x <= -LearningWindow) { return 0.0f; }
+  if (x >=  LearningWindow) { return 1.0f; }
+  return 1.0 / (1.0 + std::exp(x * -gain()));
+}
+
+inline float dsigmoid(float x) {
+  float s = sigmoid(x);
+  return (s - s * s) * gain();
+}
+
+inline float loss(float x) {
+  return sigmoid(x);
+}
+
+inline float gradient(float x) {
+  return dsigmoid(x);
+}
+
+template <class R>
+inline
+void addRow(R& dst, const R& src) {
+  for (size_t i = 0; i < sizeof(R) / sizeof(float); i++) {
+    reinterpret_cast<float*>(&dst)[i] += reinterpret_cast<const float*>(&src)[i];
+  }
+}
+
+} // namespace
 
 namespace sunfish {
 
+size_t BlockedGradient::numberOfBlocks() const {
+  size_t n = 0;
+  for (const auto& b : blocks_) {
+    if (b) {
+      n++;
+    }
+  }
+  return n;
+}
+
+void BlockedGradient::clear() {
+  for (auto& b : blocks_) {
+    b.reset();
+  }
+}
+
+void BlockedGradient::allocate(int king) {
+  blocks_[king].reset(new GradientBlock);
+  memset(reinterpret_cast<void*>(blocks_[king].get()), 0, sizeof(GradientBlock));
+}
+
+void addBlock(OptimizedGradient& og, int king, const GradientBlock& block) {
+#define ADD_GRADIENT_ROW(name) addRow(og.name[king], block.name);
+  GRADIENT_BLOCK_EACH(ADD_GRADIENT_ROW)
+#undef ADD_GRADIENT_ROW
+}
+
+void addRows(OptimizedGradient& dst, int king, const OptimizedGradient& src) {
+#define ADD_GRADIENT_ROWS(name) addRow(dst.name[king], src.name[king]);
+  GRADIENT_BLOCK_EACH(ADD_GRADIENT_ROWS)
+#undef ADD_GRADIENT_ROWS
+}
+
+void clearBlock(OptimizedGradient& og, int king) {
+#define CLEAR_GRADIENT_ROW(name) memset(reinterpret_cast<void*>(&og.name[king]), 0, sizeof(og.name[king]));
+  GRADIENT_BLOCK_EACH(CLEAR_GRADIENT_ROW)
+#undef CLEAR_GRADIENT_ROW
+}
+
 void extractMaterial(MaterialGradient mg, const Position& pos, float d) {
   int pc[std::extent<MaterialGradient>::value] = {};
 
@@ -36,4 +119,83 @@ void extractMaterial(MaterialGradient mg, const Position& pos, float d) {
   }
 }
 
+void updateMaterial(MaterialGradient mg, Random& random) {
+  std::array<float*, 13> m = {
+    &mg[PieceNumber::Pawn],
+    &mg[PieceNumber::Lance],
+    &mg[PieceNumber::Knight],
+    &mg[PieceNumber::Silver],
+    &mg[PieceNumber::Gold],
+    &mg[PieceNumber::Bishop],
+    &mg[PieceNumber::Rook],
+    &mg[PieceNumber::Tokin],
+    &mg[PieceNumber::ProLance],
+    &mg[PieceNumber::ProKnight],
+    &mg[PieceNumber::ProSilver],
+    &mg[PieceNumber::Horse],
+    &mg[PieceNumber::Dragon],
+  };
+  std::sort(m.begin(), m.end(), [](float* lhs, float* rhs) {
+    return *lhs < *rhs;
+  });
+  random.shuffle(m.begin(), m.begin() + 6);
+  random.shuffle(m.begin() + 6, m.end());
+
+  *m[ 0] = *m[ 1]          = -2.0f;
+  *m[ 2] = *m[ 3] = *m[ 4] = -1.0f;
+  *m[ 5] = *m[ 6] = *m[ 7] =  0.0f;
+  *m[ 8] = *m[ 9] = *m[10] =  1.0f;
+  *m[11] = *m[12]          =  2.0f;
+  PIECE_TYPE_EACH(pieceType) {
+    material::scores[pieceType.raw()] += mg[pieceType.raw()];
+    material::scores[pieceType.white().raw()] = material::scores[pieceType.raw()];
+  }
+  PIECE_EACH(piece) {
+    if (piece.type() == PieceType::king()) {
+      continue;
+    }
+    material::exchangeScores[piece.raw()]
+      = material::scores[piece.raw()] + material::scores[piece.unpromote().raw()];
+    material::promotionScores[piece.raw()]
+      = material::scores[piece.promote().raw()] - material::scores[piece.unpromote().raw()];
+  }
+}
+
+void extractGradient(Evaluator& evaluator,
+                     Turn rootTurn,
+                     const std::vector<Position>& positions,
+                     std::vector<Score>& scores,
+                     BlockedGradient& bg,
+                     MaterialGradient mg,
+                     float& l) {
+  evaluator.evaluateBatch(positions, scores);
+
+  if (rootTurn == Turn::White) {
+    for (auto& score : scores) {
+      score = -score;
+    }
+  }
+
+  const Position& pos0 = positions[0];
+  Score score0 = scores[0];
+
+  float d0 = 0.0f;
+  for (unsigned i = 1; i < positions.size(); i++) {
+    const Position& pos = positions[i];
+    auto diff = scores[i] - score0;
+    float d = gradient(diff.raw());
+
+    l += loss(diff.raw());
+
+    if (rootTurn == Turn::White) {
+      d = -d;
+    }
+    operate<FeatureOperationType::Extract>(bg, pos, -d);
+    extractMaterial(mg, pos, -d);
+    d0 += d;
+  }
+  operate<FeatureOperationType::Extract>(bg, pos0, d0);
+  extractMaterial(mg, pos0, d0);
+}
+
 } // namespace sunfish
@@ -7,17 +7,143 @@
 #define SUNFISH_LEARN_BATCH_GRADIENT_HPP__
 
 #include "search/eval/FeatureVector.hpp"
+#include "search/eval/Score.hpp"
+#include "core/base/Turn.hpp"
+#include "common/math/Random.hpp"
 #include <type_traits>
+#include <vector>
+#include <memory>
+#include <cstddef>
 
 namespace sunfish {
 
 class Position;
+class Evaluator;
 
 using Gradient = FeatureVector<float>;
 using OptimizedGradient = OptimizedFeatureVector<float>;
 
 using MaterialGradient = float[16];
 
+/**
+ * The width of the window around the score of the move played.
+ * The moves out of the window are not written to the training data.
+ */
+CONSTEXPR_CONST int LearningWindow = 256;
+
+#define GRADIENT_BLOCK_EACH(M) \
+  M(kingHand) \
+  M(kingPiece) \
+  M(kingNeighborHand) \
+  M(kingNeighborPiece) \
+  M(kingKingHand) \
+  M(kingKingPiece) \
+  M(kingBRookVer) \
+  M(kingWRookVer) \
+  M(kingBRookHor) \
+  M(kingWRookHor) \
+  M(kingBBishopDiagL45) \
+  M(kingWBishopDiagL45) \
+  M(kingBBishopDiagR45) \
+  M(kingWBishopDiagR45) \
+  M(kingBLance) \
+  M(kingWLance) \
+  M(kingAllyEffect9) \
+  M(kingEnemyEffect9) \
+  M(kingAllyEffect25) \
+  M(kingEnemyEffect25)
+
+/**
+ * The rows of OptimizedGradient which belong to a king square.
+ */
+struct GradientBlock {
+  template <class Table>
+  using Row = typename std::remove_extent<Table>::type;
+
+#define GRADIENT_BLOCK_ROW(name) \
+  Row<decltype(OptimizedGradient::name)> name;
+  GRADIENT_BLOCK_EACH(GRADIENT_BLOCK_ROW)
+#undef GRADIENT_BLOCK_ROW
+};
+
+/**
+ * The gradient accumulator which allocates the block of a king square
+ * when the block is touched for the first time.
+ * This has the same subscript interface as OptimizedGradient,
+ * so that it can be passed to operate<FeatureOperationType::Extract>().
+ */
+class BlockedGradient {
+public:
+
+  using Type = float;
+
+  template <class R, R GradientBlock::*member>
+  class Table {
+  public:
+
+    Table(BlockedGradient& owner) : owner_(owner) {
+    }
+
+    R& operator[](int king) {
+      return owner_.block(king).*member;
+    }
+
+  private:
+
+    BlockedGradient& owner_;
+
+  };
+
+  BlockedGradient() = default;
+
+  BlockedGradient(const BlockedGradient&) = delete;
+
+  BlockedGradient(BlockedGradient&&) = delete;
+
+  GradientBlock& block(int king) {
+    auto& b = blocks_[king];
+    if (!b) {
+      allocate(king);
+    }
+    return *b;
+  }
+
+  const GradientBlock* getBlock(int king) const {
+    return blocks_[king].get();
+  }
+
+  size_t numberOfBlocks() const;
+
+  void clear();
+
+#define BLOCKED_GRADIENT_TABLE(name) \
+  Table<decltype(GradientBlock::name), &GradientBlock::name> name{*this};
+  GRADIENT_BLOCK_EACH(BLOCKED_GRADIENT_TABLE)
+#undef BLOCKED_GRADIENT_TABLE
+
+private:
+
+  void allocate(int king);
+
+  std::unique_ptr<GradientBlock> blocks_[Square::N];
+
+};
+
+/**
+ * Add the block of the king square to the dense gradient.
+ */
+void addBlock(OptimizedGradient& og, int king, const GradientBlock& block);
+
+/**
+ * Add the rows of the king square of src to dst.
+ */
+void addRows(OptimizedGradient& dst, int king, const OptimizedGradient& src);
+
+/**
+ * Clear the rows of the king square of the dense gradient.
+ */
+void clearBlock(OptimizedGradient& og, int king);
+
 inline
 void madd(MaterialGradient dst, const MaterialGradient src) {
   for (size_t i = 0; i < std::extent<MaterialGradient>::value; i++) {
@@ -27,6 +153,25 @@ void madd(MaterialGradient dst, const MaterialGradient src) {
 
 void extractMaterial(MaterialGradient mg, const Position& pos, float d);
 
+/**
+ * Move each material score by -2 to +2 in the order of the gradients.
+ * The elements of mg are overwritten with the steps.
+ */
+void updateMaterial(MaterialGradient mg, Random& random);
+
+/**
+ * Accumulate the gradient and the loss of a training record.
+ * positions[0] is the leaf of the PV of the move played,
+ * and the others are the leaves of the other moves.
+ */
+void extractGradient(Evaluator& evaluator,
+                     Turn rootTurn,
+                     const std::vector<Position>& positions,
+                     std::vector<Score>& scores,
+                     BlockedGradient& bg,
+                     MaterialGradient mg,
+                     float& loss);
+
 } // namespace sunfish
 
 #endif // SUNFISH_LEARN_BATCH_GRADIENT_HPP__
@@ -0,0 +1,176 @@
+/* Shard.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "learn/batch/Shard.hpp"
+#include "search/eval/Material.hpp"
+#include "common/file_system/FileUtil.hpp"
+#include "logger/Logger.hpp"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+using namespace sunfish;
+
+const char* const ShardParamsPath = "out/shard.params";
+const char* const ShardParamsTemporaryPath = "out/shard.params.tmp";
+
+const char ParamsMagic[4] = { 'S', 'F', 'S', 'P' };
+const char GradientMagic[4] = { 'S', 'F', 'S', 'G' };
+
+/**
+ * The gradient is placed on a cache line boundary.
+ */
+CONSTEXPR_CONST size_t GradientOffset = (sizeof(ShardGradientHeader) + 63) / 64 * 64;
+
+std::string shardGradientPath(unsigned shard) {
+  std::ostringstream oss;
+  oss << "out/shard" << shard << ".grad";
+  return oss.str();
+}
+
+std::string shardGradientTemporaryPath(unsigned shard) {
+  return shardGradientPath(shard) + ".tmp";
+}
+
+} // namespace
+
+namespace sunfish {
+
+bool writeShardParams(ShardParamsHeader& header,
+                      const Evaluator::FVType& fv) {
+  memcpy(header.magic, ParamsMagic, sizeof(header.magic));
+
+  {
+    std::ofstream file(ShardParamsTemporaryPath, std::ios::out | std::ios::binary);
+    if (!file) {
+      LOG(error) << "could not open a file: " << ShardParamsTemporaryPath;
+      return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(material::scores), sizeof(material::scores));
+    file.write(reinterpret_cast<const char*>(material::exchangeScores), sizeof(material::exchangeScores));
+    file.write(reinterpret_cast<const char*>(material::promotionScores), sizeof(material::promotionScores));
+    file.write(reinterpret_cast<const char*>(&fv), sizeof(fv));
+    if (!file) {
+      LOG(error) << "could not write to a file: " << ShardParamsTemporaryPath;
+      return false;
+    }
+  }
+
+  if (std::rename(ShardParamsTemporaryPath, ShardParamsPath) != 0) {
+    LOG(error) << "could not rename a file: " << ShardParamsTemporaryPath;
+    return false;
+  }
+
+  return true;
+}
+
+bool readShardParamsHeader(ShardParamsHeader& header) {
+  std::ifstream file(ShardParamsPath, std::ios::in | std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  return file && memcmp(header.magic, ParamsMagic, sizeof(header.magic)) == 0;
+}
+
+bool readShardParams(ShardParamsHeader& header,
+                     Evaluator::FVType& fv) {
+  std::ifstream file(ShardParamsPath, std::ios::in | std::ios::binary);
+  if (!file) {
+    LOG(error) << "could not open a file: " << ShardParamsPath;
+    return false;
+  }
+
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  file.read(reinterpret_cast<char*>(material::scores), sizeof(material::scores));
+  file.read(reinterpret_cast<char*>(material::exchangeScores), sizeof(material::exchangeScores));
+  file.read(reinterpret_cast<char*>(material::promotionScores), sizeof(material::promotionScores));
+  file.read(reinterpret_cast<char*>(&fv), sizeof(fv));
+  if (!file || memcmp(header.magic, ParamsMagic, sizeof(header.magic)) != 0) {
+    LOG(error) << "could not read a file: " << ShardParamsPath;
+    return false;
+  }
+
+  return true;
+}
+
+void removeShardFiles(int numShards) {
+  std::remove(ShardParamsPath);
+  std::remove(ShardParamsTemporaryPath);
+  for (int shard = 0; shard < numShards; shard++) {
+    std::remove(shardGradientPath(shard).c_str());
+    std::remove(shardGradientTemporaryPath(shard).c_str());
+  }
+}
+
+bool ShardGradientFile::create(unsigned shard) {
+  shard_ = shard;
+  if (!file_.create(shardGradientTemporaryPath(shard),
+                    GradientOffset + sizeof(OptimizedGradient))) {
+    return false;
+  }
+
+  memcpy(header().magic, GradientMagic, sizeof(header().magic));
+  header().shard = shard;
+  return true;
+}
+
+bool ShardGradientFile::commit() {
+  bool ok = file_.sync();
+  file_.close();
+
+  auto path = shardGradientTemporaryPath(shard_);
+  if (!ok || std::rename(path.c_str(), shardGradientPath(shard_).c_str()) != 0) {
+    LOG(error) << "could not write to a file: " << path;
+    return false;
+  }
+
+  return true;
+}
+
+bool ShardGradientFile::open(unsigned shard) {
+  shard_ = shard;
+  auto path = shardGradientPath(shard);
+  if (!FileUtil::isFile(path)) {
+    return false;
+  }
+
+  if (!file_.open(path)) {
+    return false;
+  }
+
+  if (file_.size() != GradientOffset + sizeof(OptimizedGradient) ||
+      memcmp(header().magic, GradientMagic, sizeof(header().magic)) != 0 ||
+      header().shard != shard) {
+    LOG(error) << "invalid gradient file: " << path;
+    file_.close();
+    return false;
+  }
+
+  return true;
+}
+
+void ShardGradientFile::remove() {
+  file_.close();
+  std::remove(shardGradientPath(shard_).c_str());
+}
+
+OptimizedGradient& ShardGradientFile::gradient() {
+  auto data = reinterpret_cast<char*>(file_.data()) + GradientOffset;
+  return *reinterpret_cast<OptimizedGradient*>(data);
+}
+
+const OptimizedGradient& ShardGradientFile::gradient() const {
+  auto data = reinterpret_cast<const char*>(file_.data()) + GradientOffset;
+  return *reinterpret_cast<const OptimizedGradient*>(data);
+}
+
+} // namespace sunfish
@@ -0,0 +1,119 @@
+/* Shard.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_LEARN_BATCH_SHARD_HPP__
+#define SUNFISH_LEARN_BATCH_SHARD_HPP__
+
+#include "common/file_system/MappedFile.hpp"
+#include "search/eval/Evaluator.hpp"
+#include "learn/batch/Gradient.hpp"
+#include <string>
+#include <cstdint>
+
+namespace sunfish {
+
+/**
+ * The files shared by the coordinator and the worker processes
+ * of the sharded gradient mode.
+ *
+ *   out/shard.params   : written by the coordinator for each pass.
+ *                        the header, the material scores and the parameters.
+ *   out/shard<N>.grad  : written by the worker N for each pass.
+ *                        the header and the partial OptimizedGradient.
+ *
+ * Both files are written into a temporary file and renamed,
+ * so that a reader never sees an incomplete file.
+ */
+struct ShardParamsHeader {
+  char magic[4];
+  uint32_t stop;
+  int64_t pass;
+  int64_t generation;
+};
+
+struct ShardGradientHeader {
+  char magic[4];
+  uint32_t shard;
+  int64_t pass;
+  float loss;
+  MaterialGradient mg;
+};
+
+/**
+ * Write the parameters and the material scores.
+ */
+bool writeShardParams(ShardParamsHeader& header,
+                      const Evaluator::FVType& fv);
+
+/**
+ * Read only the header.
+ * This returns false if the file does not exist.
+ */
+bool readShardParamsHeader(ShardParamsHeader& header);
+
+/**
+ * Read the parameters and the material scores.
+ */
+bool readShardParams(ShardParamsHeader& header,
+                     Evaluator::FVType& fv);
+
+/**
+ * Remove the files left by the previous run.
+ */
+void removeShardFiles(int numShards);
+
+class ShardGradientFile {
+public:
+
+  ShardGradientFile() : shard_(0) {
+  }
+
+  ShardGradientFile(const ShardGradientFile&) = delete;
+  ShardGradientFile(ShardGradientFile&&) = delete;
+
+  /**
+   * Create the temporary file of the shard.
+   * The gradient is initialized to zero.
+   */
+  bool create(unsigned shard);
+
+  /**
+   * Flush the file and rename it to the final path.
+   */
+  bool commit();
+
+  /**
+   * Map the committed file of the shard read-only.
+   * This returns false if the file does not exist yet.
+   */
+  bool open(unsigned shard);
+
+  /**
+   * Close and delete the committed file.
+   */
+  void remove();
+
+  ShardGradientHeader& header() {
+    return *reinterpret_cast<ShardGradientHeader*>(file_.data());
+  }
+
+  const ShardGradientHeader& header() const {
+    return *reinterpret_cast<const ShardGradientHeader*>(file_.data());
+  }
+
+  OptimizedGradient& gradient();
+
+  const OptimizedGradient& gradient() const;
+
+private:
+
+  MappedFile file_;
+  unsigned shard_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_LEARN_BATCH_SHARD_HPP__
@@ -0,0 +1,325 @@
+/* TrainingData.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "learn/batch/TrainingData.hpp"
+#include "core/position/PackedPosition.hpp"
+#include "common/compression/Lz77.hpp"
+#include "logger/Logger.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+namespace {
+
+using namespace sunfish;
+
+const char FileMagic[4] = { 'S', 'F', 'T', 'D' };
+const char IndexMagic[4] = { 'S', 'F', 'T', 'I' };
+
+CONSTEXPR_CONST size_t HeaderSize = 8;
+CONSTEXPR_CONST size_t FooterSize = 12;
+
+/**
+ * A block is flushed when its size exceeds this value.
+ */
+CONSTEXPR_CONST size_t BlockSize = 256 * 1024;
+
+/**
+ * The upper bound of the size of a block, which is used to detect broken files.
+ */
+CONSTEXPR_CONST size_t MaximumBlockSize = 64 * 1024 * 1024;
+
+inline void put8(std::vector<uint8_t>& buffer, uint8_t value) {
+  buffer.push_back(value);
+}
+
+inline void put16(std::vector<uint8_t>& buffer, uint16_t value) {
+  buffer.push_back(static_cast<uint8_t>(value));
+  buffer.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+inline uint16_t get16(const uint8_t* p) {
+  return p[0] | (static_cast<uint16_t>(p[1]) << 8);
+}
+
+} // namespace
+
+namespace sunfish {
+
+TrainingDataWriter::TrainingDataWriter() :
+    compress_(false),
+    numberOfRecords_(0),
+    offset_(0),
+    rawSize_(0) {
+}
+
+TrainingDataWriter::~TrainingDataWriter() {
+  if (file_.is_open()) {
+    close();
+  }
+}
+
+bool TrainingDataWriter::open(const std::string& path, bool compress) {
+  file_.open(path, std::ios::out | std::ios::binary);
+  if (!file_) {
+    LOG(error) << "could not open a file: " << path;
+    return false;
+  }
+
+  compress_ = compress;
+  buffer_.clear();
+  buffer_.reserve(BlockSize + 4 * 1024);
+  numberOfRecords_ = 0;
+  blocks_.clear();
+  offset_ = 0;
+  rawSize_ = 0;
+
+  uint16_t version = TrainingData::Version;
+  uint16_t flags = compress ? TrainingData::FlagCompressed : 0;
+  return writeBytes(FileMagic, sizeof(FileMagic))
+      && writeBytes(&version, sizeof(version))
+      && writeBytes(&flags, sizeof(flags));
+}
+
+bool TrainingDataWriter::close() {
+  bool ok = flushBlock();
+
+  uint64_t indexOffset = offset_;
+  uint32_t numberOfBlocks = blocks_.size();
+  ok = ok && writeBytes(&numberOfBlocks, sizeof(numberOfBlocks));
+  for (const auto& block : blocks_) {
+    ok = ok && writeBytes(&block.offset, sizeof(block.offset))
+            && writeBytes(&block.numberOfRecords, sizeof(block.numberOfRecords));
+  }
+  ok = ok && writeBytes(&indexOffset, sizeof(indexOffset))
+          && writeBytes(IndexMagic, sizeof(IndexMagic));
+
+  file_.close();
+  return ok;
+}
+
+bool TrainingDataWriter::write(const Position& pos,
+                               const std::vector<std::vector<Move>>& pvs) {
+  auto packed = packPosition(pos.getMutablePosition());
+  buffer_.insert(buffer_.end(), packed.data, packed.data + PackedPosition::Size);
+
+  put16(buffer_, static_cast<uint16_t>(pvs.size()));
+  for (const auto& pv : pvs) {
+    uint8_t length = std::min(pv.size(), static_cast<size_t>(0xff));
+    put8(buffer_, length);
+    for (unsigned i = 0; i < length; i++) {
+      put16(buffer_, pv[i].serialize16());
+    }
+  }
+  numberOfRecords_++;
+
+  if (buffer_.size() >= BlockSize) {
+    return flushBlock();
+  }
+  return true;
+}
+
+bool TrainingDataWriter::flushBlock() {
+  if (numberOfRecords_ == 0) {
+    return true;
+  }
+
+  const uint8_t* data = buffer_.data();
+  uint32_t storedSize = buffer_.size();
+  uint32_t rawSize = buffer_.size();
+  if (compress_) {
+    compressed_.clear();
+    Lz77::compress(buffer_.data(), buffer_.size(), compressed_);
+    data = compressed_.data();
+    storedSize = compressed_.size();
+  }
+
+  blocks_.push_back({ offset_, numberOfRecords_ });
+  rawSize_ += rawSize;
+
+  bool ok = writeBytes(&storedSize, sizeof(storedSize))
+         && writeBytes(&rawSize, sizeof(rawSize))
+         && writeBytes(&numberOfRecords_, sizeof(numberOfRecords_))
+         && writeBytes(data, storedSize);
+
+  buffer_.clear();
+  numberOfRecords_ = 0;
+  return ok;
+}
+
+bool TrainingDataWriter::writeBytes(const void* data, size_t size) {
+  file_.write(reinterpret_cast<const char*>(data), size);
+  offset_ += size;
+  return !file_.fail();
+}
+
+TrainingDataReader::TrainingDataReader() :
+    compressed_(false),
+    nextBlock_(0),
+    endBlock_(0),
+    position_(0),
+    remainingRecords_(0),
+    error_(false) {
+}
+
+bool TrainingDataReader::open(const std::string& path) {
+  path_ = path;
+  file_.open(path, std::ios::in | std::ios::binary);
+  if (!file_) {
+    LOG(error) << "could not open a file: " << path;
+    return false;
+  }
+
+  char magic[4];
+  uint16_t version;
+  uint16_t flags;
+  if (!readBytes(magic, sizeof(magic)) ||
+      !readBytes(&version, sizeof(version)) ||
+      !readBytes(&flags, sizeof(flags)) ||
+      memcmp(magic, FileMagic, sizeof(magic)) != 0) {
+    LOG(error) << "invalid training data: " << path;
+    return false;
+  }
+  if (version != TrainingData::Version) {
+    LOG(error) << "unsupported version of training data: " << version;
+    return false;
+  }
+  compressed_ = flags & TrainingData::FlagCompressed;
+
+  uint64_t indexOffset;
+  file_.seekg(-static_cast<std::streamoff>(FooterSize), std::ios::end);
+  if (!readBytes(&indexOffset, sizeof(indexOffset)) ||
+      !readBytes(magic, sizeof(magic)) ||
+      memcmp(magic, IndexMagic, sizeof(magic)) != 0) {
+    LOG(error) << "the index of training data is broken: " << path;
+    return false;
+  }
+
+  uint32_t numberOfBlocks;
+  file_.seekg(indexOffset);
+  if (!readBytes(&numberOfBlocks, sizeof(numberOfBlocks))) {
+    LOG(error) << "the index of training data is broken: " << path;
+    return false;
+  }
+  blocks_.resize(numberOfBlocks);
+  for (auto& block : blocks_) {
+    if (!readBytes(&block.offset, sizeof(block.offset)) ||
+        !readBytes(&block.numberOfRecords, sizeof(block.numberOfRecords)) ||
+        block.offset < HeaderSize || block.offset >= indexOffset) {
+      LOG(error) << "the index of training data is broken: " << path;
+      blocks_.clear();
+      return false;
+    }
+  }
+
+  setBlockRange(0, blocks_.size());
+  return true;
+}
+
+void TrainingDataReader::setBlockRange(size_t begin, size_t end) {
+  nextBlock_ = std::min(begin, blocks_.size());
+  endBlock_ = std::min(end, blocks_.size());
+  remainingRecords_ = 0;
+}
+
+bool TrainingDataReader::read(MutablePosition& mp,
+                              std::vector<std::vector<Move>>& pvs) {
+  while (remainingRecords_ == 0) {
+    if (nextBlock_ >= endBlock_) {
+      return false;
+    }
+    if (!readBlock()) {
+      error_ = true;
+      return false;
+    }
+  }
+
+  const uint8_t* p = &buffer_[position_];
+  const uint8_t* end = buffer_.data() + buffer_.size();
+
+  if (end - p < static_cast<ptrdiff_t>(PackedPosition::Size + 2)) {
+    LOG(error) << "a record of training data is broken: " << path_;
+    error_ = true;
+    return false;
+  }
+
+  PackedPosition packed;
+  memcpy(packed.data, p, PackedPosition::Size);
+  p += PackedPosition::Size;
+  if (!unpackPosition(packed, mp)) {
+    LOG(error) << "a record of training data is broken: " << path_;
+    error_ = true;
+    return false;
+  }
+
+  unsigned numberOfPVs = get16(p);
+  p += 2;
+  pvs.resize(numberOfPVs);
+  for (auto& pv : pvs) {
+    if (p >= end) {
+      LOG(error) << "a record of training data is broken: " << path_;
+      error_ = true;
+      return false;
+    }
+    unsigned length = *(p++);
+    if (end - p < static_cast<ptrdiff_t>(length * 2)) {
+      LOG(error) << "a record of training data is broken: " << path_;
+      error_ = true;
+      return false;
+    }
+    pv.resize(length);
+    for (unsigned i = 0; i < length; i++, p += 2) {
+      pv[i] = Move::deserialize(get16(p));
+    }
+  }
+
+  position_ = p - buffer_.data();
+  remainingRecords_--;
+  return true;
+}
+
+bool TrainingDataReader::readBlock() {
+  const auto& block = blocks_[nextBlock_++];
+
+  uint32_t storedSize;
+  uint32_t rawSize;
+  uint32_t numberOfRecords;
+  file_.clear();
+  file_.seekg(block.offset);
+  if (!readBytes(&storedSize, sizeof(storedSize)) ||
+      !readBytes(&rawSize, sizeof(rawSize)) ||
+      !readBytes(&numberOfRecords, sizeof(numberOfRecords)) ||
+      storedSize > MaximumBlockSize || rawSize > MaximumBlockSize ||
+      numberOfRecords != block.numberOfRecords) {
+    LOG(error) << "a block of training data is broken: " << path_;
+    return false;
+  }
+
+  if (compressed_) {
+    stored_.resize(storedSize);
+    if (!readBytes(stored_.data(), storedSize) ||
+        !Lz77::decompress(stored_.data(), storedSize, buffer_, rawSize)) {
+      LOG(error) << "a block of training data is broken: " << path_;
+      return false;
+    }
+  } else {
+    buffer_.resize(storedSize);
+    if (storedSize != rawSize || !readBytes(buffer_.data(), storedSize)) {
+      LOG(error) << "a block of training data is broken: " << path_;
+      return false;
+    }
+  }
+
+  position_ = 0;
+  remainingRecords_ = numberOfRecords;
+  return true;
+}
+
+bool TrainingDataReader::readBytes(void* data, size_t size) {
+  file_.read(reinterpret_cast<char*>(data), size);
+  return !file_.fail();
+}
+
+} // namespace sunfish
@@ -0,0 +1,145 @@
+/* TrainingData.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_LEARN_BATCH_TRAININGDATA_HPP__
+#define SUNFISH_LEARN_BATCH_TRAININGDATA_HPP__
+
+#include "core/move/Move.hpp"
+#include "core/position/Position.hpp"
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace sunfish {
+
+/**
+ * The file format of the training data.
+ *
+ *   header : magic, version and flags
+ *   blocks : block header (stored size, raw size, the number of records)
+ *            and the records, which are compressed if the flag is set
+ *   index  : the number of blocks, and the offset and the number of
+ *            records of each block
+ *   footer : the offset of the index and magic
+ *
+ * Each record is a packed position followed by PVs,
+ * and never spans blocks.
+ * So the file can be split across threads by the block index.
+ */
+struct TrainingData {
+  static CONSTEXPR_CONST uint16_t Version = 1;
+  static CONSTEXPR_CONST uint16_t FlagCompressed = 0x0001;
+
+  struct Block {
+    uint64_t offset;
+    uint32_t numberOfRecords;
+  };
+};
+
+class TrainingDataWriter {
+public:
+
+  TrainingDataWriter();
+  TrainingDataWriter(const TrainingDataWriter&) = delete;
+  TrainingDataWriter(TrainingDataWriter&&) = delete;
+
+  ~TrainingDataWriter();
+
+  bool open(const std::string& path, bool compress);
+
+  bool close();
+
+  /**
+   * Append a record.
+   * The first move of each PV is the move at the position.
+   */
+  bool write(const Position& pos,
+             const std::vector<std::vector<Move>>& pvs);
+
+  uint64_t getFileSize() const {
+    return offset_;
+  }
+
+  uint64_t getRawSize() const {
+    return rawSize_;
+  }
+
+private:
+
+  bool flushBlock();
+
+  bool writeBytes(const void* data, size_t size);
+
+private:
+
+  std::ofstream file_;
+  bool compress_;
+  std::vector<uint8_t> buffer_;
+  std::vector<uint8_t> compressed_;
+  uint32_t numberOfRecords_;
+  std::vector<TrainingData::Block> blocks_;
+  uint64_t offset_;
+  uint64_t rawSize_;
+
+};
+
+class TrainingDataReader {
+public:
+
+  TrainingDataReader();
+  TrainingDataReader(const TrainingDataReader&) = delete;
+  TrainingDataReader(TrainingDataReader&&) = delete;
+
+  /**
+   * Open the file and read the block index.
+   */
+  bool open(const std::string& path);
+
+  const std::vector<TrainingData::Block>& getBlocks() const {
+    return blocks_;
+  }
+
+  /**
+   * Limit the blocks to read to [begin, end).
+   */
+  void setBlockRange(size_t begin, size_t end);
+
+  /**
+   * Read the next record.
+   * This returns false at the end of the range or on error.
+   */
+  bool read(MutablePosition& mp,
+            std::vector<std::vector<Move>>& pvs);
+
+  bool isError() const {
+    return error_;
+  }
+
+private:
+
+  bool readBlock();
+
+  bool readBytes(void* data, size_t size);
+
+private:
+
+  std::ifstream file_;
+  std::string path_;
+  bool compressed_;
+  std::vector<TrainingData::Block> blocks_;
+  size_t nextBlock_;
+  size_t endBlock_;
+  std::vector<uint8_t> buffer_;
+  std::vector<uint8_t> stored_;
+  size_t position_;
+  uint32_t remainingRecords_;
+  bool error_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_LEARN_BATCH_TRAININGDATA_HPP__
@@ -0,0 +1,216 @@
+/* TrainingDataGenerator.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "learn/batch/TrainingDataGenerator.hpp"
+#include "learn/batch/Gradient.hpp"
+#include "search/Searcher.hpp"
+#include "core/move/MoveGenerator.hpp"
+#include "core/record/RecordReader.hpp"
+#include "common/time/Timer.hpp"
+#include "logger/Logger.hpp"
+#include <sstream>
+#include <utility>
+
+namespace sunfish {
+
+TrainingDataGenerator::TrainingDataGenerator(std::shared_ptr<Evaluator> evaluator,
+                                             const Config& config) :
+    evaluator_(evaluator),
+    config_(config),
+    failLoss_(0),
+    numberOfData_(0) {
+}
+
+std::string TrainingDataGenerator::trainingDataPath(unsigned tn) {
+  std::ostringstream oss;
+  oss << "out/training" << tn << ".dat";
+  return oss.str();
+}
+
+bool TrainingDataGenerator::generate() {
+  RecordReader reader;
+  if (!reader.open(config_.kifuDir)) {
+    return false;
+  }
+
+  if (reader.size() == 0) {
+    LOG(error) << "records not found";
+    return false;
+  }
+
+  Timer timer;
+  timer.start();
+
+  std::vector<GenTrDataThread> threads(config_.numThreads);
+
+  for (unsigned tn = 0; tn < threads.size(); tn++) {
+    auto& th = threads[tn];
+
+    if (!th.writer.open(trainingDataPath(tn), config_.compress)) {
+      return false;
+    }
+
+    th.reader = &reader;
+    th.searcher.reset(new Searcher(evaluator_));
+    th.failLoss = 0;
+    th.numberOfData = 0;
+  }
+
+  for (unsigned tn = 0; tn < threads.size(); tn++) {
+    auto& th = threads[tn];
+    th.thread = std::thread([this, &th]() {
+      generate(th);
+    });
+  }
+
+  for (auto& th : threads) {
+    if (th.thread.joinable()) {
+      th.thread.join();
+    }
+  }
+
+  failLoss_ = 0;
+  numberOfData_ = 0;
+  uint64_t fileSize = 0;
+  uint64_t rawSize = 0;
+  bool ok = true;
+  for (auto& th : threads) {
+    failLoss_ += th.failLoss;
+    numberOfData_ += th.numberOfData;
+    ok = th.writer.close() && ok;
+    fileSize += th.writer.getFileSize();
+    rawSize += th.writer.getRawSize();
+  }
+
+  if (!ok) {
+    LOG(error) << "failed to write the training data";
+    return false;
+  }
+
+  MSG(info) << "training data: size=" << (fileSize / 1024) << "KB"
+            << " raw=" << (rawSize / 1024) << "KB"
+            << " elapsed=" << timer.elapsed();
+
+  return true;
+}
+
+void TrainingDataGenerator::generate(GenTrDataThread& th) {
+  Record record;
+  while (th.reader->next(record)) {
+    generate(th, record);
+  }
+}
+
+void TrainingDataGenerator::generate(GenTrDataThread& th,
+                                     const Record& record) {
+  th.searcher->clean();
+
+  Position pos = record.initialPosition;
+  for (const auto& move : record.moveList) {
+    generate(th, pos, move);
+
+    Piece captured;
+    if (!pos.doMove(move, captured)) {
+      LOG(error) << "an illegal move is detected: " << move.toString(pos) << "\n"
+                 << pos.toString();
+      return;
+    }
+  }
+}
+
+void TrainingDataGenerator::generate(GenTrDataThread& th,
+                                     Position& pos,
+                                     Move bestMove) {
+  int depth = Searcher::Depth1Ply * config_.depth + Searcher::Depth1Ply / 2;
+  struct Data {
+    Move move;
+    PV pv;
+  };
+  std::vector<Data> results;
+  std::vector<RootMoveResult> rootResults;
+
+  Moves moves;
+  moves.add(bestMove);
+  th.searcher->searchRootMoves(pos,
+                               depth,
+                               -Score::mate(),
+                               Score::mate(),
+                               moves,
+                               rootResults);
+
+  if (rootResults.empty()) {
+    LOG(error) << "an illegal move is detected: " << bestMove.toString(pos) << "\n"
+               << pos.toString();
+    return;
+  }
+
+  Score score = rootResults[0].score;
+  if (score >= Score::mate() || score <= -Score::mate()) {
+    return;
+  }
+  Score alpha = score - LearningWindow;
+  Score beta = score + LearningWindow;
+  results.push_back({ bestMove, rootResults[0].pv });
+
+  moves.clear();
+  auto cs = pos.getCheckState();
+  if (!isCheck(cs)) {
+    MoveGenerator::generateCaptures(pos, moves);
+    MoveGenerator::generateQuiets(pos, moves);
+  } else {
+    MoveGenerator::generateEvasions(pos, cs, moves);
+  }
+
+  for (auto ite = moves.begin(); ite != moves.end(); ) {
+    if (*ite == bestMove) {
+      ite = moves.remove(ite);
+    } else {
+      ite++;
+    }
+  }
+
+  // all the other moves are searched in one call,
+  // so that the searcher is set up only once.
+  th.searcher->searchRootMoves(pos,
+                               depth,
+                               alpha,
+                               beta,
+                               moves,
+                               rootResults);
+
+  for (const auto& result : rootResults) {
+    // fail-low
+    if (result.score <= alpha) {
+      continue;
+    }
+
+    // fail-high
+    if (result.score >= beta) {
+      th.failLoss++;
+      continue;
+    }
+
+    results.push_back({ result.move, result.pv });
+  }
+
+  th.numberOfData++;
+
+  if (results.size() == 1) {
+    return;
+  }
+
+  std::vector<std::vector<Move>> pvs(results.size());
+  for (unsigned i = 0; i < results.size(); i++) {
+    const auto& result = results[i];
+    auto& pv = pvs[i];
+    pv.push_back(result.move);
+    for (unsigned j = 0; j < result.pv.size(); j++) {
+      pv.push_back(result.pv.getMove(j));
+    }
+  }
+  th.writer.write(pos, pvs);
+}
+
+} // namespace sunfish
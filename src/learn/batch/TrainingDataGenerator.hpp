@@ -0,0 +1,100 @@
+/* TrainingDataGenerator.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_LEARN_BATCH_TRAININGDATAGENERATOR_HPP__
+#define SUNFISH_LEARN_BATCH_TRAININGDATAGENERATOR_HPP__
+
+#include "core/move/Move.hpp"
+#include "core/position/Position.hpp"
+#include "core/record/Record.hpp"
+#include "search/eval/Evaluator.hpp"
+#include "learn/batch/TrainingData.hpp"
+#include <thread>
+#include <vector>
+#include <string>
+#include <memory>
+
+namespace sunfish {
+
+class Searcher;
+class RecordReader;
+
+/**
+ * Search the positions of the records and write the PVs of the moves
+ * which are in the window around the move played.
+ * Each thread writes trainingDataPath(tn).
+ */
+class TrainingDataGenerator {
+public:
+
+  struct Config {
+    std::string kifuDir;
+    int numThreads;
+    int depth;
+    bool compress;
+  };
+
+private:
+
+  struct GenTrDataThread {
+    std::thread thread;
+    RecordReader* reader;
+    TrainingDataWriter writer;
+    std::unique_ptr<Searcher> searcher;
+    int failLoss;
+    int numberOfData;
+  };
+
+public:
+
+  TrainingDataGenerator(std::shared_ptr<Evaluator> evaluator,
+                        const Config& config);
+
+  TrainingDataGenerator(const TrainingDataGenerator&) = delete;
+  TrainingDataGenerator(TrainingDataGenerator&&) = delete;
+
+  bool generate();
+
+  /**
+   * The number of moves which are better than the move played
+   * beyond the window.
+   */
+  int getFailLoss() const {
+    return failLoss_;
+  }
+
+  /**
+   * The number of positions searched.
+   */
+  int getNumberOfData() const {
+    return numberOfData_;
+  }
+
+  static std::string trainingDataPath(unsigned tn);
+
+private:
+
+  void generate(GenTrDataThread& th);
+
+  void generate(GenTrDataThread& th,
+                const Record& record);
+
+  void generate(GenTrDataThread& th,
+                Position& pos,
+                Move bestMove);
+
+private:
+
+  std::shared_ptr<Evaluator> evaluator_;
+  Config config_;
+
+  int failLoss_;
+  int numberOfData_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_LEARN_BATCH_TRAININGDATAGENERATOR_HPP__
@@ -0,0 +1,507 @@
+/* OnlineLearning.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "learn/online/OnlineLearning.hpp"
+#include "learn/batch/TrainingDataGenerator.hpp"
+#include "search/eval/FeatureTemplates.hpp"
+#include "common/resource/Resource.hpp"
+#include "common/string/StringUtil.hpp"
+#include "common/thread/Parallel.hpp"
+#include "logger/Logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const char* const OnlineLearnIni = "config/online_learn.ini";
+CONSTEXPR_CONST int DefaultIteration = 8;
+CONSTEXPR_CONST int DefaultEpoch = 4;
+CONSTEXPR_CONST int DefaultMiniBatchSize = 256;
+CONSTEXPR_CONST int DefaultDepth = 2;
+CONSTEXPR_CONST float DefaultLearningRate = 1.0f;
+CONSTEXPR_CONST float DefaultNorm = 1.0e-2f;
+CONSTEXPR_CONST int DefaultQuantizeInterval = 16;
+
+CONSTEXPR_CONST size_t UpdateBlockSize = 64 * 1024;
+
+CONSTEXPR_CONST float Int16Max = 32767.0f;
+CONSTEXPR_CONST float Int16Min = -32768.0f;
+
+CONSTEXPR_CONST float AdamBeta1 = 0.9f;
+CONSTEXPR_CONST float AdamBeta2 = 0.999f;
+CONSTEXPR_CONST float Epsilon = 1.0e-8f;
+
+inline float norm(float x, float n) {
+  if      (x > 0.0f) { return -n; }
+  else if (x < 0.0f) { return n; }
+  else               { return 0.0f; }
+}
+
+} // namespace
+
+namespace sunfish {
+
+OnlineLearning::OnlineLearning() :
+    evaluator_(std::make_shared<Evaluator>(Evaluator::InitType::Zero)),
+    fv_(new Evaluator::FVType),
+    steps_(0) {
+}
+
+bool OnlineLearning::run() {
+  MSG(info) << "####################################################################";
+  MSG(info) << "##                         OnlineLearning                         ##";
+  MSG(info) << "####################################################################";
+
+  timer_.start();
+
+  readConfigFromIniFile();
+  if (!validateConfig()) {
+    return false;
+  }
+
+  bool ok = iterate();
+  if (!ok) {
+    return false;
+  }
+
+  auto elapsed = timer_.elapsed();
+  MSG(info) << "completed";
+  MSG(info) << "elapsed: " << elapsed;
+
+  return true;
+}
+
+void OnlineLearning::readConfigFromIniFile() {
+  auto ini = Resource::ini(OnlineLearnIni);
+
+  config_.kifuDir           = getValue(ini, "Learn", "KifuDir");
+  config_.iteration         = StringUtil::toInt(getValue(ini, "Learn", "Iteration"), DefaultIteration);
+  config_.epoch             = StringUtil::toInt(getValue(ini, "Learn", "Epoch"), DefaultEpoch);
+  config_.miniBatchSize     = StringUtil::toInt(getValue(ini, "Learn", "MiniBatchSize"), DefaultMiniBatchSize);
+  config_.restart           = StringUtil::toInt(getValue(ini, "Learn", "Restart"), 0);
+  config_.numThreads        = StringUtil::toInt(getValue(ini, "Learn", "NumThreads"), std::thread::hardware_concurrency());
+  config_.depth             = StringUtil::toInt(getValue(ini, "Learn", "Depth"), DefaultDepth);
+  config_.learningRate      = StringUtil::toFloat(getValue(ini, "Learn", "LearningRate"), DefaultLearningRate);
+  config_.norm              = StringUtil::toFloat(getValue(ini, "Learn", "Norm"), DefaultNorm);
+  config_.quantizeInterval  = StringUtil::toInt(getValue(ini, "Learn", "QuantizeInterval"), DefaultQuantizeInterval);
+  config_.compressTrainingData = StringUtil::toInt(getValue(ini, "Learn", "CompressTrainingData"), 0);
+
+  auto optimizer = getValue(ini, "Learn", "Optimizer");
+  if (optimizer == "sgd") {
+    config_.optimizer = OptimizerType::SGD;
+  } else if (optimizer == "adagrad") {
+    config_.optimizer = OptimizerType::Adagrad;
+  } else {
+    if (!optimizer.empty() && optimizer != "adam") {
+      LOG(warning) << "unknown optimizer: " << optimizer;
+    }
+    config_.optimizer = OptimizerType::Adam;
+  }
+
+  MSG(info) << "KifuDir         : " << config_.kifuDir;
+  MSG(info) << "Iteration       : " << config_.iteration;
+  MSG(info) << "Epoch           : " << config_.epoch;
+  MSG(info) << "MiniBatchSize   : " << config_.miniBatchSize;
+  MSG(info) << "Restart         : " << config_.restart;
+  MSG(info) << "NumThreads      : " << config_.numThreads;
+  MSG(info) << "Depth           : " << config_.depth;
+  MSG(info) << "Optimizer       : " << (config_.optimizer == OptimizerType::SGD ? "sgd" :
+                                        config_.optimizer == OptimizerType::Adagrad ? "adagrad" : "adam");
+  MSG(info) << "LearningRate    : " << config_.learningRate;
+  MSG(info) << "Norm            : " << config_.norm;
+  MSG(info) << "QuantizeInterval: " << config_.quantizeInterval;
+  MSG(info) << "CompressTrainingData: " << config_.compressTrainingData;
+}
+
+bool OnlineLearning::validateConfig() {
+  if (config_.numThreads <= 0) {
+    LOG(error) << "NumThreads shall not be less than 1.";
+    return false;
+  }
+
+  if (config_.miniBatchSize <= 0) {
+    LOG(error) << "MiniBatchSize shall not be less than 1.";
+    return false;
+  }
+
+  if (config_.quantizeInterval <= 0) {
+    LOG(error) << "QuantizeInterval shall not be less than 1.";
+    return false;
+  }
+
+  return true;
+}
+
+bool OnlineLearning::iterate() {
+  if (config_.restart) {
+    load(*fv_);
+  } else {
+    memset(reinterpret_cast<void*>(fv_.get()), 0, sizeof(Evaluator::FVType));
+  }
+
+  shadow_.reset(new ShadowType);
+  {
+    auto fv = reinterpret_cast<const int16_t*>(fv_.get());
+    auto shadow = reinterpret_cast<float*>(shadow_.get());
+    size_t size = sizeof(Evaluator::FVType) / sizeof(int16_t);
+    for (size_t i = 0; i < size; i++) {
+      shadow[i] = fv[i];
+    }
+  }
+
+  if (config_.optimizer == OptimizerType::Adam) {
+    moment1_.reset(new ShadowType);
+    memset(reinterpret_cast<void*>(moment1_.get()), 0, sizeof(ShadowType));
+  }
+  if (config_.optimizer != OptimizerType::SGD) {
+    moment2_.reset(new ShadowType);
+    memset(reinterpret_cast<void*>(moment2_.get()), 0, sizeof(ShadowType));
+  }
+
+  // symmetricIndex_ has the index of the symmetric pair of each element,
+  // or the index of the element itself if it has no pair.
+  symmetricIndex_.reset(new IndexType);
+  {
+    auto index = reinterpret_cast<uint32_t*>(symmetricIndex_.get());
+    size_t size = sizeof(IndexType) / sizeof(uint32_t);
+    for (size_t i = 0; i < size; i++) {
+      index[i] = static_cast<uint32_t>(i);
+    }
+  }
+  runParallel(config_.numThreads, [this](int part, int parts) {
+    symmetrize(*symmetricIndex_, [](uint32_t& e1, uint32_t& e2) {
+      std::swap(e1, e2);
+    }, part, parts);
+  });
+
+  workers_.clear();
+  for (int tn = 0; tn < config_.numThreads; tn++) {
+    workers_.emplace_back(new Worker);
+    workers_.back()->entries.resize(config_.numThreads);
+  }
+
+  quantize();
+
+  for (int i = 0; i < config_.iteration; i++) {
+    MSG(info) << "";
+    MSG(info) << "ITERATION - " << i;
+
+    MSG(info) << "generating training data..";
+
+    TrainingDataGenerator::Config config;
+    config.kifuDir = config_.kifuDir;
+    config.numThreads = config_.numThreads;
+    config.depth = config_.depth;
+    config.compress = config_.compressTrainingData;
+
+    TrainingDataGenerator generator(evaluator_, config);
+    if (!generator.generate()) {
+      return false;
+    }
+    failLoss_ = generator.getFailLoss();
+    numberOfData_ = generator.getNumberOfData();
+
+    MSG(info) << "adjusting parameters..";
+
+    memset(reinterpret_cast<void*>(mgradient_), 0, sizeof(MaterialGradient));
+
+    for (int e = 0; e < config_.epoch; e++) {
+      if (!runEpoch(i, e)) {
+        return false;
+      }
+    }
+
+    updateMaterial(mgradient_, random_);
+
+    quantize();
+
+    MSG(info) << "writing to file..";
+
+    save(*fv_);
+  }
+
+  return true;
+}
+
+bool OnlineLearning::runEpoch(int iteration, int epoch) {
+  if (numberOfData_ == 0) {
+    LOG(warning) << "there is no training data.";
+    return true;
+  }
+
+  std::vector<TrainingDataReader> readers(config_.numThreads);
+  std::vector<BlockRef> blocks;
+
+  // each file of the training data is written by a thread
+  // of TrainingDataGenerator.
+  for (unsigned fn = 0; fn < readers.size(); fn++) {
+    auto& reader = readers[fn];
+    if (!reader.open(TrainingDataGenerator::trainingDataPath(fn))) {
+      return false;
+    }
+    for (size_t bn = 0; bn < reader.getBlocks().size(); bn++) {
+      blocks.push_back({ fn, bn });
+    }
+  }
+
+  // the records in a block are read sequentially,
+  // and the order of the blocks is shuffled on each epoch.
+  random_.shuffle(blocks.begin(), blocks.end());
+
+  float epochLoss = 0.0f;
+  float windowLoss = 0.0f;
+  size_t windowRecords = 0;
+
+  auto flush = [&]() {
+    size_t records = miniBatch_.records.size();
+    float l = step();
+    epochLoss += l;
+    windowLoss += l;
+    windowRecords += records;
+
+    if (steps_ % config_.quantizeInterval == 0) {
+      quantize();
+
+      MSG(info) << "step=" << steps_
+                << " loss=" << (windowLoss / windowRecords)
+                << " elapsed=" << timer_.elapsed();
+      windowLoss = 0.0f;
+      windowRecords = 0;
+    }
+  };
+
+  MutablePosition mp;
+  std::vector<std::vector<Move>> pvs;
+  for (const auto& block : blocks) {
+    auto& reader = readers[block.fileIndex];
+    reader.setBlockRange(block.blockIndex, block.blockIndex + 1);
+
+    while (reader.read(mp, pvs)) {
+      addRecord(Position(mp), pvs);
+
+      if (miniBatch_.records.size() >= static_cast<size_t>(config_.miniBatchSize)) {
+        flush();
+      }
+    }
+
+    if (reader.isError()) {
+      return false;
+    }
+  }
+
+  if (!miniBatch_.records.empty()) {
+    flush();
+  }
+
+  // this is comparable with the loss of BatchLearning.
+  MSG(info) << "iteration=" << iteration
+            << " epoch=" << epoch
+            << " loss=" << ((failLoss_ + epochLoss) / numberOfData_)
+            << " elapsed=" << timer_.elapsed();
+
+  return true;
+}
+
+void OnlineLearning::addRecord(const Position& rootPos,
+                               const std::vector<std::vector<Move>>& pvs) {
+  auto begin = miniBatch_.positions.size();
+
+  for (const auto& pv : pvs) {
+    Position pos = rootPos;
+    for (auto& move : pv) {
+      Piece captured;
+      if (!pos.doMove(move, captured)) {
+        LOG(error) << "an illegal move is detected:\n"
+                   << pos.toString()
+                   << move.toString(pos);
+        miniBatch_.positions.resize(begin);
+        return;
+      }
+    }
+    miniBatch_.positions.push_back(pos.getMutablePosition());
+  }
+
+  miniBatch_.records.push_back({
+    static_cast<uint32_t>(begin),
+    static_cast<uint32_t>(miniBatch_.positions.size()),
+    rootPos.getTurn(),
+  });
+}
+
+float OnlineLearning::step() {
+  runParallel(config_.numThreads, [this](int part, int parts) {
+    generateGradient(*workers_[part], part, parts);
+  });
+
+  runParallel(config_.numThreads, [this](int part, int parts) {
+    scatterGradient(*workers_[part], part, parts);
+  });
+
+  steps_++;
+  runParallel(config_.numThreads, [this](int part, int) {
+    updateShadow(*workers_[part], part);
+  });
+
+  float loss = 0.0f;
+  for (auto& worker : workers_) {
+    loss += worker->loss;
+    madd(mgradient_, worker->mg);
+    worker->bg.clear();
+  }
+
+  miniBatch_.positions.clear();
+  miniBatch_.records.clear();
+
+  return loss;
+}
+
+void OnlineLearning::generateGradient(Worker& worker, int part, int parts) {
+  size_t size = miniBatch_.records.size();
+  size_t begin = size * part / parts;
+  size_t end = size * (part + 1) / parts;
+
+  std::vector<Position> positions;
+  std::vector<Score> scores;
+
+  worker.loss = 0.0f;
+  memset(reinterpret_cast<void*>(worker.mg), 0, sizeof(MaterialGradient));
+  for (size_t i = begin; i < end; i++) {
+    const auto& record = miniBatch_.records[i];
+
+    positions.clear();
+    for (uint32_t j = record.begin; j < record.end; j++) {
+      positions.emplace_back(miniBatch_.positions[j]);
+    }
+
+    extractGradient(*evaluator_,
+                    record.rootTurn,
+                    positions,
+                    scores,
+                    worker.bg,
+                    worker.mg,
+                    worker.loss);
+  }
+}
+
+void OnlineLearning::scatterGradient(Worker& worker, int part, int parts) {
+  // Each king square is read by only one thread,
+  // and the elements derived from it are sent to the threads
+  // which own the ranges of the indices.
+  // An element and its symmetric pair share the gradient,
+  // so the gradient is sent only for the smaller index of them.
+  size_t size = sizeof(IndexType) / sizeof(uint32_t);
+  size_t rangeSize = (size + parts - 1) / parts;
+  auto index = reinterpret_cast<const uint32_t*>(symmetricIndex_.get());
+  const IndexType& symmetricIndex = *symmetricIndex_;
+
+  for (int king = part; king < Square::N; king += parts) {
+    for (const auto& w : workers_) {
+      auto block = w->bg.getBlock(king);
+      if (block == nullptr) {
+        continue;
+      }
+
+      expandRows(symmetricIndex, Square(king), *block, [&worker, index, rangeSize](const uint32_t& e, float g) {
+        uint32_t i = std::min(static_cast<uint32_t>(&e - index), e);
+        worker.entries[i / rangeSize].push_back({ i, g });
+      });
+    }
+  }
+}
+
+void OnlineLearning::updateShadow(Worker& worker, int part) {
+  // The gradients of each element are summed in the order of the threads
+  // which sent them.
+  // The parameters whose gradients are zero are skipped,
+  // so that their moments are not decayed by the steps
+  // in which their features do not appear.
+  auto& merged = worker.merged;
+  merged.clear();
+  for (auto& w : workers_) {
+    auto& entries = w->entries[part];
+    merged.insert(merged.end(), entries.begin(), entries.end());
+    entries.clear();
+  }
+  std::stable_sort(merged.begin(), merged.end(), [](const GradientEntry& lhs, const GradientEntry& rhs) {
+    return lhs.index < rhs.index;
+  });
+
+  float lr = config_.learningRate;
+  float n = config_.norm;
+  float bias1 = 1.0f - std::pow(AdamBeta1, static_cast<float>(steps_));
+  float bias2 = 1.0f - std::pow(AdamBeta2, static_cast<float>(steps_));
+  auto index = reinterpret_cast<const uint32_t*>(symmetricIndex_.get());
+  auto shadow = reinterpret_cast<float*>(shadow_.get());
+  auto m1 = reinterpret_cast<float*>(moment1_.get());
+  auto m2 = reinterpret_cast<float*>(moment2_.get());
+
+  for (size_t b = 0; b < merged.size(); ) {
+    uint32_t i = merged[b].index;
+    float sum = 0.0f;
+    for (; b < merged.size() && merged[b].index == i; b++) {
+      sum += merged[b].value;
+    }
+    if (sum == 0.0f) {
+      continue;
+    }
+
+    float& w = shadow[i];
+    float g = sum + norm(w, n);
+    switch (config_.optimizer) {
+    case OptimizerType::SGD:
+      w += lr * g;
+      break;
+    case OptimizerType::Adagrad:
+      m2[i] += g * g;
+      w += lr * g / (std::sqrt(m2[i]) + Epsilon);
+      break;
+    case OptimizerType::Adam:
+      m1[i] = AdamBeta1 * m1[i] + (1.0f - AdamBeta1) * g;
+      m2[i] = AdamBeta2 * m2[i] + (1.0f - AdamBeta2) * g * g;
+      w += lr * (m1[i] / bias1) / (std::sqrt(m2[i] / bias2) + Epsilon);
+      break;
+    }
+    w = std::min(std::max(w, Int16Min), Int16Max);
+
+    // no gradient is sent for the larger index of the pair,
+    // so the pair is written only by this thread.
+    uint32_t r = index[i];
+    if (r != i) {
+      shadow[r] = w;
+      if (m1 != nullptr) { m1[r] = m1[i]; }
+      if (m2 != nullptr) { m2[r] = m2[i]; }
+    }
+  }
+}
+
+void OnlineLearning::quantize() {
+  size_t size = sizeof(Evaluator::FVType) / sizeof(int16_t);
+  size_t numberOfBlocks = (size + UpdateBlockSize - 1) / UpdateBlockSize;
+  runParallel(config_.numThreads, [this, size, numberOfBlocks](int part, int parts) {
+    auto fv = reinterpret_cast<int16_t*>(fv_.get());
+    auto shadow = reinterpret_cast<const float*>(shadow_.get());
+    for (size_t b = part; b < numberOfBlocks; b += parts) {
+      size_t end = std::min((b + 1) * UpdateBlockSize, size);
+      for (size_t i = b * UpdateBlockSize; i < end; i++) {
+        fv[i] = static_cast<int16_t>(std::round(shadow[i]));
+      }
+    }
+  });
+
+  runParallel(config_.numThreads, [this](int part, int parts) {
+    symmetrize(*fv_, [](int16_t& e1, int16_t& e2) {
+      e1 = e2;
+    }, part, parts);
+  });
+
+  runParallel(config_.numThreads, [this](int part, int parts) {
+    optimize(*fv_, evaluator_->ofv(), part, parts);
+  });
+
+  evaluator_->onChanged(Evaluator::DataSourceType::Custom);
+}
+
+} // namespace sunfish
@@ -0,0 +1,146 @@
+/* OnlineLearning.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_LEARN_ONLINE_ONLINELEARNING_HPP__
+#define SUNFISH_LEARN_ONLINE_ONLINELEARNING_HPP__
+
+#include "common/time/Timer.hpp"
+#include "common/math/Random.hpp"
+#include "core/move/Move.hpp"
+#include "core/position/Position.hpp"
+#include "search/eval/Evaluator.hpp"
+#include "learn/batch/Gradient.hpp"
+#include "learn/batch/TrainingData.hpp"
+#include <vector>
+#include <string>
+#include <memory>
+
+namespace sunfish {
+
+/**
+ * The mini-batch learning.
+ * The parameters are updated by an adaptive optimizer
+ * on the float shadow of the feature vector,
+ * and the shadow is quantized into the int16 feature vector periodically.
+ * Each step updates only the elements derived from the king squares
+ * touched by the mini-batch, and the whole feature vector is scanned
+ * only by the quantization.
+ * The material scores are updated at the end of each iteration
+ * in the same way as BatchLearning.
+ */
+class OnlineLearning {
+public:
+
+  enum class OptimizerType {
+    SGD,
+    Adagrad,
+    Adam,
+  };
+
+  struct Config {
+    std::string kifuDir;
+    int iteration;
+    int epoch;
+    int miniBatchSize;
+    int restart;
+    int numThreads;
+    int depth;
+    OptimizerType optimizer;
+    float learningRate;
+    float norm;
+    int quantizeInterval;
+    bool compressTrainingData;
+  };
+
+private:
+
+  using ShadowType = FeatureVector<float>;
+  using IndexType = FeatureVector<uint32_t>;
+
+  struct GradientEntry {
+    uint32_t index;
+    float value;
+  };
+
+  struct LeafRecord {
+    uint32_t begin;
+    uint32_t end;
+    Turn rootTurn;
+  };
+
+  struct MiniBatch {
+    std::vector<MutablePosition> positions;
+    std::vector<LeafRecord> records;
+  };
+
+  struct Worker {
+    BlockedGradient bg;
+    MaterialGradient mg;
+    float loss;
+    std::vector<std::vector<GradientEntry>> entries;
+    std::vector<GradientEntry> merged;
+  };
+
+  struct BlockRef {
+    unsigned fileIndex;
+    size_t blockIndex;
+  };
+
+public:
+
+  OnlineLearning();
+
+  bool run();
+
+private:
+
+  void readConfigFromIniFile();
+
+  bool validateConfig();
+
+  bool iterate();
+
+  bool runEpoch(int iteration, int epoch);
+
+  void addRecord(const Position& rootPos,
+                 const std::vector<std::vector<Move>>& pvs);
+
+  float step();
+
+  void generateGradient(Worker& worker, int part, int parts);
+
+  void scatterGradient(Worker& worker, int part, int parts);
+
+  void updateShadow(Worker& worker, int part);
+
+  void quantize();
+
+private:
+
+  Config config_;
+  Timer timer_;
+  Random random_;
+
+  int failLoss_;
+  int numberOfData_;
+
+  std::shared_ptr<Evaluator> evaluator_;
+  std::unique_ptr<Evaluator::FVType> fv_;
+  std::unique_ptr<ShadowType> shadow_;
+  std::unique_ptr<ShadowType> moment1_;
+  std::unique_ptr<ShadowType> moment2_;
+  std::unique_ptr<IndexType> symmetricIndex_;
+  MaterialGradient mgradient_;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  MiniBatch miniBatch_;
+
+  int64_t steps_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_LEARN_ONLINE_ONLINELEARNING_HPP__
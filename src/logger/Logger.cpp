@@ -5,14 +5,129 @@
 
 #include "logger/Logger.hpp"
 #include "common/Def.hpp"
+#include <condition_variable>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include <chrono>
 #include <ctime>
+#include <csignal>
+#include <cstdlib>
+
+namespace {
+
+using namespace sunfish;
+
+struct LogEntry {
+  uint64_t sequence;
+  Logger* logger;
+  std::time_t time;
+  std::string message;
+};
+
+/**
+ * A single-producer single-consumer ring buffer.
+ */
+class LogRing {
+public:
+
+  explicit LogRing(size_t size) :
+      entries_(size),
+      head_(0),
+      tail_(0),
+      closed_(false) {
+  }
+
+  LogRing(const LogRing&) = delete;
+  LogRing(LogRing&&) = delete;
+
+  bool push(LogEntry&& entry) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == entries_.size()) {
+      return false;
+    }
+
+    entries_[tail % entries_.size()] = std::move(entry);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(LogEntry& entry) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    entry = std::move(entries_[head % entries_.size()]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+  void close() {
+    closed_ = true;
+  }
+
+  bool isClosed() const {
+    return closed_;
+  }
+
+private:
+
+  std::vector<LogEntry> entries_;
+  std::atomic<size_t> head_;
+  std::atomic<size_t> tail_;
+  std::atomic<bool> closed_;
+
+};
+
+/**
+ * The ring buffer of the thread.
+ * It is closed when the thread exits, and removed after it is drained.
+ */
+struct LogRingHolder {
+  std::shared_ptr<LogRing> ring;
+
+  ~LogRingHolder() {
+    if (ring) {
+      ring->close();
+    }
+  }
+};
+
+thread_local LogRingHolder ringHolder;
+
+std::atomic<bool> running(false);
+std::atomic<uint64_t> sequence(0);
+std::atomic<uint64_t> droppedLines(0);
+uint64_t reportedDroppedLines = 0;
+AsyncLogger::OverflowPolicy overflowPolicy = AsyncLogger::OverflowPolicy::Drop;
+size_t ringSize = AsyncLogger::DefaultRingSize;
+
+std::mutex registryMutex;
+std::vector<std::shared_ptr<LogRing>> rings;
+
+std::mutex drainMutex;
+std::mutex threadMutex;
+std::condition_variable drainCondition;
+bool stopRequested = false;
+std::thread drainThread;
+
+const int CrashSignals[] = { SIGABRT, SIGSEGV, SIGFPE, SIGILL };
+
+} // namespace
 
 namespace sunfish {
 
 std::string LoggerUtil::getIso8601() {
   using namespace std::chrono;
-  std::time_t t = duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+  return getIso8601(system_clock::to_time_t(system_clock::now()));
+}
+
+std::string LoggerUtil::getIso8601(std::time_t t) {
   std::tm m;
 #ifdef WIN32
   gmtime_s(&m, &t);
@@ -24,6 +139,9 @@ std::string LoggerUtil::getIso8601() {
   return std::string(buf);
 }
 
+CONSTEXPR_CONST size_t AsyncLogger::DefaultRingSize;
+CONSTEXPR_CONST int AsyncLogger::DefaultDrainIntervalMs;
+
 std::mutex Logger::mutex_;
 Logger Loggers::error  ("[ERROR]");
 Logger Loggers::warning("[WARN] ");
@@ -34,4 +152,222 @@ Logger Loggers::receive("[RECV] ");
 Logger Loggers::debug  ("[DEBUG]");
 #endif //NDEBUG
 
+void Logger::write(std::string&& message) {
+  if (os_.empty()) {
+    return;
+  }
+
+  if (AsyncLogger::push(this, std::move(message))) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  writeNoLock(std::time(nullptr), message);
+  flushNoLock();
+}
+
+void Logger::writeNoLock(std::time_t time, const std::string& message) {
+  for (const auto& s : os_) {
+    // prefix
+    if (s.before != nullptr) {
+      *(s.pout) << s.before;
+    }
+
+    // timestamp
+    if (s.timestamp) {
+      *(s.pout) << LoggerUtil::getIso8601(time);
+    }
+
+    // logger name
+    if (s.loggerName && name_) {
+      *(s.pout) << name_ << ' ';
+    }
+
+    // main data
+    *(s.pout) << message;
+
+    // suffix
+    if (s.after != nullptr) {
+      *(s.pout) << s.after;
+    }
+
+    *(s.pout) << '\n';
+  }
+}
+
+void Logger::flushNoLock() {
+  for (const auto& s : os_) {
+    s.pout->flush();
+  }
+}
+
+void AsyncLogger::start(OverflowPolicy policy/* = OverflowPolicy::Drop*/,
+                        size_t size/* = DefaultRingSize*/) {
+  std::lock_guard<std::mutex> lock(threadMutex);
+  if (running) {
+    return;
+  }
+
+  overflowPolicy = policy;
+  ringSize = std::max(size, static_cast<size_t>(1));
+  stopRequested = false;
+
+  static bool isHandlerInstalled = false;
+  if (!isHandlerInstalled) {
+    std::atexit(stop);
+
+    for (int sig : CrashSignals) {
+      std::signal(sig, [](int sig) {
+        // best effort: the faulting thread may hold a mutex of the logger,
+        // so the lines are not written unless all of them are free.
+        flush(true);
+        std::signal(sig, SIG_DFL);
+        std::raise(sig);
+      });
+    }
+
+    isHandlerInstalled = true;
+  }
+
+  drainThread = std::thread([]() {
+    std::unique_lock<std::mutex> lock(threadMutex);
+    while (!stopRequested) {
+      drainCondition.wait_for(lock, std::chrono::milliseconds(DefaultDrainIntervalMs));
+      lock.unlock();
+      flush();
+      lock.lock();
+    }
+  });
+
+  running = true;
+}
+
+void AsyncLogger::stop() {
+  {
+    std::lock_guard<std::mutex> lock(threadMutex);
+    if (!running) {
+      return;
+    }
+
+    // the following lines are written synchronously.
+    running = false;
+    stopRequested = true;
+  }
+  drainCondition.notify_one();
+
+  drainThread.join();
+
+  flush();
+}
+
+void AsyncLogger::flush() {
+  flush(false);
+}
+
+void AsyncLogger::flush(bool tryLock) {
+  std::unique_lock<std::mutex> drainLock(drainMutex, std::defer_lock);
+  std::unique_lock<std::mutex> registryLock(registryMutex, std::defer_lock);
+  std::unique_lock<std::mutex> loggerLock(Logger::mutex_, std::defer_lock);
+
+  if (tryLock) {
+    if (std::try_lock(drainLock, registryLock, loggerLock) != -1) {
+      return;
+    }
+  } else {
+    drainLock.lock();
+    registryLock.lock();
+  }
+
+  std::vector<LogEntry> entries;
+  for (auto& ring : rings) {
+    LogEntry entry;
+    while (ring->pop(entry)) {
+      entries.push_back(std::move(entry));
+    }
+  }
+
+  rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::shared_ptr<LogRing>& ring) {
+    return ring->isClosed() && ring->empty();
+  }), rings.end());
+
+  if (!tryLock) {
+    registryLock.unlock();
+  }
+
+  uint64_t dropped = droppedLines;
+  if (entries.empty() && dropped == reportedDroppedLines) {
+    return;
+  }
+
+  // the lines of the different threads are written in order.
+  std::sort(entries.begin(), entries.end(), [](const LogEntry& lhs, const LogEntry& rhs) {
+    return lhs.sequence < rhs.sequence;
+  });
+
+  if (!tryLock) {
+    loggerLock.lock();
+  }
+
+  std::vector<Logger*> loggers;
+  for (const auto& entry : entries) {
+    entry.logger->writeNoLock(entry.time, entry.message);
+    if (std::find(loggers.begin(), loggers.end(), entry.logger) == loggers.end()) {
+      loggers.push_back(entry.logger);
+    }
+  }
+
+  if (dropped != reportedDroppedLines) {
+    Loggers::warning.writeNoLock(std::time(nullptr),
+        std::to_string(dropped - reportedDroppedLines) + " lines of the log were dropped");
+    Loggers::warning.flushNoLock();
+    reportedDroppedLines = dropped;
+  }
+
+  for (auto logger : loggers) {
+    logger->flushNoLock();
+  }
+}
+
+bool AsyncLogger::isRunning() {
+  return running;
+}
+
+uint64_t AsyncLogger::getNumberOfDroppedLines() {
+  return droppedLines;
+}
+
+bool AsyncLogger::push(Logger* logger, std::string&& message) {
+  if (!running) {
+    return false;
+  }
+
+  if (!ringHolder.ring) {
+    ringHolder.ring = std::make_shared<LogRing>(ringSize);
+    std::lock_guard<std::mutex> lock(registryMutex);
+    rings.push_back(ringHolder.ring);
+  }
+
+  LogEntry entry = { sequence++, logger, std::time(nullptr), std::move(message) };
+
+  while (!ringHolder.ring->push(std::move(entry))) {
+    if (overflowPolicy == OverflowPolicy::Drop) {
+      droppedLines++;
+      return true;
+    }
+
+    drainCondition.notify_one();
+    std::this_thread::yield();
+
+    if (!running) {
+      // stopped while waiting
+      std::lock_guard<std::mutex> lock(Logger::mutex_);
+      logger->writeNoLock(entry.time, entry.message);
+      logger->flushNoLock();
+      return true;
+    }
+  }
+
+  return true;
+}
+
 } // namespace sunfish
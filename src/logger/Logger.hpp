@@ -6,13 +6,16 @@
 #ifndef SUNFISH_LOGGER_LOGGER_HPP__
 #define SUNFISH_LOGGER_LOGGER_HPP__
 
+#include "common/Def.hpp"
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <string>
 #include <ctime>
 #include <mutex>
 #include <memory>
 #include <utility>
+#include <cstdint>
 
 #define __FILE_LINE__ (__FILE__ ":" __L2STR(__LINE__))
 #define __L2STR(l) L2STR__(l)
@@ -29,6 +32,8 @@ public:
 
   static std::string getIso8601();
 
+  static std::string getIso8601(std::time_t t);
+
 };
 
 class Logger {
@@ -42,49 +47,36 @@ private:
     const char* after;
   };
 
-  enum class LineState {
-    Top,
-    Normal,
-    End,
-    All,
-  };
-
 public:
 
   class SubLogger {
   private:
     struct Data {
       Logger* plogger;
-      std::lock_guard<std::mutex> lock;
+      std::ostringstream oss;
       const char* fileline;
       Data(Logger* plogger,
-           std::mutex& mutex,
            const char* fileline) :
           plogger(plogger),
-          lock(mutex),
           fileline(fileline) {
       }
       ~Data() {
         if (fileline != nullptr) {
-          plogger->printNoLock<LineState::Normal>(" (");
-          plogger->printNoLock<LineState::Normal>(fileline);
-          plogger->printNoLock<LineState::End>(')');
-        } else {
-          plogger->printNoLock<LineState::End>("");
+          oss << " (" << fileline << ')';
         }
+        plogger->write(oss.str());
       }
     };
     std::shared_ptr<Data> data;
 
   public:
     SubLogger(Logger* plogger,
-              std::mutex& mutex,
               const char* fileline) {
-      data = std::make_shared<Data>(plogger, mutex, fileline);
+      data = std::make_shared<Data>(plogger, fileline);
     }
     template <class T>
     SubLogger& operator<<(T&& t) {
-      data->plogger->printNoLock<LineState::Normal>(std::forward<T>(t));
+      data->oss << std::forward<T>(t);
       return *this;
     }
   };
@@ -96,6 +88,7 @@ public:
 
   void addStream(std::ostream& o, bool timestamp, bool loggerName,
       const char* before, const char* after) {
+    std::lock_guard<std::mutex> lock(mutex_);
     Stream s = { &o, timestamp, loggerName, before, after };
     os_.push_back(s);
   }
@@ -110,61 +103,35 @@ public:
   }
 
   template <class T> void print(T&& t) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    printNoLock<LineState::All>(std::forward<T>(t));
+    std::ostringstream oss;
+    oss << std::forward<T>(t);
+    write(oss.str());
   }
 
   template <class T>
   SubLogger operator<<(T&& t) {
-    SubLogger s(this, mutex_, nullptr);
-    printNoLock<LineState::Top>(std::forward<T>(t));
+    SubLogger s(this, nullptr);
+    s << std::forward<T>(t);
     return s;
   }
 
   SubLogger getSubLogger(const char* fileline) {
-    SubLogger s(this, mutex_, fileline);
-    printNoLock<LineState::Top>("");
-    return s;
+    return SubLogger(this, fileline);
   }
 
-private:
+  /**
+   * Write a line to the streams.
+   * The line is passed to AsyncLogger if it is running.
+   */
+  void write(std::string&& message);
 
-  template <LineState ls, class T>
-  void printNoLock(T&& t) {
-    std::vector<Stream>::iterator it;
-    for (it = os_.begin(); it != os_.end(); it++) {
-      if (ls == LineState::Top || ls == LineState::All) {
-        // prefix
-        if (it->before != nullptr) {
-          *(it->pout) << it->before;
-        }
-
-        // timestamp
-        if (it->timestamp) {
-          *(it->pout) << LoggerUtil::getIso8601();
-        }
+private:
 
-        // logger name
-        if (it->loggerName && name_) {
-          *(it->pout) << name_ << ' ';
-        }
-      }
+  friend class AsyncLogger;
 
-      // main data
-      *(it->pout) << std::forward<T>(t);
+  void writeNoLock(std::time_t time, const std::string& message);
 
-      if (ls == LineState::End || ls == LineState::All) {
-        // suffix
-        if (it->after != nullptr) {
-          *(it->pout) << it->after;
-        }
-
-        // flush
-        *(it->pout) << '\n';
-        it->pout->flush();
-      }
-    }
-  }
+  void flushNoLock();
 
   static std::mutex mutex_;
   const char* name_;
@@ -184,13 +151,68 @@ public:
 #endif //NDEBUG
 };
 
+/**
+ * The asynchronous backend of loggers.
+ * Each thread puts the lines into its own lock-free ring buffer,
+ * and a background thread writes them to the streams in batches.
+ */
+class AsyncLogger {
+public:
+
+  enum class OverflowPolicy {
+    /** the lines are dropped while the ring buffer is full */
+    Drop,
+    /** the thread waits until the ring buffer has a space */
+    Block,
+  };
+
+  static CONSTEXPR_CONST size_t DefaultRingSize = 1024;
+  static CONSTEXPR_CONST int DefaultDrainIntervalMs = 10;
+
+  /**
+   * Start the background thread.
+   * The lines are flushed synchronously at exit and on a crash.
+   */
+  static void start(OverflowPolicy policy = OverflowPolicy::Drop,
+                    size_t ringSize = DefaultRingSize);
+
+  /**
+   * Write all lines and stop the background thread.
+   */
+  static void stop();
+
+  /**
+   * Write all lines in the ring buffers synchronously.
+   */
+  static void flush();
+
+  static bool isRunning();
+
+  static uint64_t getNumberOfDroppedLines();
+
+private:
+
+  friend class Logger;
+
+  AsyncLogger();
+
+  static bool push(Logger* logger, std::string&& message);
+
+  /**
+   * Write all lines in the ring buffers.
+   * If tryLock is true, nothing is written while any mutex is held.
+   */
+  static void flush(bool tryLock);
+
+};
+
 #define MSG(type) sunfish::Loggers::type
 #define LOG(type) sunfish::Loggers::type.getSubLogger(__FILE_LINE__)
 
 #ifdef NDEBUG
 # define ASSERT(expression)
 #else
-# define ASSERT(expression) do { if (!((expression))) { LOG(error) << "ASSERT(" #expression ") was failed."; abort(); } } while (false);
+# define ASSERT(expression) do { if (!((expression))) { LOG(error) << "ASSERT(" #expression ") was failed."; sunfish::AsyncLogger::flush(); abort(); } } while (false);
 #endif
 
 } // namespace sunfish
@@ -18,10 +18,26 @@ struct SearchConfig {
   static CONSTEXPR_CONST TimeType DefaultOptimumTimeMs = 3 * 1000;
   static CONSTEXPR_CONST TimeType DefaultMaximumTimeMs = 3 * 1000;
   static CONSTEXPR_CONST int DefaultNumberOfThreads = 1;
+  static CONSTEXPR_CONST bool DefaultNuma = false;
+  static CONSTEXPR_CONST bool DefaultReplicateEval = false;
 
   TimeType optimumTimeMs;
   TimeType maximumTimeMs;
   int numberOfThreads;
+
+  /**
+   * Pin the threads to the NUMA nodes, place the trees on the node
+   * of each thread and interleave TT across the nodes.
+   */
+  bool numa;
+
+  /**
+   * Copy the evaluator to each NUMA node.
+   * This is effective only if numa is enabled.
+   * The copies are refreshed at the next search
+   * after Evaluator::onChanged() is called.
+   */
+  bool replicateEval;
 };
 
 inline CONSTEXPR SearchConfig getDefaultSearchConfig() {
@@ -29,6 +45,8 @@ inline CONSTEXPR SearchConfig getDefaultSearchConfig() {
     SearchConfig::DefaultOptimumTimeMs,
     SearchConfig::DefaultMaximumTimeMs,
     SearchConfig::DefaultNumberOfThreads,
+    SearchConfig::DefaultNuma,
+    SearchConfig::DefaultReplicateEval,
   };
 }
 
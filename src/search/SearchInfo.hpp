@@ -6,13 +6,26 @@
 #ifndef SUNFISH_SEARCH_SEARCHINFO_HPP__
 #define SUNFISH_SEARCH_SEARCHINFO_HPP__
 
+#include "common/Def.hpp"
 #include <iomanip>
+#include <sstream>
 #include <cstdint>
 #include <cstring>
 
+/**
+ * The counters of the search tables are collected
+ * only if SUNFISH_TABLE_STATS is 1, and remain 0 otherwise.
+ */
+#ifndef SUNFISH_TABLE_STATS
+# define SUNFISH_TABLE_STATS 0
+#endif
+
 namespace sunfish {
 
 struct SearchInfo {
+  /** the number of the bins of the depth distribution of TT entries */
+  static CONSTEXPR_CONST int TTDepthSize = 32;
+
   uint64_t nodes;
   uint64_t quiesNodes;
   uint64_t hashCut;
@@ -23,6 +36,25 @@ struct SearchInfo {
   uint64_t failHigh;
   uint64_t failHighFirst;
   uint64_t singularExtension;
+
+  // transposition table
+  uint64_t ttProbe;
+  uint64_t ttHit;
+  uint64_t ttMismatch; // the misses on the slots of the other positions
+  uint64_t ttUpdate;
+  uint64_t ttReplace;
+  uint64_t ttReject;
+  uint64_t ttDepth[TTDepthSize];
+
+  // evaluation cache
+  uint64_t evalCacheProbe;
+  uint64_t evalCacheHit;
+  uint64_t evalCacheReplace;
+
+  // SHEK table
+  uint64_t shekProbe;
+  uint64_t shekHit;
+  uint64_t shekReject;
 };
 
 inline void initializeSearchInfo(SearchInfo& info) {
@@ -40,6 +72,44 @@ inline void mergeSearchInfo(SearchInfo& dst, const SearchInfo& src) {
   dst.failHigh          += src.failHigh;
   dst.failHighFirst     += src.failHighFirst;
   dst.singularExtension += src.singularExtension;
+  dst.ttProbe           += src.ttProbe;
+  dst.ttHit             += src.ttHit;
+  dst.ttMismatch        += src.ttMismatch;
+  dst.ttUpdate          += src.ttUpdate;
+  dst.ttReplace         += src.ttReplace;
+  dst.ttReject          += src.ttReject;
+  for (int i = 0; i < SearchInfo::TTDepthSize; i++) {
+    dst.ttDepth[i]      += src.ttDepth[i];
+  }
+  dst.evalCacheProbe    += src.evalCacheProbe;
+  dst.evalCacheHit      += src.evalCacheHit;
+  dst.evalCacheReplace  += src.evalCacheReplace;
+  dst.shekProbe         += src.shekProbe;
+  dst.shekHit           += src.shekHit;
+  dst.shekReject        += src.shekReject;
+}
+
+inline uint64_t searchInfoPercentage(uint64_t n, uint64_t d) {
+  return d != 0 ? n * 100 / d : 0;
+}
+
+/**
+ * Print the depth distribution of the stored TT entries
+ * as the list of "depth:count".
+ */
+template <class T>
+inline void printTTDepth(T& os, const SearchInfo& info) {
+  bool first = true;
+  for (int i = 0; i < SearchInfo::TTDepthSize; i++) {
+    if (info.ttDepth[i] == 0) {
+      continue;
+    }
+    if (!first) {
+      os << ' ';
+    }
+    os << i << ':' << info.ttDepth[i];
+    first = false;
+  }
 }
 
 template <class T>
@@ -60,6 +130,27 @@ inline void printSearchInfo(T& os, const SearchInfo& info, float elapsed) {
   os << "probCut            : " << info.probCut;
   os << "fail high first    : " << failHighFirst << "%";
   os << "singular extension : " << info.singularExtension;
+
+#if SUNFISH_TABLE_STATS
+  os << "tt probe           : " << info.ttProbe;
+  os << "tt hit             : " << info.ttHit
+     << " (" << searchInfoPercentage(info.ttHit, info.ttProbe) << "%)";
+  os << "tt mismatch        : " << info.ttMismatch;
+  os << "tt update          : " << info.ttUpdate;
+  os << "tt replace         : " << info.ttReplace;
+  os << "tt reject          : " << info.ttReject;
+  {
+    std::ostringstream oss;
+    printTTDepth(oss, info);
+    os << "tt depth           : " << oss.str();
+  }
+  os << "eval cache hit     : " << info.evalCacheHit
+     << " (" << searchInfoPercentage(info.evalCacheHit, info.evalCacheProbe) << "%)";
+  os << "eval cache replace : " << info.evalCacheReplace;
+  os << "shek probe         : " << info.shekProbe;
+  os << "shek hit           : " << info.shekHit;
+  os << "shek reject        : " << info.shekReject;
+#endif
 }
 
 } // namespace sunfish
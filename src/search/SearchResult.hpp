@@ -20,6 +20,15 @@ struct SearchResult {
   float elapsed;
 };
 
+/**
+ * The result of a root move of Searcher::searchRootMoves.
+ */
+struct RootMoveResult {
+  Move move;
+  Score score;
+  PV pv;
+};
+
 } // namespace sunfish
 
 #endif // SUNFISH_SEARCH_SEARCHRESULT_HPP__
@@ -10,6 +10,7 @@
 #include "search/eval/Evaluator.hpp"
 #include "search/eval/Material.hpp"
 #include "core/move/MoveGenerator.hpp"
+#include "common/thread/Numa.hpp"
 #include "logger/Logger.hpp"
 #include <algorithm>
 #include <cstring>
@@ -142,6 +143,23 @@ void printMoves(const Position& pos,
 }
 #endif
 
+inline void traceEvent(Tree& tree,
+                       SearchTrace::EventType type,
+                       int depth,
+                       Score alpha,
+                       Score beta,
+                       Score score) {
+  if (tree.trace.isEnabled()) {
+    tree.trace.record(type,
+                      tree.ply,
+                      tree.nodes[0].move.serialize16(),
+                      depth,
+                      alpha.raw(),
+                      beta.raw(),
+                      score.raw());
+  }
+}
+
 } // namespace
 
 namespace sunfish {
@@ -153,19 +171,29 @@ void Searcher::initialize() {
 Searcher::Searcher() :
   config_ (getDefaultSearchConfig()),
   evaluator_(Evaluator::sharedEvaluator()),
+  evaluatorGeneration_(0),
   treeSize_(0),
-  handler_(nullptr) {
+  numaPrepared_(false),
+  handler_(nullptr),
+  traceWriter_(nullptr) {
 }
 
 Searcher::Searcher(std::shared_ptr<Evaluator> evaluator) :
   config_ (getDefaultSearchConfig()),
   evaluator_(evaluator),
+  evaluatorGeneration_(0),
   treeSize_(0),
-  handler_(nullptr) {
+  numaPrepared_(false),
+  handler_(nullptr),
+  traceWriter_(nullptr) {
 }
 
 void Searcher::clean() {
   tt_.clear();
+  cleanGame();
+}
+
+void Searcher::cleanGame() {
   fromToHistory_.clear();
   pieceToHistory_.clear();
   timeManager_.clearGame();
@@ -192,17 +220,44 @@ void Searcher::onSearchStarted(const Position& pos,
   if (treeSize_ != config_.numberOfThreads) {
     treeSize_ = config_.numberOfThreads;
     trees_.reset(new Tree[treeSize_]);
+    numaPrepared_ = false;
+  }
+
+  if (config_.numa && !numaPrepared_) {
+    prepareNuma();
+  }
+
+  if (config_.numa && config_.replicateEval) {
+    // the replicas are copied again after the evaluator is changed.
+    if ((evaluatorReplicas_.empty() ||
+         evaluatorGeneration_ != evaluator_->generation()) &&
+        Numa::getNumberOfNodes() > 1) {
+      replicateEvaluator();
+    }
+  } else {
+    evaluatorReplicas_.clear();
+  }
+
+  if (record != nullptr) {
+    history_.update(*record);
+  } else {
+    history_.clear();
   }
 
   initializeSearchInfo(info_);
   for (int ti = 0; ti < treeSize_; ti++) {
     trees_[ti].index = ti;
     trees_[ti].completedDepth = 0;
+    auto& eval = evaluatorReplicas_.empty()
+               ? *evaluator_
+               : *evaluatorReplicas_[Numa::getNodeOfThread(ti)];
     initializeTree(trees_[ti],
                    pos,
-                   *evaluator_,
-                   record);
+                   eval,
+                   history_);
     initializeSearchInfo(trees_[ti].info);
+    trees_[ti].trace.initialize(traceWriter_ != nullptr ? traceWriter_->getCapacity() : 0,
+                                traceWriter_ != nullptr ? traceWriter_->getSampleRate() : 1);
   }
 
   if (handler_ != nullptr) {
@@ -210,6 +265,47 @@ void Searcher::onSearchStarted(const Position& pos,
   }
 }
 
+void Searcher::prepareNuma() {
+  numaPrepared_ = true;
+
+  if (Numa::getNumberOfNodes() <= 1) {
+    return;
+  }
+
+  bool ok = tt_.interleave();
+  for (int ti = 0; ti < treeSize_; ti++) {
+    unsigned node = Numa::getNodeOfThread(ti);
+    ok = Numa::bindMemory(&trees_[ti], sizeof(Tree), node) && ok;
+    ok = trees_[ti].shekTable.bind(node) && ok;
+  }
+
+  if (!ok) {
+    LOG(warning) << "could not bind the memory to the NUMA nodes";
+  }
+}
+
+void Searcher::replicateEvaluator() {
+  unsigned nodes = Numa::getNumberOfNodes();
+  evaluatorReplicas_.resize(nodes);
+  evaluatorGeneration_ = evaluator_->generation();
+
+  // each replica is built on a thread of the node,
+  // so that its pages are allocated on the node by the first touch.
+  std::vector<std::thread> threads;
+  for (unsigned node = 0; node < nodes; node++) {
+    threads.emplace_back([this, node]() {
+      Numa::bindThread(node);
+      auto& replica = evaluatorReplicas_[node];
+      replica.reset(new Evaluator(Evaluator::InitType::Zero));
+      replica->ofv() = evaluator_->ofv();
+      replica->onChanged(evaluator_->dataSourceType());
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 void Searcher::mergeInfo(Tree& tree) {
   std::lock_guard<std::mutex> lock(infoMutex_);
   mergeSearchInfo(info_, tree.info);
@@ -246,6 +342,44 @@ void Searcher::search(const Position& pos,
   result_.elapsed = timer_.elapsed();
 }
 
+void Searcher::searchRootMoves(const Position& pos,
+                               int depth,
+                               Score alpha,
+                               Score beta,
+                               const Moves& moves,
+                               std::vector<RootMoveResult>& results,
+                               Record* record /*= nullptr*/) {
+  onSearchStarted(pos, record);
+
+  results.clear();
+
+  auto& tree = trees_[0];
+  visit(tree);
+
+  for (auto move : moves) {
+    int newDepth = depth;
+    if (tree.position.isCheck(move)) {
+      newDepth += Depth1Ply;
+    }
+
+    if (!doMove(tree, move, *tree.evaluator, tt_)) {
+      continue;
+    }
+
+    Score score = -search(tree,
+                          newDepth,
+                          -beta,
+                          -alpha,
+                          NodeStat::normal());
+
+    results.push_back({ move, score, tree.nodes[tree.ply].pv });
+
+    undoMove(tree);
+  }
+
+  result_.elapsed = timer_.elapsed();
+}
+
 /**
  * iterative deepening search
  */
@@ -259,10 +393,18 @@ void Searcher::idsearch(const Position& pos,
   for (int ti = 1; ti < treeSize_; ti++) {
     prepareIDSearch(trees_[ti], trees_[0]);
     trees_[ti].thread = std::thread([this, ti, maxDepth]() {
+      if (config_.numa) {
+        Numa::bindThread(Numa::getNodeOfThread(ti));
+      }
       idsearch(trees_[ti], maxDepth);
     });
   }
 
+  // the calling thread is pinned only while searching.
+  if (config_.numa) {
+    Numa::bindThread(Numa::getNodeOfThread(0));
+  }
+
   idsearch(trees_[0], maxDepth);
 
   interrupt();
@@ -273,6 +415,10 @@ void Searcher::idsearch(const Position& pos,
     }
   }
 
+  if (config_.numa) {
+    Numa::unbindThread();
+  }
+
   for (int ti = 0; ti < treeSize_; ti++) {
     auto& tree = trees_[ti];
     auto& node = tree.nodes[tree.ply];
@@ -289,6 +435,10 @@ void Searcher::idsearch(const Position& pos,
       }
     }
   }
+
+  if (traceWriter_ != nullptr) {
+    writeTrace();
+  }
 }
 
 void Searcher::prepareIDSearch(Tree& tree,
@@ -372,6 +522,8 @@ bool Searcher::aspsearch(Tree& tree,
 
   bool doAsp = depth >= AspirationSearchMinDepth;
 
+  tree.trace.setIteration(depth / Depth1Ply);
+
   Score prevScore = moveToScore(node.moves[0]);
   Score alphas[] = {
     prevScore - 128,
@@ -419,7 +571,7 @@ bool Searcher::aspsearch(Tree& tree,
       newDepth = newDepth - reduced;
     }
 
-    bool moveOk = doMove(tree, move, *evaluator_, tt_);
+    bool moveOk = doMove(tree, move, *tree.evaluator, tt_);
     if (!moveOk) {
       LOG(warning) << "invalid state.";
       node.moves.remove(moveCount);
@@ -544,13 +696,31 @@ bool Searcher::aspsearch(Tree& tree,
 }
 
 /**
- * search of internal nodes
+ * search of internal nodes with the trace
  */
 Score Searcher::search(Tree& tree,
                        int depth,
                        Score alpha,
                        Score beta,
                        NodeStat nodeStat) {
+  if (!tree.trace.isEnabled()) {
+    return searchNode(tree, depth, alpha, beta, nodeStat);
+  }
+
+  traceEvent(tree, SearchTrace::Enter, depth, alpha, beta, Score::zero());
+  Score score = searchNode(tree, depth, alpha, beta, nodeStat);
+  traceEvent(tree, SearchTrace::Exit, depth, alpha, beta, score);
+  return score;
+}
+
+/**
+ * search of internal nodes
+ */
+Score Searcher::searchNode(Tree& tree,
+                           int depth,
+                           Score alpha,
+                           Score beta,
+                           NodeStat nodeStat) {
 #if 0
   bool isDebug = false;
   if (getPath(tree, tree.ply) == "4647+ 5847 46FU") {
@@ -567,7 +737,15 @@ Score Searcher::search(Tree& tree,
   auto& node = tree.nodes[tree.ply];
 
   // SHEK(strong horizontal effect killer)
-  switch (tree.shekTable.check(tree.position)) {
+  auto shekState = tree.shekTable.check(tree.position, tree.history->getShekTable());
+#if SUNFISH_TABLE_STATS
+  tree.info.shekProbe++;
+  if (shekState != ShekState::None) {
+    tree.info.shekHit++;
+  }
+#endif
+
+  switch (shekState) {
   case ShekState::Equal4:
     node.isHistorical = true;
     switch (tree.scr.detect(tree)) {
@@ -605,7 +783,7 @@ Score Searcher::search(Tree& tree,
 
   if (tree.ply == Tree::StackSize - 2) {
     node.isHistorical = true;
-    return calculateStandPat(tree, *evaluator_);
+    return calculateStandPat(tree, *tree.evaluator);
   }
 
   // distance pruning
@@ -627,11 +805,12 @@ Score Searcher::search(Tree& tree,
   int ttDepth;
   {
     TTElement tte;
-    if (tt_.get(tree.position.getHash(), tte)) {
+    if (probeTT(tree, tte)) {
       ttScoreType = tte.scoreType();
       ttScore = tte.score(tree.ply);
       ttDepth = tte.depth();
       Move ttMove = tte.move();
+      traceEvent(tree, SearchTrace::TTHit, ttDepth, alpha, beta, ttScore);
 
       bool isMate = (ttScore <= -Score::mate() && ttScoreType & TTScoreType::Upper) ||
                     (ttScore >=  Score::mate() && ttScoreType & TTScoreType::Lower);
@@ -648,6 +827,7 @@ Score Searcher::search(Tree& tree,
           }
 
           tree.info.hashCut++;
+          traceEvent(tree, SearchTrace::HashCut, depth, alpha, beta, ttScore);
           return ttScore;
         }
       }
@@ -679,13 +859,15 @@ Score Searcher::search(Tree& tree,
     return Score::infinity() - tree.ply - 1;
   }
 
-  Score standPat = calculateStandPat(tree, *evaluator_);
+  Score standPat = calculateStandPat(tree, *tree.evaluator);
 
   // futility pruning
   if (!isCheck(node.checkState) &&
       depth < FutilityPruningMaxDepth &&
       standPat - futilityPruningMargin(depth) >= beta) {
     tree.info.futilityPruning++;
+    traceEvent(tree, SearchTrace::FutilityPruning, depth, alpha, beta,
+               standPat - futilityPruningMargin(depth));
     return standPat - futilityPruningMargin(depth);
   }
 
@@ -702,6 +884,7 @@ Score Searcher::search(Tree& tree,
                         razorAlpha + 1);
     if (score <= razorAlpha) {
       tree.info.razoring++;
+      traceEvent(tree, SearchTrace::Razoring, depth, alpha, beta, score);
       return score;
     }
 
@@ -736,14 +919,15 @@ Score Searcher::search(Tree& tree,
       auto& childNode = tree.nodes[tree.ply+1];
       node.isHistorical = childNode.isHistorical;
       tree.info.nullMovePruning++;
-      tt_.store(tree.position.getHash(),
-                alpha,
-                beta,
-                score,
-                depth,
-                tree.ply,
-                Move::none(),
-                false);
+      traceEvent(tree, SearchTrace::NullMovePruning, depth, alpha, beta, score);
+      storeTT(tree,
+              alpha,
+              beta,
+              score,
+              depth,
+              tree.ply,
+              Move::none(),
+              false);
       return score;
     }
 
@@ -768,7 +952,7 @@ Score Searcher::search(Tree& tree,
         break;
       }
 
-      bool moveOk = doMove(tree, move, *evaluator_, tt_);
+      bool moveOk = doMove(tree, move, *tree.evaluator, tt_);
       if (!moveOk) {
         continue;
       }
@@ -787,6 +971,7 @@ Score Searcher::search(Tree& tree,
 
       if (score >= pbeta) {
         tree.info.probCut++;
+        traceEvent(tree, SearchTrace::ProbCut, depth, alpha, beta, score);
         return score;
       }
     }
@@ -815,7 +1000,7 @@ Score Searcher::search(Tree& tree,
     revisit(tree);
 
     TTElement tte;
-    if (tt_.get(tree.position.getHash(), tte)) {
+    if (probeTT(tree, tte)) {
       Move ttMove = tte.move();
       if (tree.position.validateMove(ttMove, node.checkState)) {
         node.ttMove = ttMove;
@@ -915,17 +1100,18 @@ Score Searcher::search(Tree& tree,
         newDepth < FutilityPruningMaxDepth &&
         newAlpha > -Score::mate() &&
         !isPriorMove(tree, move)) {
-      Score futScore = estimateScore(tree, move, *evaluator_)
+      Score futScore = estimateScore(tree, move, *tree.evaluator)
                      + FUT_PRUN_MARGIN + futilityPruningMargin(newDepth);
       if (futScore <= newAlpha) {
         isFirst = false;
         bestScore = std::max(bestScore, futScore);
         tree.info.futilityPruning++;
+        traceEvent(tree, SearchTrace::FutilityPruning, newDepth, alpha, beta, futScore);
         continue;
       }
     }
 
-    bool moveOk = doMove(tree, move, *evaluator_, tt_);
+    bool moveOk = doMove(tree, move, *tree.evaluator, tt_);
     if (!moveOk) {
       node.moveIterator = node.moves.remove(node.moveIterator-1);
       moveCount--;
@@ -1007,14 +1193,14 @@ Score Searcher::search(Tree& tree,
   }
 
   if (!node.isHistorical) {
-    tt_.store(tree.position.getHash(),
-              alpha,
-              beta,
-              bestScore,
-              depth,
-              tree.ply,
-              bestMove,
-              nodeStat.isMateThreat());
+    storeTT(tree,
+            alpha,
+            beta,
+            bestScore,
+            depth,
+            tree.ply,
+            bestMove,
+            nodeStat.isMateThreat());
   }
 
   return bestScore;
@@ -1070,7 +1256,7 @@ Score Searcher::quies(Tree& tree,
   Score bestScore = alpha;
 
   if (!isCheck(node.checkState)) {
-    Score standPat = calculateStandPat(tree, *evaluator_);
+    Score standPat = calculateStandPat(tree, *tree.evaluator);
     if (standPat > bestScore) {
       bestScore = standPat;
       if (bestScore >= beta) {
@@ -1083,14 +1269,14 @@ Score Searcher::quies(Tree& tree,
 
   if (tree.ply == Tree::StackSize - 2) {
     node.isHistorical = true;
-    return calculateStandPat(tree, *evaluator_);
+    return calculateStandPat(tree, *tree.evaluator);
   }
 
   bool isNullWindow = alpha + 1 == beta;
 
   // transposition table
   TTElement tte;
-  if (tt_.get(tree.position.getHash(), tte)) {
+  if (probeTT(tree, tte)) {
     auto ttScoreType = tte.scoreType();
     Score ttScore = tte.score(tree.ply);
     int ttDepth = tte.depth();
@@ -1127,14 +1313,14 @@ Score Searcher::quies(Tree& tree,
     // futility pruning
     if (!tree.position.isCheck(move) &&
         !isCheck(node.checkState)) {
-      Score estScore = estimateScore(tree, move, *evaluator_);
+      Score estScore = estimateScore(tree, move, *tree.evaluator);
       if (estScore + FUT_PRUN_MARGIN <= alpha) {
         tree.info.futilityPruning++;
         continue;
       }
     }
 
-    bool moveOk = doMove(tree, move, *evaluator_, tt_);
+    bool moveOk = doMove(tree, move, *tree.evaluator, tt_);
     if (!moveOk) {
       continue;
     }
@@ -1163,14 +1349,14 @@ Score Searcher::quies(Tree& tree,
     }
   }
 
-  tt_.store(tree.position.getHash(),
-            alpha,
-            beta,
-            bestScore,
-            depth,
-            tree.ply,
-            Move::none(),
-            false);
+  storeTT(tree,
+          alpha,
+          beta,
+          bestScore,
+          depth,
+          tree.ply,
+          Move::none(),
+          false);
 
   return bestScore;
 }
@@ -1231,6 +1417,7 @@ void Searcher::generateMovesOnProbCut(Tree& tree, Score threshold) {
 }
 
 Move Searcher::nextMove(Tree& tree) {
+  INSTRUMENT_SCOPE(NextMove);
   auto& node = tree.nodes[tree.ply];
 
   switch (node.genPhase) {
@@ -1378,6 +1565,7 @@ Move Searcher::nextMove(Tree& tree) {
 
 template <bool Capture>
 void Searcher::sortMoves(Tree& tree) {
+  INSTRUMENT_SCOPE(SortMoves);
   auto& node = tree.nodes[tree.ply];
   auto turn = tree.position.getTurn();
 
@@ -1420,14 +1608,14 @@ void Searcher::sortRootMoves(Tree& tree) {
 
   Move ttMove = Move::none();
   TTElement tte;
-  if (tt_.get(tree.position.getHash(), tte)) {
+  if (probeTT(tree, tte)) {
     ttMove = tte.move();
   }
 
   for (Moves::size_type moveCount = 0; moveCount < node.moves.size();) {
     Move move = node.moves[moveCount];
 
-    bool moveOk = doMove(tree, move, *evaluator_, tt_);
+    bool moveOk = doMove(tree, move, *tree.evaluator, tt_);
     if (!moveOk) {
       node.moves.remove(moveCount);
       continue;
@@ -1476,7 +1664,7 @@ void Searcher::storePV(Tree& tree,
     return;
   }
 
-  if (doMove(tree, move, *evaluator_, tt_)) {
+  if (doMove(tree, move, *tree.evaluator, tt_)) {
     storePV(tree,
             pv,
             ply + 1,
@@ -1484,17 +1672,78 @@ void Searcher::storePV(Tree& tree,
             -alpha,
             -score);
     undoMove(tree);
-    tt_.store(tree.position.getHash(),
-              alpha,
-              beta,
-              score,
-              depth,
-              ply,
-              move,
-              false);
+    storeTT(tree,
+            alpha,
+            beta,
+            score,
+            depth,
+            ply,
+            move,
+            false);
   } else {
     LOG(warning) << "the PV contain an illegal move.";
   }
 }
 
+bool Searcher::probeTT(Tree& tree, TTElement& tte) {
+#if SUNFISH_TABLE_STATS
+  bool mismatch;
+  tree.info.ttProbe++;
+  if (!tt_.get(tree.position.getHash(), tte, mismatch)) {
+    if (mismatch) {
+      tree.info.ttMismatch++;
+    }
+    return false;
+  }
+  tree.info.ttHit++;
+  return true;
+#else
+  return tt_.get(tree.position.getHash(), tte);
+#endif
+}
+
+void Searcher::storeTT(Tree& tree,
+                       Score alpha,
+                       Score beta,
+                       Score score,
+                       int depth,
+                       int ply,
+                       Move move,
+                       bool mateThreat) {
+  auto status = tt_.store(tree.position.getHash(),
+                          alpha,
+                          beta,
+                          score,
+                          depth,
+                          ply,
+                          move,
+                          mateThreat);
+#if SUNFISH_TABLE_STATS
+  switch (status) {
+  case TTStatus::Update:
+    tree.info.ttUpdate++;
+    break;
+  case TTStatus::Replace:
+    tree.info.ttReplace++;
+    break;
+  default:
+    tree.info.ttReject++;
+    return;
+  }
+
+  int bin = std::max(depth / Depth1Ply, 0);
+  bin = std::min(bin, SearchInfo::TTDepthSize - 1);
+  tree.info.ttDepth[bin]++;
+#else
+  (void)status;
+#endif
+}
+
+void Searcher::writeTrace() {
+  auto search = traceWriter_->nextSearch();
+  for (int ti = 0; ti < treeSize_; ti++) {
+    traceWriter_->write(search, ti, trees_[ti].trace);
+  }
+}
+
 } // namespace sunfish
@@ -14,10 +14,15 @@
 #include "search/time/TimeManager.hpp"
 #include "search/tree/Tree.hpp"
 #include "search/tree/NodeStat.hpp"
+#include "search/shek/GameHistory.hpp"
 #include "search/tt/TT.hpp"
+#include "search/trace/SearchTrace.hpp"
 #include "search/history/History.hpp"
 //#include "common/math/Random.hpp"
 #include "common/time/Timer.hpp"
+#include "core/move/Moves.hpp"
+#include <string>
+#include <vector>
 #include <memory>
 #include <mutex>
 #include <atomic>
@@ -45,6 +50,11 @@ public:
 
   void clean();
 
+  /**
+   * Clear the history tables and the states of the game except TT.
+   */
+  void cleanGame();
+
   void search(const Position& pos,
               int depth,
               Record* record = nullptr) {
@@ -61,6 +71,23 @@ public:
               Score beta,
               Record* record = nullptr);
 
+  /**
+   * Search each of the root moves with the same window.
+   * The scores are from the viewpoint of the root position,
+   * and the PVs begin with the reply to each move.
+   * The depth is extended by 1 ply for the checking moves,
+   * and the illegal moves are omitted from the results.
+   * The history, the killers and the tree are kept
+   * across the root moves.
+   */
+  void searchRootMoves(const Position& pos,
+                       int depth,
+                       Score alpha,
+                       Score beta,
+                       const Moves& moves,
+                       std::vector<RootMoveResult>& results,
+                       Record* record = nullptr);
+
   /**
    * iterative deepening search.
    */
@@ -92,12 +119,39 @@ public:
     handler_ = handler;
   }
 
+  /**
+   * Trace the nodes of idsearch() to the writer.
+   * The trace is disabled if nullptr is given.
+   */
+  void setTraceWriter(SearchTraceWriter* traceWriter) {
+    traceWriter_ = traceWriter;
+  }
+
   float ttUsageRates() const {
     return tt_.usageRates();
   }
 
   void ttResizeMB(unsigned mebiBytes) {
     tt_.resizeMB(mebiBytes);
+    numaPrepared_ = false;
+  }
+
+  bool ttSave(const std::string& path) const {
+    return tt_.save(path);
+  }
+
+  /**
+   * Load a snapshot of TT.
+   * The size of TT is changed to the size of the snapshot.
+   * TT is cleared on failure.
+   */
+  bool ttLoad(const std::string& path) {
+    numaPrepared_ = false;
+    if (!tt_.load(path)) {
+      tt_.clear();
+      return false;
+    }
+    return true;
   }
 
 private:
@@ -105,6 +159,10 @@ private:
   void onSearchStarted(const Position& pos,
                        Record* record);
 
+  void prepareNuma();
+
+  void replicateEvaluator();
+
   void mergeInfo(Tree& tree);
 
   void prepareIDSearch(Tree& tree,
@@ -122,6 +180,12 @@ private:
                Score beta,
                NodeStat nodeStat);
 
+  Score searchNode(Tree& tree,
+                   int depth,
+                   Score alpha,
+                   Score beta,
+                   NodeStat nodeStat);
+
   void updateHistory(Tree& tree,
                      Move move,
                      int depth);
@@ -148,6 +212,19 @@ private:
 
   void sortRootMoves(Tree& tree);
 
+  bool probeTT(Tree& tree, TTElement& tte);
+
+  void storeTT(Tree& tree,
+               Score alpha,
+               Score beta,
+               Score score,
+               int depth,
+               int ply,
+               Move move,
+               bool mateThreat);
+
+  void writeTrace();
+
   void storePV(Tree& tree,
                const PV& pv,
                unsigned ply,
@@ -177,6 +254,16 @@ private:
 
   std::shared_ptr<Evaluator> evaluator_;
 
+  /**
+   * The copies of the evaluator on each NUMA node.
+   */
+  std::vector<std::unique_ptr<Evaluator>> evaluatorReplicas_;
+
+  /**
+   * The generation of the evaluator copied to the replicas.
+   */
+  uint32_t evaluatorGeneration_;
+
   TT tt_;
 
   FromToHistory fromToHistory_;
@@ -185,12 +272,18 @@ private:
   std::unique_ptr<Tree[]> trees_;
   int treeSize_;
 
+  bool numaPrepared_;
+
+  GameHistory history_;
+
   //Random random_;
 
   TimeManager timeManager_;
 
   SearchHandler* handler_;
 
+  SearchTraceWriter* traceWriter_;
+
 };
 
 } // namespace sunfish
@@ -14,6 +14,12 @@
 
 namespace sunfish {
 
+enum class EvalCacheStatus : int {
+  Hit,
+  Store,
+  Replace,
+};
+
 class EvalCacheElement {
 public:
 
@@ -34,6 +40,10 @@ public:
     return ((data_ ^ hash) & HashMask) == 0llu;
   }
 
+  bool isEmpty() const {
+    return data_ == 0llu;
+  }
+
   Score score() {
     uint16_t u16score = static_cast<uint16_t>(data_);
     return Score(static_cast<int16_t>(u16score));
@@ -48,10 +58,17 @@ private:
 class EvalCache : public HashTable<EvalCacheElement> {
 public:
 
-  void entry(Zobrist::Type hash, const Score& score) {
+  /**
+   * Store the score.
+   * Replace is returned if the score of another position is overwritten.
+   */
+  EvalCacheStatus entry(Zobrist::Type hash, const Score& score) {
     auto e = getElement(hash);
+    auto status = e.isEmpty() ? EvalCacheStatus::Store
+                              : EvalCacheStatus::Replace;
     e.set(hash, score);
     getElement(hash) = e;
+    return status;
   }
 
   bool check(Zobrist::Type hash, Score& score) {
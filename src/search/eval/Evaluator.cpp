@@ -6,8 +6,11 @@
 #include "search/eval/Evaluator.hpp"
 #include "search/eval/FeatureTemplates.hpp"
 #include "search/eval/Material.hpp"
+#include "common/time/Instrument.hpp"
 #include "logger/Logger.hpp"
+#include <algorithm>
 #include <fstream>
+#include <thread>
 #include <mutex>
 #include <memory>
 #include <cstring>
@@ -18,6 +21,13 @@ const char* const EvalBin = "eval.bin";
 
 CONSTEXPR_CONST Score EnteringKing = 1000;
 
+CONSTEXPR_CONST size_t MinimumBatchSizePerThread = 256;
+
+inline unsigned kingSquaresKey(const Position& position) {
+  return position.getBlackKingSquare().raw() * Square::N
+       + position.getWhiteKingSquare().raw();
+}
+
 } // namespace
 
 namespace sunfish {
@@ -36,7 +46,8 @@ std::shared_ptr<Evaluator> Evaluator::sharedEvaluator() {
   return sptr;
 }
 
-Evaluator::Evaluator(InitType type) {
+Evaluator::Evaluator(InitType type) :
+    generation_(0) {
   switch (type) {
   case InitType::EvalBin:
     if (!load(*this)) {
@@ -58,6 +69,7 @@ void Evaluator::initializeZero() {
 void Evaluator::onChanged(DataSourceType dataSourceType) {
   cache_.clear();
   dataSourceType_ = dataSourceType;
+  generation_++;
 }
 
 Score Evaluator::calculateMaterialScore(const Position& position) const {
@@ -149,16 +161,19 @@ Score Evaluator::calculatePositionalScore(const Position& position) {
 }
 
 Score Evaluator::calculateTotalScore(Score materialScore,
-                                     const Position& position) {
+                                     const Position& position,
+                                     EvalCacheStatus& status) {
+  INSTRUMENT_SCOPE(Evaluate);
   Score score;
   if (cache_.check(position.getHash(), score)) {
+    status = EvalCacheStatus::Hit;
     return score;
   }
 
   auto positionalScore = calculatePositionalScore(position);
   score = materialScore + positionalScore;
 
-  cache_.entry(position.getHash(), score);
+  status = cache_.entry(position.getHash(), score);
 
   return score;
 }
@@ -187,6 +202,49 @@ Score Evaluator::estimateScore(Score score,
   return score;
 }
 
+void Evaluator::evaluateBatch(const std::vector<Position>& positions,
+                              std::vector<Score>& scores,
+                              int numberOfThreads) {
+  size_t size = positions.size();
+  scores.resize(size);
+
+  // group the positions by the king squares
+  // so that the same rows of the feature tables are accessed in succession.
+  std::vector<uint32_t> indices(size);
+  for (size_t i = 0; i < size; i++) {
+    indices[i] = static_cast<uint32_t>(i);
+  }
+  std::sort(indices.begin(), indices.end(), [&positions](uint32_t lhs, uint32_t rhs) {
+    return kingSquaresKey(positions[lhs]) < kingSquaresKey(positions[rhs]);
+  });
+
+  auto evaluate = [this, &positions, &scores, &indices](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      const Position& position = positions[indices[i]];
+      scores[indices[i]] = calculateMaterialScore(position)
+                         + calculatePositionalScore(position);
+    }
+  };
+
+  size_t maxThreads = std::max(size / MinimumBatchSizePerThread, static_cast<size_t>(1));
+  size_t threads = std::min(static_cast<size_t>(std::max(numberOfThreads, 1)), maxThreads);
+  if (threads == 1) {
+    evaluate(0, size);
+    return;
+  }
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (size_t t = 1; t < threads; t++) {
+    workers.emplace_back(evaluate, size * t / threads, size * (t + 1) / threads);
+  }
+  evaluate(0, size / threads);
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
 bool load(const char* path, Evaluator::FVType& fv) {
   std::ifstream file(path, std::ios::in | std::ios::binary);
   if (!file) {
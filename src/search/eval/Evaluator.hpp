@@ -13,6 +13,7 @@
 #include "search/eval/FeatureVector.hpp"
 #include "search/eval/EvalCache.hpp"
 #include "search/eval/Score.hpp"
+#include <vector>
 #include <memory>
 #include <cstdint>
 
@@ -57,12 +58,26 @@ public:
   Score calculatePositionalScore(const Position& position);
 
   Score calculateTotalScore(Score materialScore,
-                            const Position& position);
+                            const Position& position) {
+    EvalCacheStatus status;
+    return calculateTotalScore(materialScore, position, status);
+  }
+
+  Score calculateTotalScore(Score materialScore,
+                            const Position& position,
+                            EvalCacheStatus& status);
 
   Score estimateScore(Score score,
                       const Position& position,
                       Move move);
 
+  /**
+   * Calculate the total scores of the positions without the EvalCache.
+   */
+  void evaluateBatch(const std::vector<Position>& positions,
+                     std::vector<Score>& scores,
+                     int numberOfThreads = 1);
+
   OFVType& ofv() {
     return ofv_;
   }
@@ -71,6 +86,14 @@ public:
     return dataSourceType_;
   }
 
+  /**
+   * Get the number of the calls of onChanged(),
+   * by which the copies of the evaluator are found to be old.
+   */
+  uint32_t generation() const {
+    return generation_;
+  }
+
 private:
 
   EvalCache cache_;
@@ -79,6 +102,8 @@ private:
 
   DataSourceType dataSourceType_;
 
+  uint32_t generation_;
+
 };
 
 bool load(const char* path, Evaluator::FVType& fv);
@@ -12,6 +12,7 @@
 #include "search/eval/FeatureVector.hpp"
 #include <vector>
 #include <algorithm>
+#include <type_traits>
 #include <utility>
 #include <cstring>
 
@@ -25,10 +26,24 @@
     0, \
     sizeof(fv.part))
 
+#define FV_ROW_COPY(out, in, part, king) memcpy( \
+    reinterpret_cast<typename FV::Type*>(out.part[king]), \
+    reinterpret_cast<const typename FV::Type*>(in.part[king]), \
+    sizeof(fv.part[king]))
+
 namespace {
 
 using namespace sunfish;
 
+/**
+ * The template passes below can be split into `parts' disjoint parts.
+ * The element indexed by `index' belongs to the part `index % parts'.
+ */
+inline
+bool isOwnedPart(int index, int part, int parts) {
+  return index % parts == part;
+}
+
 template <class Open,
           class KingOpenR,
           class KingOpenXR,
@@ -60,12 +75,16 @@ void optimizeOpen(Open open,
 
 template <class FV, class OFV>
 inline
-void optimize(FV& fv, OFV& ofv) {
-  FV_PART_COPY(ofv, fv, kingHand);
-
-  // kingPieceR, kingPieceXR, kingPieceYR, kingPiece,
-  //   => kingPiece
+void optimize(FV& fv, OFV& ofv, int part, int parts) {
   SQUARE_EACH(king) {
+    if (!isOwnedPart(king.raw(), part, parts)) {
+      continue;
+    }
+
+    FV_ROW_COPY(ofv, fv, kingHand, king.raw());
+
+    // kingPieceR, kingPieceXR, kingPieceYR, kingPiece,
+    //   => kingPiece
     SQUARE_EACH(square) {
       for (int i = 0; i < EvalPieceIndex::End; i++) {
         ofv.kingPiece[king.raw()][square.raw()][i]
@@ -75,13 +94,11 @@ void optimize(FV& fv, OFV& ofv) {
           + fv.kingPieceYR[king.getRank()-1][RelativeSquare(king, square).raw()][i];
       }
     }
-  }
 
-  FV_PART_COPY(ofv, fv, kingNeighborHand);
+    FV_ROW_COPY(ofv, fv, kingNeighborHand, king.raw());
 
-  // kingNeighborPieceR, kingNeighborPieceXR, kingNeighborPieceYR, kingNeighborPiece
-  //   => kingNeighborPiece
-  SQUARE_EACH(king) {
+    // kingNeighborPieceR, kingNeighborPieceXR, kingNeighborPieceYR, kingNeighborPiece
+    //   => kingNeighborPiece
     for (int n = 0; n < Neighbor3x3::NN; n++) {
       for (int i1 = 0; i1 < EvalPieceTypeIndex::End; i1++) {
         SQUARE_EACH(square) {
@@ -95,76 +112,102 @@ void optimize(FV& fv, OFV& ofv) {
         }
       }
     }
-  }
 
-  FV_PART_COPY(ofv, fv, kingKingHand);
-  FV_PART_COPY(ofv, fv, kingKingPiece);
+    FV_ROW_COPY(ofv, fv, kingKingHand, king.raw());
+    FV_ROW_COPY(ofv, fv, kingKingPiece, king.raw());
 
-  optimizeOpen(fv.bRookVer,
-               fv.kingBRookVerR,
-               fv.kingBRookVerXR,
-               fv.kingBRookVerYR,
-               fv.kingBRookVer,
-               ofv.kingBRookVer);
-  optimizeOpen(fv.wRookVer,
-               fv.kingWRookVerR,
-               fv.kingWRookVerXR,
-               fv.kingWRookVerYR,
-               fv.kingWRookVer,
-               ofv.kingWRookVer);
-  optimizeOpen(fv.bRookHor,
-               fv.kingBRookHorR,
-               fv.kingBRookHorXR,
-               fv.kingBRookHorYR,
-               fv.kingBRookHor,
-               ofv.kingBRookHor);
-  optimizeOpen(fv.wRookHor,
-               fv.kingWRookHorR,
-               fv.kingWRookHorXR,
-               fv.kingWRookHorYR,
-               fv.kingWRookHor,
-               ofv.kingWRookHor);
-  optimizeOpen(fv.bBishopDiagL45,
-               fv.kingBBishopDiagL45R,
-               fv.kingBBishopDiagL45XR,
-               fv.kingBBishopDiagL45YR,
-               fv.kingBBishopDiagL45,
-               ofv.kingBBishopDiagL45);
-  optimizeOpen(fv.wBishopDiagL45,
-               fv.kingWBishopDiagL45R,
-               fv.kingWBishopDiagL45XR,
-               fv.kingWBishopDiagL45YR,
-               fv.kingWBishopDiagL45,
-               ofv.kingWBishopDiagL45);
-  optimizeOpen(fv.bBishopDiagR45,
-               fv.kingBBishopDiagR45R,
-               fv.kingBBishopDiagR45XR,
-               fv.kingBBishopDiagR45YR,
-               fv.kingBBishopDiagR45,
-               ofv.kingBBishopDiagR45);
-  optimizeOpen(fv.wBishopDiagR45,
-               fv.kingWBishopDiagR45R,
-               fv.kingWBishopDiagR45XR,
-               fv.kingWBishopDiagR45YR,
-               fv.kingWBishopDiagR45,
-               ofv.kingWBishopDiagR45);
-  optimizeOpen(fv.bLance,
-               fv.kingBLanceR,
-               fv.kingBLanceXR,
-               fv.kingBLanceYR,
-               fv.kingBLance,
-               ofv.kingBLance);
-  optimizeOpen(fv.wLance,
-               fv.kingWLanceR,
-               fv.kingWLanceXR,
-               fv.kingWLanceYR,
-               fv.kingWLance,
-               ofv.kingWLance);
+    FV_ROW_COPY(ofv, fv, kingAllyEffect9, king.raw());
+    FV_ROW_COPY(ofv, fv, kingEnemyEffect9, king.raw());
+    FV_ROW_COPY(ofv, fv, kingAllyEffect25, king.raw());
+    FV_ROW_COPY(ofv, fv, kingEnemyEffect25, king.raw());
+  }
 
-  FV_PART_COPY(ofv, fv, kingAllyEffect9);
-  FV_PART_COPY(ofv, fv, kingEnemyEffect9);
-  FV_PART_COPY(ofv, fv, kingAllyEffect25);
-  FV_PART_COPY(ofv, fv, kingEnemyEffect25);
+  if (isOwnedPart(0, part, parts)) {
+    optimizeOpen(fv.bRookVer,
+                 fv.kingBRookVerR,
+                 fv.kingBRookVerXR,
+                 fv.kingBRookVerYR,
+                 fv.kingBRookVer,
+                 ofv.kingBRookVer);
+  }
+  if (isOwnedPart(1, part, parts)) {
+    optimizeOpen(fv.wRookVer,
+                 fv.kingWRookVerR,
+                 fv.kingWRookVerXR,
+                 fv.kingWRookVerYR,
+                 fv.kingWRookVer,
+                 ofv.kingWRookVer);
+  }
+  if (isOwnedPart(2, part, parts)) {
+    optimizeOpen(fv.bRookHor,
+                 fv.kingBRookHorR,
+                 fv.kingBRookHorXR,
+                 fv.kingBRookHorYR,
+                 fv.kingBRookHor,
+                 ofv.kingBRookHor);
+  }
+  if (isOwnedPart(3, part, parts)) {
+    optimizeOpen(fv.wRookHor,
+                 fv.kingWRookHorR,
+                 fv.kingWRookHorXR,
+                 fv.kingWRookHorYR,
+                 fv.kingWRookHor,
+                 ofv.kingWRookHor);
+  }
+  if (isOwnedPart(4, part, parts)) {
+    optimizeOpen(fv.bBishopDiagL45,
+                 fv.kingBBishopDiagL45R,
+                 fv.kingBBishopDiagL45XR,
+                 fv.kingBBishopDiagL45YR,
+                 fv.kingBBishopDiagL45,
+                 ofv.kingBBishopDiagL45);
+  }
+  if (isOwnedPart(5, part, parts)) {
+    optimizeOpen(fv.wBishopDiagL45,
+                 fv.kingWBishopDiagL45R,
+                 fv.kingWBishopDiagL45XR,
+                 fv.kingWBishopDiagL45YR,
+                 fv.kingWBishopDiagL45,
+                 ofv.kingWBishopDiagL45);
+  }
+  if (isOwnedPart(6, part, parts)) {
+    optimizeOpen(fv.bBishopDiagR45,
+                 fv.kingBBishopDiagR45R,
+                 fv.kingBBishopDiagR45XR,
+                 fv.kingBBishopDiagR45YR,
+                 fv.kingBBishopDiagR45,
+                 ofv.kingBBishopDiagR45);
+  }
+  if (isOwnedPart(7, part, parts)) {
+    optimizeOpen(fv.wBishopDiagR45,
+                 fv.kingWBishopDiagR45R,
+                 fv.kingWBishopDiagR45XR,
+                 fv.kingWBishopDiagR45YR,
+                 fv.kingWBishopDiagR45,
+                 ofv.kingWBishopDiagR45);
+  }
+  if (isOwnedPart(8, part, parts)) {
+    optimizeOpen(fv.bLance,
+                 fv.kingBLanceR,
+                 fv.kingBLanceXR,
+                 fv.kingBLanceYR,
+                 fv.kingBLance,
+                 ofv.kingBLance);
+  }
+  if (isOwnedPart(9, part, parts)) {
+    optimizeOpen(fv.wLance,
+                 fv.kingWLanceR,
+                 fv.kingWLanceXR,
+                 fv.kingWLanceYR,
+                 fv.kingWLance,
+                 ofv.kingWLance);
+  }
+}
+
+template <class FV, class OFV>
+inline
+void optimize(FV& fv, OFV& ofv) {
+  optimize(fv, ofv, 0, 1);
 }
 
 template <class Open,
@@ -202,117 +245,320 @@ void expandOpen(Open open,
 
 template <class FV, class OFV>
 inline
-void expand(FV& fv, OFV& ofv) {
-  FV_PART_COPY(fv, ofv, kingHand);
+void expand(FV& fv, OFV& ofv, int part, int parts) {
+  SQUARE_EACH(king) {
+    if (!isOwnedPart(king.raw(), part, parts)) {
+      continue;
+    }
+
+    FV_ROW_COPY(fv, ofv, kingHand, king.raw());
+    FV_ROW_COPY(fv, ofv, kingPiece, king.raw());
+    FV_ROW_COPY(fv, ofv, kingNeighborHand, king.raw());
+    FV_ROW_COPY(fv, ofv, kingNeighborPiece, king.raw());
+    FV_ROW_COPY(fv, ofv, kingKingHand, king.raw());
+    FV_ROW_COPY(fv, ofv, kingKingPiece, king.raw());
+    FV_ROW_COPY(fv, ofv, kingAllyEffect9, king.raw());
+    FV_ROW_COPY(fv, ofv, kingEnemyEffect9, king.raw());
+    FV_ROW_COPY(fv, ofv, kingAllyEffect25, king.raw());
+    FV_ROW_COPY(fv, ofv, kingEnemyEffect25, king.raw());
+  }
 
   // kingPiece
-  //   => kingPieceR, kingPieceXR, kingPieceYR, kingPiece,
-  FV_PART_ZERO(fv, kingPieceR);
-  FV_PART_ZERO(fv, kingPieceXR);
-  FV_PART_ZERO(fv, kingPieceYR);
-  SQUARE_EACH(king) {
-    SQUARE_EACH(square) {
-      for (int i = 0; i < EvalPieceIndex::End; i++) {
-        auto val = ofv.kingPiece[king.raw()][square.raw()][i];
-        fv.kingPieceR[RelativeSquare(king, square).raw()][i] += val;
-        fv.kingPieceXR[king.getFile()-1][RelativeSquare(king, square).raw()][i] += val;
-        fv.kingPieceYR[king.getRank()-1][RelativeSquare(king, square).raw()][i] += val;
-        fv.kingPiece[king.raw()][square.raw()][i] = val;
+  //   => kingPieceR, kingPieceXR, kingPieceYR
+  if (isOwnedPart(0, part, parts)) {
+    FV_PART_ZERO(fv, kingPieceR);
+    FV_PART_ZERO(fv, kingPieceXR);
+    FV_PART_ZERO(fv, kingPieceYR);
+    SQUARE_EACH(king) {
+      SQUARE_EACH(square) {
+        for (int i = 0; i < EvalPieceIndex::End; i++) {
+          auto val = ofv.kingPiece[king.raw()][square.raw()][i];
+          fv.kingPieceR[RelativeSquare(king, square).raw()][i] += val;
+          fv.kingPieceXR[king.getFile()-1][RelativeSquare(king, square).raw()][i] += val;
+          fv.kingPieceYR[king.getRank()-1][RelativeSquare(king, square).raw()][i] += val;
+        }
       }
     }
   }
 
-  FV_PART_COPY(fv, ofv, kingNeighborHand);
-
   // kingNeighborPiece
-  //   => kingNeighborPieceR, kingNeighborPieceXR, kingNeighborPieceYR, kingNeighborPiece
-  FV_PART_ZERO(fv, kingNeighborPieceR);
-  FV_PART_ZERO(fv, kingNeighborPieceXR);
-  FV_PART_ZERO(fv, kingNeighborPieceYR);
+  //   => kingNeighborPieceR, kingNeighborPieceXR, kingNeighborPieceYR
+  // The elements are split by (n, i1),
+  // and each element is accumulated in the order of the king squares.
+  for (int n = 0; n < Neighbor3x3::NN; n++) {
+    for (int i1 = 0; i1 < EvalPieceTypeIndex::End; i1++) {
+      if (!isOwnedPart(n * EvalPieceTypeIndex::End + i1, part, parts)) {
+        continue;
+      }
+      FV_PART_ZERO(fv, kingNeighborPieceR[n][i1]);
+      for (int f = 0; f < SQUARE_FILES; f++) {
+        FV_PART_ZERO(fv, kingNeighborPieceXR[f][n][i1]);
+      }
+      for (int r = 0; r < SQUARE_RANKS; r++) {
+        FV_PART_ZERO(fv, kingNeighborPieceYR[r][n][i1]);
+      }
+    }
+  }
   SQUARE_EACH(king) {
     for (int n = 0; n < Neighbor3x3::NN; n++) {
       for (int i1 = 0; i1 < EvalPieceTypeIndex::End; i1++) {
+        if (!isOwnedPart(n * EvalPieceTypeIndex::End + i1, part, parts)) {
+          continue;
+        }
         SQUARE_EACH(square) {
           for (int i2 = 0; i2 < EvalPieceIndex::End; i2++) {
             auto val = ofv.kingNeighborPiece[king.raw()][n][i1][square.raw()][i2];
             fv.kingNeighborPieceR[n][i1][RelativeSquare(king, square).raw()][i2] += val;
             fv.kingNeighborPieceXR[king.getFile()-1][n][i1][RelativeSquare(king, square).raw()][i2] += val;
             fv.kingNeighborPieceYR[king.getRank()-1][n][i1][RelativeSquare(king, square).raw()][i2] += val;
-            fv.kingNeighborPiece[king.raw()][n][i1][square.raw()][i2] = val;
           }
         }
       }
     }
   }
 
-  FV_PART_COPY(fv, ofv, kingKingHand);
-  FV_PART_COPY(fv, ofv, kingKingPiece);
-
-  expandOpen(fv.bRookVer,
+  if (isOwnedPart(0, part, parts)) {
+    expandOpen(fv.bRookVer,
                fv.kingBRookVerR,
                fv.kingBRookVerXR,
                fv.kingBRookVerYR,
                fv.kingBRookVer,
                ofv.kingBRookVer);
-  expandOpen(fv.wRookVer,
+  }
+  if (isOwnedPart(1, part, parts)) {
+    expandOpen(fv.wRookVer,
                fv.kingWRookVerR,
                fv.kingWRookVerXR,
                fv.kingWRookVerYR,
                fv.kingWRookVer,
                ofv.kingWRookVer);
-  expandOpen(fv.bRookHor,
+  }
+  if (isOwnedPart(2, part, parts)) {
+    expandOpen(fv.bRookHor,
                fv.kingBRookHorR,
                fv.kingBRookHorXR,
                fv.kingBRookHorYR,
                fv.kingBRookHor,
                ofv.kingBRookHor);
-  expandOpen(fv.wRookHor,
+  }
+  if (isOwnedPart(3, part, parts)) {
+    expandOpen(fv.wRookHor,
                fv.kingWRookHorR,
                fv.kingWRookHorXR,
                fv.kingWRookHorYR,
                fv.kingWRookHor,
                ofv.kingWRookHor);
-  expandOpen(fv.bBishopDiagL45,
+  }
+  if (isOwnedPart(4, part, parts)) {
+    expandOpen(fv.bBishopDiagL45,
                fv.kingBBishopDiagL45R,
                fv.kingBBishopDiagL45XR,
                fv.kingBBishopDiagL45YR,
                fv.kingBBishopDiagL45,
                ofv.kingBBishopDiagL45);
-  expandOpen(fv.wBishopDiagL45,
+  }
+  if (isOwnedPart(5, part, parts)) {
+    expandOpen(fv.wBishopDiagL45,
                fv.kingWBishopDiagL45R,
                fv.kingWBishopDiagL45XR,
                fv.kingWBishopDiagL45YR,
                fv.kingWBishopDiagL45,
                ofv.kingWBishopDiagL45);
-  expandOpen(fv.bBishopDiagR45,
+  }
+  if (isOwnedPart(6, part, parts)) {
+    expandOpen(fv.bBishopDiagR45,
                fv.kingBBishopDiagR45R,
                fv.kingBBishopDiagR45XR,
                fv.kingBBishopDiagR45YR,
                fv.kingBBishopDiagR45,
                ofv.kingBBishopDiagR45);
-  expandOpen(fv.wBishopDiagR45,
+  }
+  if (isOwnedPart(7, part, parts)) {
+    expandOpen(fv.wBishopDiagR45,
                fv.kingWBishopDiagR45R,
                fv.kingWBishopDiagR45XR,
                fv.kingWBishopDiagR45YR,
                fv.kingWBishopDiagR45,
                ofv.kingWBishopDiagR45);
-  expandOpen(fv.bLance,
+  }
+  if (isOwnedPart(8, part, parts)) {
+    expandOpen(fv.bLance,
                fv.kingBLanceR,
                fv.kingBLanceXR,
                fv.kingBLanceYR,
                fv.kingBLance,
                ofv.kingBLance);
-  expandOpen(fv.wLance,
+  }
+  if (isOwnedPart(9, part, parts)) {
+    expandOpen(fv.wLance,
                fv.kingWLanceR,
                fv.kingWLanceXR,
                fv.kingWLanceYR,
                fv.kingWLance,
                ofv.kingWLance);
+  }
+}
+
+template <class FV, class OFV>
+inline
+void expand(FV& fv, OFV& ofv) {
+  expand(fv, ofv, 0, 1);
+}
+
+template <class FVRow, class Row, class T>
+inline
+void expandRow(FVRow& fvRow, const Row& row, T&& func) {
+  using FVType = typename std::remove_all_extents<FVRow>::type;
+  using Type = typename std::remove_all_extents<Row>::type;
+  auto out = reinterpret_cast<FVType*>(&fvRow);
+  auto in = reinterpret_cast<const Type*>(&row);
+  for (size_t i = 0; i < sizeof(Row) / sizeof(Type); i++) {
+    if (in[i] != 0) {
+      func(out[i], in[i]);
+    }
+  }
+}
+
+template <class Open,
+          class KingOpenR,
+          class KingOpenXR,
+          class KingOpenYR,
+          class KingOpen,
+          class Row,
+          class T>
+inline
+void expandOpenRow(Open open,
+                   KingOpenR kingOpenR,
+                   KingOpenXR kingOpenXR,
+                   KingOpenYR kingOpenYR,
+                   KingOpen kingOpen,
+                   Square king,
+                   const Row& row,
+                   T&& func) {
+  SQUARE_EACH(square) {
+    for (int i = 0; i < 8; i++) {
+      auto val = row[square.raw()][i];
+      if (val != 0) {
+        func(open[square.raw()][i], val);
+        func(kingOpenR[RelativeSquare(king, square).raw()][i], val);
+        func(kingOpenXR[king.getFile()-1][RelativeSquare(king, square).raw()][i], val);
+        func(kingOpenYR[king.getRank()-1][RelativeSquare(king, square).raw()][i], val);
+        func(kingOpen[king.raw()][square.raw()][i], val);
+      }
+    }
+  }
+}
+
+/**
+ * Call func(e, val) for each nonzero element val of the rows
+ * of the king square and for each element e of fv which expand()
+ * derives from it.
+ * `rows' has the rows of the king square of OptimizedFeatureVector
+ * as the members of the same names.
+ */
+template <class FV, class Rows, class T>
+inline
+void expandRows(FV& fv, Square king, const Rows& rows, T&& func) {
+  expandRow(fv.kingHand[king.raw()], rows.kingHand, func);
+
+  SQUARE_EACH(square) {
+    for (int i = 0; i < EvalPieceIndex::End; i++) {
+      auto val = rows.kingPiece[square.raw()][i];
+      if (val != 0) {
+        func(fv.kingPiece[king.raw()][square.raw()][i], val);
+        func(fv.kingPieceR[RelativeSquare(king, square).raw()][i], val);
+        func(fv.kingPieceXR[king.getFile()-1][RelativeSquare(king, square).raw()][i], val);
+        func(fv.kingPieceYR[king.getRank()-1][RelativeSquare(king, square).raw()][i], val);
+      }
+    }
+  }
+
+  expandRow(fv.kingNeighborHand[king.raw()], rows.kingNeighborHand, func);
+
+  for (int n = 0; n < Neighbor3x3::NN; n++) {
+    for (int i1 = 0; i1 < EvalPieceTypeIndex::End; i1++) {
+      SQUARE_EACH(square) {
+        for (int i2 = 0; i2 < EvalPieceIndex::End; i2++) {
+          auto val = rows.kingNeighborPiece[n][i1][square.raw()][i2];
+          if (val != 0) {
+            func(fv.kingNeighborPiece[king.raw()][n][i1][square.raw()][i2], val);
+            func(fv.kingNeighborPieceR[n][i1][RelativeSquare(king, square).raw()][i2], val);
+            func(fv.kingNeighborPieceXR[king.getFile()-1][n][i1][RelativeSquare(king, square).raw()][i2], val);
+            func(fv.kingNeighborPieceYR[king.getRank()-1][n][i1][RelativeSquare(king, square).raw()][i2], val);
+          }
+        }
+      }
+    }
+  }
 
-  FV_PART_COPY(fv, ofv, kingAllyEffect9);
-  FV_PART_COPY(fv, ofv, kingEnemyEffect9);
-  FV_PART_COPY(fv, ofv, kingAllyEffect25);
-  FV_PART_COPY(fv, ofv, kingEnemyEffect25);
+  expandRow(fv.kingKingHand[king.raw()], rows.kingKingHand, func);
+  expandRow(fv.kingKingPiece[king.raw()], rows.kingKingPiece, func);
+
+  expandOpenRow(fv.bRookVer,
+                fv.kingBRookVerR,
+                fv.kingBRookVerXR,
+                fv.kingBRookVerYR,
+                fv.kingBRookVer,
+                king, rows.kingBRookVer, func);
+  expandOpenRow(fv.wRookVer,
+                fv.kingWRookVerR,
+                fv.kingWRookVerXR,
+                fv.kingWRookVerYR,
+                fv.kingWRookVer,
+                king, rows.kingWRookVer, func);
+  expandOpenRow(fv.bRookHor,
+                fv.kingBRookHorR,
+                fv.kingBRookHorXR,
+                fv.kingBRookHorYR,
+                fv.kingBRookHor,
+                king, rows.kingBRookHor, func);
+  expandOpenRow(fv.wRookHor,
+                fv.kingWRookHorR,
+                fv.kingWRookHorXR,
+                fv.kingWRookHorYR,
+                fv.kingWRookHor,
+                king, rows.kingWRookHor, func);
+  expandOpenRow(fv.bBishopDiagL45,
+                fv.kingBBishopDiagL45R,
+                fv.kingBBishopDiagL45XR,
+                fv.kingBBishopDiagL45YR,
+                fv.kingBBishopDiagL45,
+                king, rows.kingBBishopDiagL45, func);
+  expandOpenRow(fv.wBishopDiagL45,
+                fv.kingWBishopDiagL45R,
+                fv.kingWBishopDiagL45XR,
+                fv.kingWBishopDiagL45YR,
+                fv.kingWBishopDiagL45,
+                king, rows.kingWBishopDiagL45, func);
+  expandOpenRow(fv.bBishopDiagR45,
+                fv.kingBBishopDiagR45R,
+                fv.kingBBishopDiagR45XR,
+                fv.kingBBishopDiagR45YR,
+                fv.kingBBishopDiagR45,
+                king, rows.kingBBishopDiagR45, func);
+  expandOpenRow(fv.wBishopDiagR45,
+                fv.kingWBishopDiagR45R,
+                fv.kingWBishopDiagR45XR,
+                fv.kingWBishopDiagR45YR,
+                fv.kingWBishopDiagR45,
+                king, rows.kingWBishopDiagR45, func);
+  expandOpenRow(fv.bLance,
+                fv.kingBLanceR,
+                fv.kingBLanceXR,
+                fv.kingBLanceYR,
+                fv.kingBLance,
+                king, rows.kingBLance, func);
+  expandOpenRow(fv.wLance,
+                fv.kingWLanceR,
+                fv.kingWLanceXR,
+                fv.kingWLanceYR,
+                fv.kingWLance,
+                king, rows.kingWLance, func);
+
+  expandRow(fv.kingAllyEffect9[king.raw()], rows.kingAllyEffect9, func);
+  expandRow(fv.kingEnemyEffect9[king.raw()], rows.kingEnemyEffect9, func);
+  expandRow(fv.kingAllyEffect25[king.raw()], rows.kingAllyEffect25, func);
+  expandRow(fv.kingEnemyEffect25[king.raw()], rows.kingEnemyEffect25, func);
 }
 
 template <class FV>
@@ -417,11 +663,11 @@ void symmetrizeOpen(Open open,
 
 template <class FV, class T>
 inline
-void symmetrize(FV& fv, T&& func) {
+void symmetrize(FV& fv, T&& func, int part, int parts) {
   // hand
   SQUARE_EACH(king) {
     auto rking = king.hsym();
-    if (rking.raw() > king.raw()) {
+    if (rking.raw() > king.raw() && isOwnedPart(king.raw(), part, parts)) {
       for (int h = 0; h < EvalHandIndex::End; h++) {
         func(fv.kingHand[king.raw()][h],
              fv.kingHand[rking.raw()][h]);
@@ -432,7 +678,7 @@ void symmetrize(FV& fv, T&& func) {
   // piece
   SQUARE_EACH(king) {
     auto rking = king.hsym();
-    if (rking.raw() < king.raw()) {
+    if (rking.raw() < king.raw() || !isOwnedPart(king.raw(), part, parts)) {
       continue;
     }
 
@@ -449,7 +695,7 @@ void symmetrize(FV& fv, T&& func) {
 
   for (int rs = 0; rs < RelativeSquare::N; rs++) {
     int rrs = RelativeSquare(rs).hsym().raw();
-    if (rrs < rs) {
+    if (rrs < rs || !isOwnedPart(rs, part, parts)) {
       continue;
     }
 
@@ -483,7 +729,7 @@ void symmetrize(FV& fv, T&& func) {
   // neighbor
   SQUARE_EACH(king) {
     auto rking = king.hsym();
-    if (rking.raw() < king.raw()) {
+    if (rking.raw() < king.raw() || !isOwnedPart(king.raw(), part, parts)) {
       continue;
     }
 
@@ -514,6 +760,9 @@ void symmetrize(FV& fv, T&& func) {
 
       SQUARE_EACH(king) {
         auto rking = king.hsym();
+        if (!isOwnedPart(std::min(king.raw(), rking.raw()), part, parts)) {
+          continue;
+        }
         if (rsquare != square || rn != n || rking.raw() > king.raw()) {
           for (int i1 = 0; i1 < EvalPieceTypeIndex::End; i1++) {
             for (int i2 = 0; i2 < EvalPieceIndex::End; i2++) {
@@ -537,6 +786,9 @@ void symmetrize(FV& fv, T&& func) {
       if (rn == n && rrs < rs) {
         continue;
       }
+      if (!isOwnedPart(std::min(rs, rrs), part, parts)) {
+        continue;
+      }
 
       if (rn != n || rrs > rs) {
         for (int i1 = 0; i1 < EvalPieceTypeIndex::End; i1++) {
@@ -576,7 +828,7 @@ void symmetrize(FV& fv, T&& func) {
   // KKH/KKP
   SQUARE_EACH(king1) {
     auto rking1 = king1.hsym();
-    if (rking1.raw() < king1.raw()) {
+    if (rking1.raw() < king1.raw() || !isOwnedPart(king1.raw(), part, parts)) {
       continue;
     }
 
@@ -608,71 +860,91 @@ void symmetrize(FV& fv, T&& func) {
   }
 
   // open
-  symmetrizeOpen(fv.bRookVer,
-                 fv.kingBRookVerR,
-                 fv.kingBRookVerXR,
-                 fv.kingBRookVerYR,
-                 fv.kingBRookVer,
-                 std::forward<T>(func));
-  symmetrizeOpen(fv.wRookVer,
-                 fv.kingWRookVerR,
-                 fv.kingWRookVerXR,
-                 fv.kingWRookVerYR,
-                 fv.kingWRookVer,
-                 std::forward<T>(func));
-  symmetrizeOpen(fv.bRookHor,
-                 fv.kingBRookHorR,
-                 fv.kingBRookHorXR,
-                 fv.kingBRookHorYR,
-                 fv.kingBRookHor,
-                 std::forward<T>(func));
-  symmetrizeOpen(fv.wRookHor,
-                 fv.kingWRookHorR,
-                 fv.kingWRookHorXR,
-                 fv.kingWRookHorYR,
-                 fv.kingWRookHor,
-                 std::forward<T>(func));
-  symmetrizeOpen(fv.bBishopDiagL45,
-                 fv.kingBBishopDiagL45R,
-                 fv.kingBBishopDiagL45XR,
-                 fv.kingBBishopDiagL45YR,
-                 fv.kingBBishopDiagL45,
-                 std::forward<T>(func));
-  symmetrizeOpen(fv.wBishopDiagL45,
-                 fv.kingWBishopDiagL45R,
-                 fv.kingWBishopDiagL45XR,
-                 fv.kingWBishopDiagL45YR,
-                 fv.kingWBishopDiagL45,
-                 std::forward<T>(func));
-  symmetrizeOpen(fv.bBishopDiagR45,
-                 fv.kingBBishopDiagR45R,
-                 fv.kingBBishopDiagR45XR,
-                 fv.kingBBishopDiagR45YR,
-                 fv.kingBBishopDiagR45,
-                 std::forward<T>(func));
-  symmetrizeOpen(fv.wBishopDiagR45,
-                 fv.kingWBishopDiagR45R,
-                 fv.kingWBishopDiagR45XR,
-                 fv.kingWBishopDiagR45YR,
-                 fv.kingWBishopDiagR45,
-                 std::forward<T>(func));
-  symmetrizeOpen(fv.bLance,
-                 fv.kingBLanceR,
-                 fv.kingBLanceXR,
-                 fv.kingBLanceYR,
-                 fv.kingBLance,
-                 std::forward<T>(func));
-  symmetrizeOpen(fv.wLance,
-                 fv.kingWLanceR,
-                 fv.kingWLanceXR,
-                 fv.kingWLanceYR,
-                 fv.kingWLance,
-                 std::forward<T>(func));
+  if (isOwnedPart(0, part, parts)) {
+    symmetrizeOpen(fv.bRookVer,
+                   fv.kingBRookVerR,
+                   fv.kingBRookVerXR,
+                   fv.kingBRookVerYR,
+                   fv.kingBRookVer,
+                   std::forward<T>(func));
+  }
+  if (isOwnedPart(1, part, parts)) {
+    symmetrizeOpen(fv.wRookVer,
+                   fv.kingWRookVerR,
+                   fv.kingWRookVerXR,
+                   fv.kingWRookVerYR,
+                   fv.kingWRookVer,
+                   std::forward<T>(func));
+  }
+  if (isOwnedPart(2, part, parts)) {
+    symmetrizeOpen(fv.bRookHor,
+                   fv.kingBRookHorR,
+                   fv.kingBRookHorXR,
+                   fv.kingBRookHorYR,
+                   fv.kingBRookHor,
+                   std::forward<T>(func));
+  }
+  if (isOwnedPart(3, part, parts)) {
+    symmetrizeOpen(fv.wRookHor,
+                   fv.kingWRookHorR,
+                   fv.kingWRookHorXR,
+                   fv.kingWRookHorYR,
+                   fv.kingWRookHor,
+                   std::forward<T>(func));
+  }
+  if (isOwnedPart(4, part, parts)) {
+    symmetrizeOpen(fv.bBishopDiagL45,
+                   fv.kingBBishopDiagL45R,
+                   fv.kingBBishopDiagL45XR,
+                   fv.kingBBishopDiagL45YR,
+                   fv.kingBBishopDiagL45,
+                   std::forward<T>(func));
+  }
+  if (isOwnedPart(5, part, parts)) {
+    symmetrizeOpen(fv.wBishopDiagL45,
+                   fv.kingWBishopDiagL45R,
+                   fv.kingWBishopDiagL45XR,
+                   fv.kingWBishopDiagL45YR,
+                   fv.kingWBishopDiagL45,
+                   std::forward<T>(func));
+  }
+  if (isOwnedPart(6, part, parts)) {
+    symmetrizeOpen(fv.bBishopDiagR45,
+                   fv.kingBBishopDiagR45R,
+                   fv.kingBBishopDiagR45XR,
+                   fv.kingBBishopDiagR45YR,
+                   fv.kingBBishopDiagR45,
+                   std::forward<T>(func));
+  }
+  if (isOwnedPart(7, part, parts)) {
+    symmetrizeOpen(fv.wBishopDiagR45,
+                   fv.kingWBishopDiagR45R,
+                   fv.kingWBishopDiagR45XR,
+                   fv.kingWBishopDiagR45YR,
+                   fv.kingWBishopDiagR45,
+                   std::forward<T>(func));
+  }
+  if (isOwnedPart(8, part, parts)) {
+    symmetrizeOpen(fv.bLance,
+                   fv.kingBLanceR,
+                   fv.kingBLanceXR,
+                   fv.kingBLanceYR,
+                   fv.kingBLance,
+                   std::forward<T>(func));
+  }
+  if (isOwnedPart(9, part, parts)) {
+    symmetrizeOpen(fv.wLance,
+                   fv.kingWLanceR,
+                   fv.kingWLanceXR,
+                   fv.kingWLanceYR,
+                   fv.kingWLance,
+                   std::forward<T>(func));
+  }
 
   // effect
   SQUARE_EACH(king) {
     auto rking = king.hsym();
-    if (rking.raw() <= king.raw()) {
+    if (rking.raw() <= king.raw() || !isOwnedPart(king.raw(), part, parts)) {
       continue;
     }
 
@@ -691,6 +963,12 @@ void symmetrize(FV& fv, T&& func) {
   }
 }
 
+template <class FV, class T>
+inline
+void symmetrize(FV& fv, T&& func) {
+  symmetrize(fv, std::forward<T>(func), 0, 1);
+}
+
 enum FeatureOperationType {
   Evaluate,
   Extract,
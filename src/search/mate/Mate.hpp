@@ -16,6 +16,7 @@ public:
   Mate() = delete;
 
   static bool mate1Ply(const Position& position) {
+    INSTRUMENT_SCOPE(Mate1Ply);
     if (position.getTurn() == Turn::Black) {
       return mate1Ply<Turn::Black>(position);
     } else {
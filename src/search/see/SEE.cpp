@@ -6,12 +6,14 @@
 #include "search/see/SEE.hpp"
 #include "search/eval/Material.hpp"
 #include "core/move/MoveTables.hpp"
+#include "common/time/Instrument.hpp"
 #include <algorithm>
 
 namespace sunfish {
 
 Score SEE::calculate(const Position& position,
                      Move move) {
+  INSTRUMENT_SCOPE(See);
   Square from;
   Square to = move.to();
   Piece piece;
@@ -0,0 +1,78 @@
+/* GameHistory.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "search/shek/GameHistory.hpp"
+#include "common/string/StringUtil.hpp"
+#include "core/record/Record.hpp"
+#include "logger/Logger.hpp"
+
+namespace sunfish {
+
+void GameHistory::clear() {
+  // releasing the positions is cheaper than clearing the whole table.
+  while (!entries_.empty()) {
+    pop();
+  }
+
+  hasInitialPosition_ = false;
+}
+
+bool GameHistory::update(const Record& record) {
+  auto hash = record.initialPosition.getHash();
+  if (!hasInitialPosition_ || hash != initialHash_) {
+    clear();
+    hasInitialPosition_ = true;
+    initialHash_ = hash;
+    position_ = record.initialPosition;
+  }
+
+  size_t common = 0;
+  while (common < entries_.size() &&
+         common < record.moveList.size() &&
+         entries_[common].move == record.moveList[common]) {
+    common++;
+  }
+
+  while (entries_.size() > common) {
+    pop();
+  }
+
+  for (size_t i = common; i < record.moveList.size(); i++) {
+    if (!push(record.moveList[i])) {
+      LOG(error) << "illegal move: " << StringUtil::ordinal(i) << ": "
+                 << record.moveList[i].toString();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool GameHistory::push(const Move& move) {
+  Entry entry;
+  entry.hash = position_.getHash();
+  entry.check = position_.inCheck();
+  entry.move = move;
+
+  shekTable_.retain(position_);
+
+  if (!position_.doMove(entry.move, entry.captured)) {
+    shekTable_.release(position_);
+    return false;
+  }
+
+  entries_.push_back(entry);
+
+  return true;
+}
+
+void GameHistory::pop() {
+  const auto& entry = entries_.back();
+  position_.undoMove(entry.move, entry.captured);
+  shekTable_.release(position_);
+  entries_.pop_back();
+}
+
+} // namespace sunfish
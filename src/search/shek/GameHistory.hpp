@@ -0,0 +1,78 @@
+/* GameHistory.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_SEARCH_SHEK_GAMEHISTORY_HPP__
+#define SUNFISH_SEARCH_SHEK_GAMEHISTORY_HPP__
+
+#include "search/shek/ShekTable.hpp"
+#include "core/move/Move.hpp"
+#include "core/position/Position.hpp"
+#include <vector>
+
+namespace sunfish {
+
+struct Record;
+
+/**
+ * The positions of the game before the root position.
+ * This is updated between searches and shared by all search threads.
+ */
+class GameHistory {
+public:
+
+  struct Entry {
+    Zobrist::Type hash;
+    bool check;
+    Move move;
+    Piece captured;
+  };
+
+  GameHistory() : hasInitialPosition_(false) {
+  }
+
+  GameHistory(const GameHistory&) = delete;
+  GameHistory(GameHistory&&) = delete;
+
+  void clear();
+
+  /**
+   * Update the history to the positions of the record.
+   * Only the moves which differ from the previous record are applied.
+   */
+  bool update(const Record& record);
+
+  const ShekTable& getShekTable() const {
+    return shekTable_;
+  }
+
+  size_t size() const {
+    return entries_.size();
+  }
+
+  /**
+   * Get the entry of the position which is `distance + 1' plies
+   * before the root position.
+   */
+  const Entry& getEntryFromLast(size_t distance) const {
+    return entries_[entries_.size() - distance - 1];
+  }
+
+private:
+
+  bool push(const Move& move);
+
+  void pop();
+
+  ShekTable shekTable_;
+  bool hasInitialPosition_;
+  Zobrist::Type initialHash_;
+  Position position_;
+  std::vector<Entry> entries_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_SEARCH_SHEK_GAMEHISTORY_HPP__
@@ -4,40 +4,13 @@
  */
 
 #include "search/shek/SCRDetector.hpp"
+#include "search/shek/GameHistory.hpp"
 #include "search/tree/Tree.hpp"
-#include "common/string/StringUtil.hpp"
-#include "core/record/Record.hpp"
 #include "core/position/Position.hpp"
-#include "logger/Logger.hpp"
+#include <algorithm>
 
 namespace sunfish {
 
-void SCRDetector::registerRecord(const Record& record) {
-  Position pos = record.initialPosition;
-
-  auto recordLength = record.moveList.size();
-
-  for (size_t i = 0; i < recordLength; i++) {
-    size_t ri = recordLength - i - 1;
-    if (ri < MaxLength) {
-      list_[ri].hash = pos.getHash();
-      list_[ri].check = pos.inCheck();
-    }
-
-    auto& move = record.moveList[i];
-    Piece captured;
-    if (!pos.doMove(move, captured)) {
-      length_ = 0;
-      LOG(error) << "illegal move: " << StringUtil::ordinal(i) << ": " << move.toString();
-      return;
-    }
-  }
-
-  // static_cast is required on Clang.
-  // See https://trello.com/c/iJqg1GqN
-  length_ = std::min(recordLength, static_cast<size_t>(MaxLength));
-}
-
 SCRState SCRDetector::detect(const Tree& tree) const {
   int repetitionCount = 0;
   bool isCurrentPlayerTurn = false;
@@ -69,8 +42,16 @@ SCRState SCRDetector::detect(const Tree& tree) const {
     }
   }
 
-  for (size_t i = 0; i < length_; i++) {
-    bool check = list_[i].check;
+  if (history_ == nullptr) {
+    return SCRState::None;
+  }
+
+  // static_cast is required on Clang.
+  // See https://trello.com/c/iJqg1GqN
+  auto length = std::min(history_->size(), static_cast<size_t>(MaxLength));
+  for (size_t i = 0; i < length; i++) {
+    const auto& entry = history_->getEntryFromLast(i);
+    bool check = entry.check;
     if (isCurrentPlayerTurn) {
       enemyPlayerChecking = enemyPlayerChecking && check;
       isCurrentPlayerTurn = false;
@@ -79,7 +60,7 @@ SCRState SCRDetector::detect(const Tree& tree) const {
       isCurrentPlayerTurn = true;
     }
 
-    if (list_[i].hash == tree.position.getHash()) {
+    if (entry.hash == tree.position.getHash()) {
       repetitionCount++;
       if (repetitionCount == 3) {
         return currentPlayerChecking ? SCRState::Lose :
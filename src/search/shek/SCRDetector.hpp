@@ -12,8 +12,8 @@
 
 namespace sunfish {
 
-struct Record;
 struct Tree;
+class GameHistory;
 
 enum class SCRState {
   None,
@@ -32,23 +32,25 @@ public:
 
   static CONSTEXPR_CONST LengthType MaxLength = 32;
 
-  struct Data {
-    Zobrist::Type hash;
-    bool check;
-  };
+  SCRDetector() : history_(nullptr) {
+  }
 
   void clear() {
-    length_ = 0;
+    history_ = nullptr;
   }
 
-  void registerRecord(const Record& record);
+  /**
+   * Set the game history which is referred after the path of the tree.
+   */
+  void setHistory(const GameHistory& history) {
+    history_ = &history;
+  }
 
   SCRState detect(const Tree& tree) const;
 
 private:
 
-  LengthType length_;
-  Data list_[MaxLength];
+  const GameHistory* history_;
 
 };
 
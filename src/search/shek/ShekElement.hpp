@@ -27,15 +27,20 @@ public:
   ShekElement() : data_(0LLU) {
   }
 
+  /**
+   * additionalCount is the number of the same positions
+   * which are retained in another table.
+   */
   ShekState check(const HandSet& handSet,
-                 Turn turn) const {
+                  Turn turn,
+                  DataType additionalCount = 0) const {
     ShekState shekState = handSet.compareTo(handSet_);
 
     Turn turn0 = data_ & TurnMask ? Turn::Black : Turn::White;
     switch (shekState) {
     case ShekState::Equal:
       return turn0 != turn ? ShekState::Superior :
-             count() >= 3  ? ShekState::Equal4 :
+             count() + additionalCount >= 3 ? ShekState::Equal4 :
                              ShekState::Equal;
     case ShekState::Superior:
       return turn  == Turn::Black ? ShekState::Superior :
@@ -82,12 +87,12 @@ public:
     return handSet_;
   }
 
-private:
-
   DataType count() const {
     return data_ & CountMask;
   }
 
+private:
+
   HandSet handSet_;
   DataType data_;
 
@@ -37,6 +37,24 @@ public:
     return nullptr;
   }
 
+  const ShekElement* findSlot(Zobrist::Type hash) const {
+    for (SizeType i = 0; i < Size; i++) {
+      if (slots_[i].checkHash(hash)) {
+        return &slots_[i];
+      }
+    }
+    return nullptr;
+  }
+
+  const ShekElement* findSlot(Zobrist::Type hash, const HandSet& handSet) const {
+    for (SizeType i = 0; i < Size; i++) {
+      if (slots_[i].checkHash(hash) && slots_[i].handSet() == handSet) {
+        return &slots_[i];
+      }
+    }
+    return nullptr;
+  }
+
   ShekElement* findVacantSlot() {
     for (SizeType i = 0; i < Size; i++) {
       if (slots_[i].isVacant()) {
@@ -17,13 +17,16 @@ public:
 
   static CONSTEXPR_CONST unsigned Width = 16;
 
-  static_assert(1LLU << Width > ~ShekElement::HashMask, "invalid hash table size");
+  /** the width for the positions on the path of a search tree */
+  static CONSTEXPR_CONST unsigned PathWidth = 10;
 
-  ShekTable() : HashTable<ShekSlots>(Width) {}
+  static_assert(1LLU << PathWidth > ~ShekElement::HashMask, "invalid hash table size");
+
+  explicit ShekTable(unsigned width = Width) : HashTable<ShekSlots>(width) {}
   ShekTable(const ShekTable&) = delete;
   ShekTable(ShekTable&&) = delete;
 
-  ShekState check(const Position& position) {
+  ShekState check(const Position& position) const {
     auto hash = position.getBoardHash();
     auto& slots = getElement(hash);
     auto element = slots.findSlot(hash);
@@ -36,7 +39,31 @@ public:
                           position.getTurn());
   }
 
-  void retain(const Position& position) {
+  /**
+   * Check the position with the positions in this table
+   * and the positions of the game history.
+   * The history takes precedence as if they were retained in one table.
+   */
+  ShekState check(const Position& position,
+                  const ShekTable& history) const {
+    auto hash = position.getBoardHash();
+    auto element = history.getElement(hash).findSlot(hash);
+    if (element == nullptr) {
+      return check(position);
+    }
+
+    auto pathElement = getElement(hash).findSlot(hash, element->handSet());
+    HandSet handSet(position.getBlackHand());
+    return element->check(handSet,
+                          position.getTurn(),
+                          pathElement != nullptr ? pathElement->count() : 0);
+  }
+
+  /**
+   * Retain the position.
+   * false is returned if there are no vacant slots.
+   */
+  bool retain(const Position& position) {
     auto hash = position.getBoardHash();
     auto& slots = getElement(hash);
     HandSet handSet(position.getBlackHand());
@@ -44,15 +71,18 @@ public:
     auto element = slots.findSlot(hash, handSet);
     if (element != nullptr) {
       element->retain();
-      return;
+      return true;
     }
 
     element = slots.findVacantSlot();
-    if (element != nullptr) {
-      element->setAndRetain(hash,
-                            handSet,
-                            position.getTurn());
+    if (element == nullptr) {
+      return false;
     }
+
+    element->setAndRetain(hash,
+                          handSet,
+                          position.getTurn());
+    return true;
   }
 
   void release(const Position& position) {
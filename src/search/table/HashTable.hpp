@@ -8,7 +8,10 @@
 
 #include "common/Def.hpp"
 #include "common/memory/Memory.hpp"
+#include "common/file_system/MappedFile.hpp"
+#include "common/thread/Numa.hpp"
 #include "core/position/Zobrist.hpp"
+#include <string>
 #include <cstdint>
 
 namespace sunfish {
@@ -43,6 +46,7 @@ public:
 public:
 
   HashTable(unsigned width = DefaultWidth) :
+      p_(nullptr),
       table_(nullptr),
       size_(0) {
     resize(width);
@@ -51,29 +55,35 @@ public:
   HashTable(HashTable&&) = delete;
 
   ~HashTable() {
-    delete [] p_;
+    release();
   }
 
   HashTable& operator=(const HashTable&) = delete;
   HashTable& operator=(HashTable&&) = delete;
 
   void clear() {
+    if (file_.isOpen()) {
+      // writing the mapped elements would copy all pages of the file.
+      unsigned width = getWidth();
+      release();
+      resize(width);
+      return;
+    }
+
     for (SizeType i = 0; i < size_; i++) {
       table_[i] = Element();
     }
   }
 
   void resize(unsigned width) {
-    SizeType newSize = 1 << width;
+    SizeType newSize = static_cast<SizeType>(1) << width;
     if (newSize == size_) {
       return;
     }
 
+    release();
     size_ = newSize;
     mask_ = size_ - 1;
-    if (table_ != nullptr) {
-      delete[] p_;
-    }
     p_ = new uint8_t[size_ * sizeof(Element) + CacheLineSize - 1];
     table_ = reinterpret_cast<Element*>(p_ + CacheLineSize - 1 - (reinterpret_cast<uintptr_t>(p_) - 1) % CacheLineSize);
     clear();
@@ -82,7 +92,7 @@ public:
   void resizeMB(unsigned mebiBytes) {
     unsigned width = 8;
     for (; width < 32; width++) {
-      SizeType size = 1 << width;
+      SizeType size = static_cast<SizeType>(1) << width;
       size_t sb = sizeof(Element) * size;
       if (sb > mebiBytes * 1024 * 1024) {
         break;
@@ -91,10 +101,64 @@ public:
     resize(width - 1);
   }
 
+  /**
+   * Use the elements mapped from a file instead of allocating them.
+   * The file is mapped copy-on-write, so that the pages are read
+   * on demand and the modifications are not written back.
+   * The elements must be placed at `offset' of the file.
+   * The table is cleared with the previous size on failure.
+   * clear() replaces the mapped elements with the allocated ones.
+   */
+  bool map(const std::string& path, size_t offset, unsigned width) {
+    unsigned oldWidth = getWidth();
+    release();
+
+    if (width >= sizeof(SizeType) * 8) {
+      resize(oldWidth);
+      return false;
+    }
+
+    SizeType newSize = static_cast<SizeType>(1) << width;
+    if (offset % CacheLineSize != 0 ||
+        !file_.openPrivate(path) ||
+        file_.size() != offset + sizeof(Element) * newSize) {
+      file_.close();
+      resize(oldWidth);
+      return false;
+    }
+
+    size_ = newSize;
+    mask_ = size_ - 1;
+    table_ = reinterpret_cast<Element*>(static_cast<uint8_t*>(file_.data()) + offset);
+    return true;
+  }
+
   SizeType getSize() const {
     return size_;
   }
 
+  unsigned getWidth() const {
+    unsigned width = 0;
+    while ((static_cast<SizeType>(1) << width) < size_) {
+      width++;
+    }
+    return width;
+  }
+
+  /**
+   * Move the elements to the NUMA node.
+   */
+  bool bind(unsigned node) {
+    return Numa::bindMemory(table_, sizeof(Element) * size_, node);
+  }
+
+  /**
+   * Interleave the elements across the NUMA nodes.
+   */
+  bool interleave() {
+    return Numa::interleaveMemory(table_, sizeof(Element) * size_);
+  }
+
   void prefetch(Zobrist::Type hash) const {
     const Element* p = &table_[hash & mask_];
     const char* addr = reinterpret_cast<const char*>(p);
@@ -120,7 +184,17 @@ protected:
   }
 
 private:
+
+  void release() {
+    delete[] p_;
+    p_ = nullptr;
+    file_.close();
+    table_ = nullptr;
+    size_ = 0;
+  }
+
   uint8_t* p_;
+  MappedFile file_;
   Element* table_;
   SizeType size_;
   SizeType mask_;
@@ -0,0 +1,85 @@
+/* SearchTrace.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "search/trace/SearchTrace.hpp"
+#include "logger/Logger.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace sunfish {
+
+void SearchTraceBuffer::initialize(size_t capacity, unsigned sampleRate) {
+  // the buffer is kept to reuse it for the next search.
+  if (capacity != capacity_) {
+    std::vector<SearchTrace::Event>().swap(events_);
+    events_.reserve(capacity);
+  }
+  events_.clear();
+
+  capacity_ = capacity;
+  sampleRate_ = std::min(std::max(sampleRate, 1u), 0xffffu);
+  iteration_ = 0;
+  sampled_ = false;
+  subtrees_ = 0;
+  dropped_ = 0;
+}
+
+bool SearchTraceWriter::open(const std::string& path) {
+  file_.open(path, std::ios::out | std::ios::binary);
+  if (!file_) {
+    LOG(error) << "could not open a file: " << path;
+    return false;
+  }
+
+  path_ = path;
+  numberOfSearches_ = 0;
+
+  SearchTrace::Header header = { SearchTrace::Magic, SearchTrace::Version, 0 };
+  file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (file_.fail()) {
+    LOG(error) << "file I/O error: " << path_;
+    return false;
+  }
+
+  return true;
+}
+
+bool SearchTraceWriter::close() {
+  file_.close();
+  if (file_.fail()) {
+    LOG(error) << "file I/O error: " << path_;
+    return false;
+  }
+  return true;
+}
+
+bool SearchTraceWriter::write(uint32_t search,
+                              unsigned thread,
+                              const SearchTraceBuffer& buffer) {
+  const auto& events = buffer.getEvents();
+  auto dropped = std::min<uint64_t>(buffer.getDropped(),
+                                    std::numeric_limits<uint32_t>::max());
+
+  SearchTrace::ChunkHeader header;
+  header.search = search;
+  header.thread = static_cast<uint16_t>(thread);
+  header.sampleRate = static_cast<uint16_t>(buffer.getSampleRate());
+  header.numberOfEvents = static_cast<uint32_t>(events.size());
+  header.dropped = static_cast<uint32_t>(dropped);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file_.write(reinterpret_cast<const char*>(events.data()),
+              sizeof(SearchTrace::Event) * events.size());
+  if (file_.fail()) {
+    LOG(error) << "file I/O error: " << path_;
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace sunfish
@@ -0,0 +1,240 @@
+/* SearchTrace.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_SEARCH_TRACE_SEARCHTRACE_HPP__
+#define SUNFISH_SEARCH_TRACE_SEARCHTRACE_HPP__
+
+#include "common/Def.hpp"
+#include <fstream>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace sunfish {
+
+/**
+ * The file format of the search trace.
+ *
+ *   header : magic and version
+ *   chunks : the chunk header and the events of a thread,
+ *            which are written for each search and each thread
+ *
+ * The nodes of ply 0 are not traced, and the subtrees of ply 1 are
+ * sampled with the rate written in the chunk header.
+ */
+struct SearchTrace {
+  static CONSTEXPR_CONST uint32_t Magic = 0x52544653; // "SFTR"
+  static CONSTEXPR_CONST uint16_t Version = 1;
+
+  enum EventType : uint8_t {
+    Enter,
+    Exit,
+    TTHit,
+    HashCut,
+    NullMovePruning,
+    FutilityPruning,
+    Razoring,
+    ProbCut,
+    NumberOfEventTypes,
+  };
+
+  struct Header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+  };
+
+  struct ChunkHeader {
+    uint32_t search;
+    uint16_t thread;
+    uint16_t sampleRate;
+    uint32_t numberOfEvents;
+    uint32_t dropped;
+  };
+
+  /**
+   * depth is in the unit of Searcher::Depth1Ply,
+   * and iteration is the depth of the iterative deepening in plies.
+   * score is the result of Exit, the TT score of TTHit
+   * and the returned score of the pruning.
+   */
+  struct Event {
+    uint8_t type;
+    uint8_t ply;
+    uint16_t rootMove;
+    uint16_t iteration;
+    int16_t depth;
+    int16_t alpha;
+    int16_t beta;
+    int16_t score;
+    uint16_t reserved;
+  };
+};
+
+static_assert(sizeof(SearchTrace::Header) == 8, "invalid struct size");
+static_assert(sizeof(SearchTrace::ChunkHeader) == 16, "invalid struct size");
+static_assert(sizeof(SearchTrace::Event) == 16, "invalid struct size");
+
+/**
+ * The bounded buffer of the events of a thread.
+ * The events after the buffer is full are counted as dropped.
+ */
+class SearchTraceBuffer {
+public:
+
+  SearchTraceBuffer() :
+      capacity_(0),
+      sampleRate_(1),
+      iteration_(0),
+      sampled_(false),
+      subtrees_(0),
+      dropped_(0) {
+  }
+  SearchTraceBuffer(const SearchTraceBuffer&) = delete;
+  SearchTraceBuffer(SearchTraceBuffer&&) = delete;
+
+  /**
+   * Clear the events and set the capacity.
+   * The trace is disabled if capacity is 0.
+   */
+  void initialize(size_t capacity, unsigned sampleRate);
+
+  bool isEnabled() const {
+    return capacity_ != 0;
+  }
+
+  void setIteration(int iteration) {
+    iteration_ = static_cast<uint16_t>(iteration);
+  }
+
+  void record(SearchTrace::EventType type,
+              int ply,
+              uint16_t rootMove,
+              int depth,
+              int alpha,
+              int beta,
+              int score) {
+    // the subtree is sampled when its root is entered.
+    if (type == SearchTrace::Enter && ply == 1) {
+      sampled_ = subtrees_++ % sampleRate_ == 0;
+    }
+
+    if (!sampled_) {
+      return;
+    }
+
+    if (events_.size() >= capacity_) {
+      dropped_++;
+      return;
+    }
+
+    SearchTrace::Event event;
+    event.type = type;
+    event.ply = static_cast<uint8_t>(ply);
+    event.rootMove = rootMove;
+    event.iteration = iteration_;
+    event.depth = static_cast<int16_t>(depth);
+    event.alpha = static_cast<int16_t>(alpha);
+    event.beta = static_cast<int16_t>(beta);
+    event.score = static_cast<int16_t>(score);
+    event.reserved = 0;
+    events_.push_back(event);
+  }
+
+  const std::vector<SearchTrace::Event>& getEvents() const {
+    return events_;
+  }
+
+  unsigned getSampleRate() const {
+    return sampleRate_;
+  }
+
+  uint64_t getDropped() const {
+    return dropped_;
+  }
+
+private:
+
+  std::vector<SearchTrace::Event> events_;
+  size_t capacity_;
+  unsigned sampleRate_;
+  uint16_t iteration_;
+  bool sampled_;
+  uint64_t subtrees_;
+  uint64_t dropped_;
+
+};
+
+/**
+ * Write the buffers of the searches to a file.
+ * write() can be called concurrently by the independent searchers.
+ */
+class SearchTraceWriter {
+public:
+
+  static CONSTEXPR_CONST size_t DefaultCapacity = 1024 * 1024;
+  static CONSTEXPR_CONST unsigned DefaultSampleRate = 1;
+
+  SearchTraceWriter() :
+      capacity_(DefaultCapacity),
+      sampleRate_(DefaultSampleRate),
+      numberOfSearches_(0) {
+  }
+  SearchTraceWriter(const SearchTraceWriter&) = delete;
+  SearchTraceWriter(SearchTraceWriter&&) = delete;
+
+  bool open(const std::string& path);
+
+  bool close();
+
+  /**
+   * Get the index of a new search.
+   */
+  uint32_t nextSearch() {
+    return numberOfSearches_++;
+  }
+
+  bool write(uint32_t search,
+             unsigned thread,
+             const SearchTraceBuffer& buffer);
+
+  size_t getCapacity() const {
+    return capacity_;
+  }
+
+  /**
+   * Set the number of the events of each thread in a search.
+   */
+  void setCapacity(size_t capacity) {
+    capacity_ = capacity;
+  }
+
+  unsigned getSampleRate() const {
+    return sampleRate_;
+  }
+
+  /**
+   * Set the rate to record one of the subtrees of ply 1.
+   */
+  void setSampleRate(unsigned sampleRate) {
+    sampleRate_ = sampleRate;
+  }
+
+private:
+
+  std::mutex mutex_;
+  std::ofstream file_;
+  std::string path_;
+  size_t capacity_;
+  unsigned sampleRate_;
+  std::atomic<uint32_t> numberOfSearches_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_SEARCH_TRACE_SEARCHTRACE_HPP__
@@ -6,45 +6,22 @@
 #include "search/tree/Tree.hpp"
 #include "search/tt/TT.hpp"
 #include "search/eval/Evaluator.hpp"
-#include "core/record/Record.hpp"
+#include "search/shek/GameHistory.hpp"
 #include "logger/Logger.hpp"
 #include <sstream>
 
-namespace {
-
-using namespace sunfish;
-
-void initializeShekTable(ShekTable& shekTable,
-                         const Record* record) {
-  shekTable.clear();
-
-  if (record == nullptr) {
-    return;
-  }
-
-  Position pos = record->initialPosition;
-  for (auto& move : record->moveList) {
-    shekTable.retain(pos);
-
-    Piece captured;
-    if (!pos.doMove(move, captured)) {
-      LOG(error) << "illegal move: " << move.toString();
-      return;
-    }
-  }
-}
-
-} // namespace
-
 namespace sunfish {
 
 void initializeTree(Tree& tree,
                     const Position& position,
                     Evaluator& eval,
-                    const Record* record) {
+                    const GameHistory& history) {
   tree.position = position;
   tree.ply = 0;
 
+  // the evaluator can be a replica on the NUMA node of the tree.
+  tree.evaluator = &eval;
+
   initializeSearchInfo(tree.info);
 
   tree.nodes[0].materialScore = eval.calculateMaterialScore(tree.position);
@@ -53,14 +30,13 @@ void initializeTree(Tree& tree,
   tree.nodes[0].killerMove2 = Move::none();
 
   // SHEK
-  initializeShekTable(tree.shekTable, record);
+  // the game history is shared by all trees,
+  // and only the path of the tree is retained in shekTable.
+  tree.shekTable.clear();
+  tree.history = &history;
 
   // successive checks repetition detector
-  if (record != nullptr) {
-    tree.scr.registerRecord(*record);
-  } else {
-    tree.scr.clear();
-  }
+  tree.scr.setHistory(history);
 }
 
 void visit(Tree& tree) {
@@ -129,7 +105,11 @@ void addKiller(Tree& tree, Move move) {
 bool doMove(Tree& tree, Move& move, Evaluator& eval, TT& tt) {
   auto& node = tree.nodes[tree.ply];
   node.hash = tree.position.getHash();
-  tree.shekTable.retain(tree.position);
+  if (!tree.shekTable.retain(tree.position)) {
+#if SUNFISH_TABLE_STATS
+    tree.info.shekReject++;
+#endif
+  }
 
   if (!tree.position.doMove(move, node.captured)) {
     tree.shekTable.release(tree.position);
@@ -187,8 +167,18 @@ Score calculateStandPat(Tree& tree,
   auto& node = tree.nodes[tree.ply];
 
   if (node.score == Score::invalid()) {
+    EvalCacheStatus status;
     node.score = eval.calculateTotalScore(node.materialScore,
-                                          tree.position);
+                                          tree.position,
+                                          status);
+#if SUNFISH_TABLE_STATS
+    tree.info.evalCacheProbe++;
+    if (status == EvalCacheStatus::Hit) {
+      tree.info.evalCacheHit++;
+    } else if (status == EvalCacheStatus::Replace) {
+      tree.info.evalCacheReplace++;
+    }
+#endif
   }
 
   if (tree.position.getTurn() == Turn::Black) {
@@ -12,6 +12,7 @@
 #include "search/shek/ShekTable.hpp"
 #include "search/shek/SCRDetector.hpp"
 #include "search/SearchInfo.hpp"
+#include "search/trace/SearchTrace.hpp"
 #include "core/move/Moves.hpp"
 #include "core/position/Position.hpp"
 #include <string>
@@ -20,7 +21,7 @@
 
 namespace sunfish {
 
-struct Record;
+class GameHistory;
 class Evaluator;
 class TT;
 
@@ -81,8 +82,11 @@ struct Tree {
   int index;
   int completedDepth;
   Position position;
-  ShekTable shekTable;
+  ShekTable shekTable { ShekTable::PathWidth };
+  const GameHistory* history;
+  Evaluator* evaluator;
   SearchInfo info;
+  SearchTraceBuffer trace;
   int ply;
   Node nodes[StackSize];
   SCRDetector scr;
@@ -91,7 +95,7 @@ struct Tree {
 void initializeTree(Tree& tree,
                     const Position& position,
                     Evaluator& eval,
-                    const Record* record);
+                    const GameHistory& history);
 
 void visit(Tree& tree);
 
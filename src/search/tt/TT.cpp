@@ -0,0 +1,107 @@
+/* TT.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "search/tt/TT.hpp"
+#include "core/position/Position.hpp"
+#include "logger/Logger.hpp"
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+using namespace sunfish;
+
+uint64_t hashKey() {
+  static const Zobrist::Type hash = Position(Position::Handicap::Even).getHash();
+  return hash;
+}
+
+} // namespace
+
+namespace sunfish {
+
+const char TT::SnapshotMagic[4] = { 'S', 'F', 'T', 'T' };
+
+bool TT::save(const std::string& path) const {
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+  header.version = SnapshotVersion;
+  header.elementSize = sizeof(Element);
+  header.width = getWidth();
+  header.hashKey = hashKey();
+
+  // the snapshot may be mapped by this table,
+  // so a new file is written and renamed.
+  std::string tmpPath = path + ".tmp";
+  std::ofstream file(tmpPath, std::ios::out | std::ios::binary);
+  if (!file) {
+    LOG(error) << "could not open a file: " << tmpPath;
+    return false;
+  }
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(&getElement(static_cast<SizeType>(0))),
+             sizeof(Element) * getSize());
+  file.close();
+
+  if (file.fail()) {
+    LOG(error) << "file I/O error: " << tmpPath;
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+
+  std::remove(path.c_str());
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    LOG(error) << "could not rename a file: " << tmpPath;
+    return false;
+  }
+
+  return true;
+}
+
+bool TT::load(const std::string& path) {
+  SnapshotHeader header;
+  {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file) {
+      LOG(error) << "could not open a file: " << path;
+      return false;
+    }
+
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (file.fail() ||
+        memcmp(header.magic, SnapshotMagic, sizeof(header.magic)) != 0) {
+      LOG(error) << "invalid TT snapshot: " << path;
+      return false;
+    }
+  }
+
+  if (header.version != SnapshotVersion ||
+      header.elementSize != sizeof(Element)) {
+    LOG(error) << "unsupported version of TT snapshot: " << header.version;
+    return false;
+  }
+
+  if (header.hashKey != hashKey()) {
+    LOG(error) << "the hash keys of TT snapshot are different: " << path;
+    return false;
+  }
+
+  if (header.width >= 32) {
+    LOG(error) << "invalid TT snapshot: " << path;
+    return false;
+  }
+
+  if (!map(path, sizeof(header), header.width)) {
+    LOG(error) << "could not map TT snapshot: " << path;
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace sunfish
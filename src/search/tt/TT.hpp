@@ -9,7 +9,9 @@
 #include "search/tt/TTSlots.hpp"
 #include "search/table/HashTable.hpp"
 #include "core/position/Zobrist.hpp"
+#include "common/time/Instrument.hpp"
 #include <algorithm>
+#include <string>
 #include <cstdint>
 
 namespace sunfish {
@@ -19,6 +21,26 @@ public:
 
   static CONSTEXPR_CONST unsigned DefaultWidth = 18;
 
+  /**
+   * The header of a snapshot file, which is followed by the elements.
+   * hashKey is the hash value of the initial position
+   * to reject the snapshots made with the other Zobrist keys.
+   */
+  struct SnapshotHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t elementSize;
+    uint32_t width;
+    uint32_t reserved;
+    uint64_t hashKey;
+    uint8_t padding[40];
+  };
+
+  static CONSTEXPR_CONST uint16_t SnapshotVersion = 1;
+  static const char SnapshotMagic[4];
+
+  static_assert(sizeof(SnapshotHeader) == CacheLineSize, "invalid struct size");
+
   TT() : HashTable<TTSlots>(DefaultWidth) {}
   TT(const TT&) = delete;
   TT(TT&&) = delete;
@@ -31,6 +53,7 @@ public:
                  int ply,
                  const Move& move,
                  bool mateThreat) {
+    INSTRUMENT_SCOPE(TTStore);
     TTElement element;
     TTSlots& slots = getElement(hash);
     slots.get(hash, element);
@@ -48,10 +71,32 @@ public:
   }
 
   bool get(Zobrist::Type hash, TTElement& e) {
+    INSTRUMENT_SCOPE(TTProbe);
     return getElement(hash).get(hash, e) &&
            e.checkHash(hash);
   }
 
+  /**
+   * mismatch is set to true if the element is not found
+   * and the slots hold the other positions.
+   */
+  bool get(Zobrist::Type hash, TTElement& e, bool& mismatch) {
+    INSTRUMENT_SCOPE(TTProbe);
+    return getElement(hash).get(hash, e, mismatch) &&
+           e.checkHash(hash);
+  }
+
+  /**
+   * Write all the elements to a file.
+   */
+  bool save(const std::string& path) const;
+
+  /**
+   * Map a snapshot file instead of the allocated elements.
+   * The size of TT is changed to the size of the snapshot.
+   */
+  bool load(const std::string& path);
+
   float usageRates() const {
     uint64_t usage = 0;
     auto size = std::min(getSize(), (uint32_t)10000);
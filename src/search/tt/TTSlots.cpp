@@ -42,6 +42,21 @@ bool TTSlots::get(Zobrist::Type hash, TTElement& element) {
 
 }
 
+bool TTSlots::get(Zobrist::Type hash, TTElement& element, bool& mismatch) {
+  mismatch = false;
+  for (SizeType i = 0; i < Size; i++) {
+    TTElement e = slots_[i];
+    if (e.checkHash(hash)) {
+      element = e;
+      return true;
+    }
+    if (e.isLive()) {
+      mismatch = true;
+    }
+  }
+  return false;
+}
+
 unsigned TTSlots::fullCount() const {
   unsigned count = 0;
   for (SizeType i = 0; i < Size; i++) {
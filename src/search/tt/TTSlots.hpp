@@ -34,6 +34,11 @@ public:
 
   bool get(Zobrist::Type hash, TTElement& element);
 
+  /**
+   * mismatch is set to true if a live slot fails the hash check.
+   */
+  bool get(Zobrist::Type hash, TTElement& element, bool& mismatch);
+
   unsigned fullCount() const;
 
 private:
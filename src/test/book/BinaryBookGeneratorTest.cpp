@@ -0,0 +1,88 @@
+/* BinaryBookGeneratorTest.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "test/Test.hpp"
+#include "book/BookGenerator.hpp"
+#include "book/BinaryBookGenerator.hpp"
+#include "book/BinaryBook.hpp"
+#include "core/position/Position.hpp"
+#include "core/record/SfenParser.hpp"
+#include <cstdio>
+
+using namespace sunfish;
+
+namespace {
+
+const char* const TestBookPath = "test_book_gen.sfbk";
+
+} // namespace
+
+TEST(BinaryBookGeneratorTest, test) {
+  BookGenerator bookGenerator("kifu/test/book_gen");
+  bookGenerator.setLimit(20);
+  ASSERT_TRUE(bookGenerator.generate());
+  const Book& book = bookGenerator.getBook();
+
+  {
+    // the small run size makes the generator spill many run files.
+    BinaryBookGenerator binaryBookGenerator("kifu/test/book_gen");
+    binaryBookGenerator.setLimit(20);
+    binaryBookGenerator.setNumberOfThreads(2);
+    binaryBookGenerator.setRunSize(16);
+    ASSERT_TRUE(binaryBookGenerator.generate(TestBookPath));
+
+    BinaryBook binaryBook;
+    ASSERT_TRUE(binaryBook.open(TestBookPath));
+    ASSERT_EQ(book.getMap().size(), binaryBook.getNumberOfEntries());
+
+    for (const auto& pair : book.getMap()) {
+      Position pos;
+      SfenParser::parsePosition(pair.first, pos);
+
+      auto bookMoves = binaryBook.get(pos);
+      ASSERT_EQ(pair.second.size(), bookMoves.size());
+
+      for (const auto& bookMove : pair.second) {
+        bool found = false;
+        for (size_t i = 0; i < bookMoves.size(); i++) {
+          if (bookMoves.move(i) == bookMove.move) {
+            ASSERT_EQ(bookMove.count, bookMoves.count(i));
+            found = true;
+          }
+        }
+        ASSERT_TRUE(found);
+      }
+    }
+  }
+
+  {
+    BinaryBookGenerator binaryBookGenerator("kifu/test/book_gen");
+    binaryBookGenerator.setLimit(20);
+    binaryBookGenerator.setThreshold(2);
+    ASSERT_TRUE(binaryBookGenerator.generate(TestBookPath));
+
+    BinaryBook binaryBook;
+    ASSERT_TRUE(binaryBook.open(TestBookPath));
+
+    std::string sfen = "lnsgkgsnl/1r5b1/ppppppppp/9/9/9/PPPPPPPPP/1B5R1/LNSGKGSNL b - 1";
+    Position pos;
+    SfenParser::parsePosition(sfen, pos);
+
+    auto bookMoves = binaryBook.get(pos);
+    ASSERT_EQ(1, (int)bookMoves.size());
+    ASSERT_EQ(Move(Square::s77(), Square::s76(), false), bookMoves.move(0));
+    ASSERT_EQ(3, bookMoves.count(0));
+
+    for (const auto& pair : book.getMap()) {
+      SfenParser::parsePosition(pair.first, pos);
+      bookMoves = binaryBook.get(pos);
+      for (size_t i = 0; i < bookMoves.size(); i++) {
+        ASSERT_TRUE(bookMoves.count(i) >= 2);
+      }
+    }
+  }
+
+  std::remove(TestBookPath);
+}
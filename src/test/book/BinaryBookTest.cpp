@@ -0,0 +1,77 @@
+/* BinaryBookTest.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "test/Test.hpp"
+#include "book/Book.hpp"
+#include "book/BinaryBook.hpp"
+#include "core/position/Position.hpp"
+#include "core/record/SfenParser.hpp"
+#include <cstdio>
+
+using namespace sunfish;
+
+namespace {
+
+const char* const TestBookPath = "test_book.sfbk";
+
+} // namespace
+
+TEST(BinaryBookTest, test) {
+  Book book;
+
+  std::string sfen = "lnsgkgsnl/1r5b1/ppppppppp/9/9/9/PPPPPPPPP/1B5R1/LNSGKGSNL b - 1";
+  Position pos1;
+  SfenParser::parsePosition(sfen, pos1);
+
+  book.insert(pos1, Move(Square::s77(), Square::s76(), false), 2);
+  book.insert(pos1, Move(Square::s27(), Square::s26(), false));
+
+  // the same position as pos1 except the move number
+  sfen = "lnsgkgsnl/1r5b1/ppppppppp/9/9/9/PPPPPPPPP/1B5R1/LNSGKGSNL b - 3";
+  Position pos1b;
+  SfenParser::parsePosition(sfen, pos1b);
+
+  book.insert(pos1b, Move(Square::s77(), Square::s76(), false), 3);
+
+  sfen = "ln1gkgsnl/1r1s3b1/p1pp1p1pp/1p2p1p2/9/2PPP4/PP3PPPP/1B1S3R1/LN1GKGSNL b - 1";
+  Position pos2;
+  SfenParser::parsePosition(sfen, pos2);
+
+  book.insert(pos2, Move(Square::s39(), Square::s48(), false), 7);
+
+  sfen = "ln1gkg1nl/1r1s2sb1/p1pp1p1pp/1p2p1p2/9/2PPP4/PP3PPPP/1B1SGS1R1/LN1GK2NL w - 1";
+  Position pos3;
+  SfenParser::parsePosition(sfen, pos3);
+
+  ASSERT_TRUE(BinaryBook::write(book, TestBookPath));
+
+  {
+    BinaryBook binaryBook;
+    ASSERT_TRUE(binaryBook.open(TestBookPath));
+    ASSERT_EQ(2, (int)binaryBook.getNumberOfEntries());
+    ASSERT_EQ(3, (int)binaryBook.getNumberOfMoves());
+
+    auto bookMoves = binaryBook.get(pos1);
+    ASSERT_EQ(2, (int)bookMoves.size());
+    for (size_t i = 0; i < bookMoves.size(); i++) {
+      if (bookMoves.move(i) == Move(Square::s77(), Square::s76(), false)) {
+        ASSERT_EQ(5, bookMoves.count(i));
+      } else {
+        ASSERT_EQ(Move(Square::s27(), Square::s26(), false), bookMoves.move(i));
+        ASSERT_EQ(1, bookMoves.count(i));
+      }
+    }
+
+    bookMoves = binaryBook.get(pos2);
+    ASSERT_EQ(1, (int)bookMoves.size());
+    ASSERT_EQ(Move(Square::s39(), Square::s48(), false), bookMoves.move(0));
+    ASSERT_EQ(7, bookMoves.count(0));
+
+    bookMoves = binaryBook.get(pos3);
+    ASSERT_EQ(0, (int)bookMoves.size());
+  }
+
+  std::remove(TestBookPath);
+}
@@ -0,0 +1,85 @@
+/* Lz77Test.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "test/Test.hpp"
+#include "common/compression/Lz77.hpp"
+#include "common/math/Random.hpp"
+
+using namespace sunfish;
+
+namespace {
+
+void testRoundTrip(const std::vector<uint8_t>& src) {
+  std::vector<uint8_t> compressed;
+  Lz77::compress(src.data(), src.size(), compressed);
+
+  std::vector<uint8_t> decompressed;
+  ASSERT_TRUE(Lz77::decompress(compressed.data(),
+                               compressed.size(),
+                               decompressed,
+                               src.size()));
+  ASSERT_TRUE(src == decompressed);
+}
+
+} // namespace
+
+TEST(Lz77Test, testRoundTrip) {
+  // empty
+  testRoundTrip({});
+
+  // short literals
+  testRoundTrip({ 1, 2, 3 });
+
+  // long runs and repetitions
+  {
+    std::vector<uint8_t> src;
+    for (int i = 0; i < 100000; i++) {
+      src.push_back(static_cast<uint8_t>((i / 300) % 7));
+    }
+    testRoundTrip(src);
+
+    std::vector<uint8_t> compressed;
+    Lz77::compress(src.data(), src.size(), compressed);
+    ASSERT_TRUE(compressed.size() < src.size() / 10);
+  }
+
+  // random data which is hardly compressed
+  {
+    Random random(1);
+    std::vector<uint8_t> src;
+    for (int i = 0; i < 100000; i++) {
+      src.push_back(static_cast<uint8_t>(random.int32()));
+    }
+    testRoundTrip(src);
+  }
+}
+
+TEST(Lz77Test, testBrokenData) {
+  std::vector<uint8_t> src;
+  for (int i = 0; i < 10000; i++) {
+    src.push_back(static_cast<uint8_t>(i % 13));
+  }
+
+  std::vector<uint8_t> compressed;
+  Lz77::compress(src.data(), src.size(), compressed);
+
+  std::vector<uint8_t> decompressed;
+
+  // wrong size
+  ASSERT_FALSE(Lz77::decompress(compressed.data(),
+                                compressed.size(),
+                                decompressed,
+                                src.size() - 1));
+  ASSERT_FALSE(Lz77::decompress(compressed.data(),
+                                compressed.size(),
+                                decompressed,
+                                src.size() + 1));
+
+  // truncated
+  ASSERT_FALSE(Lz77::decompress(compressed.data(),
+                                compressed.size() / 2,
+                                decompressed,
+                                src.size()));
+}
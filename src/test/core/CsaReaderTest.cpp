@@ -5,6 +5,8 @@
 
 #include "test/Test.hpp"
 #include "core/record/CsaReader.hpp"
+#include <sstream>
+#include <vector>
 
 using namespace sunfish;
 
@@ -121,6 +123,145 @@ TEST(CsaReaderTest, testRead) {
   }
 }
 
+TEST(CsaReaderTest, testReadBuffer) {
+  std::string src =
+    "V2.2\r\n"
+    "N+Sunfish\r\n"
+    "N-Firefly\r\n"
+    "P1-KY-KE-GI-KI-OU-KI-GI-KE-KY\r\n"
+    "P2 * -HI *  *  *  *  * -KA * \r\n"
+    "P3-FU-FU-FU-FU-FU-FU-FU-FU-FU\r\n"
+    "P4 *  *  *  *  *  *  *  *  * \r\n"
+    "P5 *  *  *  *  *  *  *  *  * \r\n"
+    "P6 *  *  *  *  *  *  *  *  * \r\n"
+    "P7+FU+FU+FU+FU+FU+FU+FU+FU+FU\r\n"
+    "P8 * +KA *  *  *  *  * +HI * \r\n"
+    "P9+KY+KE+GI+KI+OU+KI+GI+KE+KY\r\n"
+    "+\r\n"
+    "+7776FU,T1\r\n"
+    "'comment, with a comma\r\n"
+    "-3334FU,T2\r\n"
+    "%TORYO\r\n"
+    "/\r\n"
+    "P1-KY-KE-GI-KI-OU-KI-GI-KE-KY\n"
+    "P2 * -HI *  *  *  *  * -KA * \n"
+    "P3-FU-FU-FU-FU-FU-FU-FU-FU-FU\n"
+    "P4 *  *  *  *  *  *  *  *  * \n"
+    "P5 *  *  *  *  *  *  *  *  * \n"
+    "P6 *  *  *  *  *  *  *  *  * \n"
+    "P7+FU+FU+FU+FU+FU+FU+FU+FU+FU\n"
+    "P8 * +KA *  *  *  *  * +HI * \n"
+    "P9+KY+KE+GI+KI+OU+KI+GI+KE+KY\n"
+    "-\n"
+    "-3334FU\n"
+    "+7776FU\n"
+    "/\n";
+  const char* p = src.c_str();
+  const char* end = p + src.size();
+
+  {
+    Record record;
+    RecordInfo ri;
+    ASSERT_TRUE(CsaReader::read(p, end, record, &ri, &p));
+    ASSERT_EQ("Sunfish", ri.blackName);
+    ASSERT_EQ("Firefly", ri.whiteName);
+    ASSERT_EQ(Position(Position::Handicap::Even).toString(), record.initialPosition.toString());
+    ASSERT_EQ(2, record.moveList.size());
+    ASSERT_EQ(Move(Square::s77(), Square::s76(), false), record.moveList[0]);
+    ASSERT_EQ(Move(Square::s33(), Square::s34(), false), record.moveList[1]);
+    ASSERT_EQ("%TORYO", record.specialMove);
+  }
+
+  {
+    Record record;
+    ASSERT_TRUE(CsaReader::read(p, end, record, nullptr, &p));
+    ASSERT_EQ(Turn::White, record.initialPosition.getTurn());
+    ASSERT_EQ(2, record.moveList.size());
+    ASSERT_EQ(Move(Square::s33(), Square::s34(), false), record.moveList[0]);
+    ASSERT_EQ(Move(Square::s77(), Square::s76(), false), record.moveList[1]);
+    ASSERT_EQ("", record.specialMove);
+  }
+
+  {
+    Record record;
+    ASSERT_FALSE(CsaReader::read(p, end, record, nullptr, &p));
+    ASSERT_EQ(end, p);
+  }
+}
+
+TEST(CsaReaderTest, testReadMultiGameStream) {
+  std::istringstream iss(
+    "P1-KY-KE-GI-KI-OU-KI-GI-KE-KY\n"
+    "P2 * -HI *  *  *  *  * -KA * \n"
+    "P3-FU-FU-FU-FU-FU-FU-FU-FU-FU\n"
+    "P4 *  *  *  *  *  *  *  *  * \n"
+    "P5 *  *  *  *  *  *  *  *  * \n"
+    "P6 *  *  *  *  *  *  *  *  * \n"
+    "P7+FU+FU+FU+FU+FU+FU+FU+FU+FU\n"
+    "P8 * +KA *  *  *  *  * +HI * \n"
+    "P9+KY+KE+GI+KI+OU+KI+GI+KE+KY\n"
+    "+\n"
+    "+7776FU\n"
+    "%TORYO\n"
+    "/\n"
+    "P1-KY-KE-GI-KI-OU-KI-GI-KE-KY\n"
+    "P2 * -HI *  *  *  *  * -KA * \n"
+    "P3-FU-FU-FU-FU-FU-FU-FU-FU-FU\n"
+    "P4 *  *  *  *  *  *  *  *  * \n"
+    "P5 *  *  *  *  *  *  *  *  * \n"
+    "P6 *  *  *  *  *  *  *  *  * \n"
+    "P7+FU+FU+FU+FU+FU+FU+FU+FU+FU\n"
+    "P8 * +KA *  *  *  *  * +HI * \n"
+    "P9+KY+KE+GI+KI+OU+KI+GI+KE+KY\n"
+    "-\n"
+    "-3334FU\n"
+    "+7776FU\n"
+    "/\n");
+
+  {
+    Record record;
+    ASSERT_TRUE(CsaReader::read(iss, record));
+    ASSERT_EQ(1, record.moveList.size());
+    ASSERT_EQ("%TORYO", record.specialMove);
+  }
+
+  {
+    Record record;
+    ASSERT_TRUE(CsaReader::read(iss, record));
+    ASSERT_EQ(Turn::White, record.initialPosition.getTurn());
+    ASSERT_EQ(2, record.moveList.size());
+  }
+
+  {
+    Record record;
+    ASSERT_FALSE(CsaReader::read(iss, record));
+  }
+}
+
+TEST(CsaReaderTest, testReadBufferTrailingComma) {
+  // the buffer ends just after a comma without a line feed.
+  std::string src =
+    "P1-KY-KE-GI-KI-OU-KI-GI-KE-KY\n"
+    "P2 * -HI *  *  *  *  * -KA * \n"
+    "P3-FU-FU-FU-FU-FU-FU-FU-FU-FU\n"
+    "P4 *  *  *  *  *  *  *  *  * \n"
+    "P5 *  *  *  *  *  *  *  *  * \n"
+    "P6 *  *  *  *  *  *  *  *  * \n"
+    "P7+FU+FU+FU+FU+FU+FU+FU+FU+FU\n"
+    "P8 * +KA *  *  *  *  * +HI * \n"
+    "P9+KY+KE+GI+KI+OU+KI+GI+KE+KY\n"
+    "+\n"
+    "+7776FU,";
+  std::vector<char> buffer(src.begin(), src.end());
+  const char* p = buffer.data();
+  const char* end = p + buffer.size();
+
+  Record record;
+  ASSERT_TRUE(CsaReader::read(p, end, record, nullptr, &p));
+  ASSERT_EQ(1, record.moveList.size());
+  ASSERT_EQ(end, p);
+}
+
 TEST(CsaReaderTest, testReadPosition) {
   {
     std::string src =
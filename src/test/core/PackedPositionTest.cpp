@@ -0,0 +1,47 @@
+/* PackedPositionTest.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "test/Test.hpp"
+#include "core/position/PackedPosition.hpp"
+#include "core/record/SfenParser.hpp"
+
+using namespace sunfish;
+
+namespace {
+
+void testPackAndUnpack(const char* sfen) {
+  Position pos;
+  ASSERT_EQ(true, SfenParser::parsePosition(sfen, pos));
+
+  auto packed = packPosition(pos.getMutablePosition());
+
+  MutablePosition mp;
+  ASSERT_EQ(true, unpackPosition(packed, mp));
+
+  Position pos2(mp);
+  ASSERT_EQ(pos.toString(), pos2.toString());
+  ASSERT_EQ(pos.getHash(), pos2.getHash());
+}
+
+} // namespace
+
+TEST(PackedPositionTest, testPackAndUnpack) {
+  testPackAndUnpack("lnsgkgsnl/1r5b1/ppppppppp/9/9/9/PPPPPPPPP/1B5R1/LNSGKGSNL b - 1");
+  testPackAndUnpack("lnsgkgsn1/1r5b1/ppppppppp/9/9/9/PPPPPPPPP/1B5R1/LNSGKGSNL w - 1");
+  testPackAndUnpack("4k4/6+B2/9/9/9/3+p5/9/9/4K4 b P2G15p3n 1");
+  testPackAndUnpack("4k4/9/9/9/9/9/9/9/4K4 w 2R2B4G4S4N4L18P 1");
+  testPackAndUnpack("4k4/9/9/9/9/9/9/9/4K4 b 2r2b4g4s4n4l18p 1");
+  testPackAndUnpack("+l+n+sgk+s+n+l1/9/+p+p+p4+p+p/9/9/9/+P+P7/1+B5+R1/L1SGKGSNL b RBPPPPP 1");
+}
+
+TEST(PackedPositionTest, testBrokenData) {
+  PackedPosition packed;
+  for (unsigned i = 0; i < PackedPosition::Size; i++) {
+    packed.data[i] = 0xff;
+  }
+
+  MutablePosition mp;
+  ASSERT_EQ(false, unpackPosition(packed, mp));
+}
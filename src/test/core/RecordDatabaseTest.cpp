@@ -0,0 +1,128 @@
+/* RecordDatabaseTest.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "test/Test.hpp"
+#include "core/record/RecordDatabase.hpp"
+#include "core/record/RecordReader.hpp"
+#include "core/util/PositionUtil.hpp"
+#include <fstream>
+#include <cstdio>
+
+using namespace sunfish;
+
+namespace {
+
+const char* const TestDatabasePath = "test_records.db";
+const char* const TestCsaPath = "test_record.csa";
+
+} // namespace
+
+TEST(RecordDatabaseTest, test) {
+  Record record1;
+  record1.initialPosition.initialize(Position::Handicap::Even);
+  record1.moveList.push_back(Move(Square::s77(), Square::s76(), false));
+  record1.moveList.push_back(Move(Square::s33(), Square::s34(), false));
+  record1.moveList.push_back(Move(Square::s88(), Square::s22(), true));
+  record1.specialMove = "%TORYO";
+
+  Record record2;
+  record2.initialPosition = PositionUtil::createPositionFromCsaString(
+    "P1 *  *  *  * -OU *  *  *  * \n"
+    "P2 *  *  *  *  *  *  *  *  * \n"
+    "P3 *  *  *  * +FU *  *  *  * \n"
+    "P4 *  *  *  *  *  *  *  *  * \n"
+    "P5 *  *  *  *  *  *  *  *  * \n"
+    "P6 *  *  *  *  *  *  *  *  * \n"
+    "P7 *  *  *  *  *  *  *  *  * \n"
+    "P8 *  *  *  *  *  *  *  *  * \n"
+    "P9 *  *  *  * +OU *  *  *  * \n"
+    "P+00KI\n"
+    "P-\n"
+    "+\n");
+  record2.moveList.push_back(Move(PieceType::gold(), Square::s52()));
+
+  {
+    RecordDatabaseWriter writer;
+    ASSERT_TRUE(writer.open(TestDatabasePath));
+    ASSERT_TRUE(writer.write(record1));
+    ASSERT_TRUE(writer.write(record2));
+    ASSERT_TRUE(writer.close());
+    ASSERT_EQ(2, (int)writer.getNumberOfRecords());
+  }
+
+  {
+    RecordReader reader;
+    ASSERT_TRUE(reader.open(TestDatabasePath));
+    ASSERT_TRUE(reader.isDatabase());
+    ASSERT_EQ(2, (int)reader.size());
+
+    Record record;
+    ASSERT_TRUE(reader.read(1, record));
+    ASSERT_EQ(record2.initialPosition.toString(), record.initialPosition.toString());
+    ASSERT_EQ(1, (int)record.moveList.size());
+    ASSERT_EQ(record2.moveList[0], record.moveList[0]);
+    ASSERT_EQ("", record.specialMove);
+
+    ASSERT_TRUE(reader.next(record));
+    ASSERT_TRUE(PositionUtil::isEvenInitialPosition(record.initialPosition));
+    ASSERT_EQ(3, (int)record.moveList.size());
+    ASSERT_EQ(record1.moveList[0], record.moveList[0]);
+    ASSERT_EQ(record1.moveList[1], record.moveList[1]);
+    ASSERT_EQ(record1.moveList[2], record.moveList[2]);
+    ASSERT_EQ("%TORYO", record.specialMove);
+
+    ASSERT_TRUE(reader.next(record));
+    ASSERT_FALSE(reader.next(record));
+  }
+
+  std::remove(TestDatabasePath);
+}
+
+TEST(RecordDatabaseTest, testDirectory) {
+  RecordReader reader;
+  ASSERT_TRUE(reader.open("kifu/test/book_gen"));
+  ASSERT_FALSE(reader.isDatabase());
+  ASSERT_EQ(3, (int)reader.size());
+
+  int count = 0;
+  Record record;
+  while (reader.next(record)) {
+    ASSERT_TRUE(record.moveList.size() != 0);
+    count++;
+  }
+  ASSERT_EQ(3, count);
+}
+
+TEST(RecordDatabaseTest, testIncompleteFile) {
+  {
+    std::ofstream file(TestCsaPath);
+    file << "P1-KY-KE-GI-KI-OU-KI-GI-KE-KY\n"
+            "P2 * -HI *  *  *  *  * -KA * \n"
+            "P3-FU-FU-FU-FU-FU-FU-FU-FU-FU\n"
+            "P4 *  *  *  *  *  *  *  *  * \n"
+            "P5 *  *  *  *  *  *  *  *  * \n"
+            "P6 *  *  *  *  *  *  *  *  * \n"
+            "P7+FU+FU+FU+FU+FU+FU+FU+FU+FU\n"
+            "P8 * +KA *  *  *  *  * +HI * \n"
+            "P9+KY+KE+GI+KI+OU+KI+GI+KE+KY\n"
+            "P+\n"
+            "P-\n"
+            "+\n"
+            "+7776FU\n"
+            "-3334FU\n"
+            "+7776FU\n";
+  }
+
+  RecordReader reader;
+  ASSERT_TRUE(reader.open(TestCsaPath));
+  ASSERT_EQ(1, (int)reader.size());
+
+  Record record;
+  ASSERT_FALSE(reader.read(0, record));
+  ASSERT_EQ(2, (int)record.moveList.size());
+  ASSERT_FALSE(reader.next(record));
+
+  std::remove(TestCsaPath);
+}
@@ -0,0 +1,53 @@
+/* RecordLoaderTest.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "test/Test.hpp"
+#include "core/record/RecordLoader.hpp"
+#include "core/record/RecordReader.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace sunfish;
+
+TEST(RecordLoaderTest, test) {
+  std::vector<size_t> expect;
+  {
+    RecordReader reader;
+    ASSERT_TRUE(reader.open("kifu/test/book_gen"));
+    Record record;
+    while (reader.next(record)) {
+      expect.push_back(record.moveList.size());
+    }
+    std::sort(expect.begin(), expect.end());
+  }
+
+  for (int threads = 1; threads <= 3; threads++) {
+    RecordLoader loader;
+    loader.setNumberOfThreads(threads);
+    loader.setQueueSize(1);
+    ASSERT_TRUE(loader.start("kifu/test/book_gen"));
+    ASSERT_EQ(3, (int)loader.getNumberOfFiles());
+
+    std::vector<size_t> actual;
+    Record record;
+    while (loader.next(record)) {
+      actual.push_back(record.moveList.size());
+    }
+    std::sort(actual.begin(), actual.end());
+
+    ASSERT_TRUE(expect == actual);
+  }
+}
+
+TEST(RecordLoaderTest, testStop) {
+  RecordLoader loader;
+  loader.setQueueSize(1);
+  ASSERT_TRUE(loader.start("kifu/test/book_gen"));
+
+  Record record;
+  ASSERT_TRUE(loader.next(record));
+  loader.stop();
+  ASSERT_FALSE(loader.next(record));
+}
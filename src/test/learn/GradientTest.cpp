@@ -0,0 +1,80 @@
+/* GradientTest.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "test/Test.hpp"
+#include "learn/batch/Gradient.hpp"
+#include "search/eval/FeatureTemplates.hpp"
+#include "common/math/Random.hpp"
+#include <memory>
+#include <cstring>
+
+using namespace sunfish;
+
+TEST(GradientTest, testExpandRows) {
+  Random r;
+  auto og = std::unique_ptr<OptimizedGradient>(new OptimizedGradient);
+  auto g1 = std::unique_ptr<Gradient>(new Gradient);
+  auto g2 = std::unique_ptr<Gradient>(new Gradient);
+  auto block = std::unique_ptr<GradientBlock>(new GradientBlock);
+
+  each(*og, [&r](float& v) {
+    v = r.int16() % 8 == 0 ? static_cast<float>(r.int16() % 2001 - 1000) / 7.0f : 0.0f;
+  });
+
+  expand(*g1, *og);
+
+  memset(reinterpret_cast<void*>(g2.get()), 0, sizeof(Gradient));
+  SQUARE_EACH(king) {
+#define COPY_GRADIENT_ROW(name) \
+    memcpy(&block->name, &og->name[king.raw()], sizeof(block->name));
+    GRADIENT_BLOCK_EACH(COPY_GRADIENT_ROW)
+#undef COPY_GRADIENT_ROW
+    expandRows(*g2, king, *block, [](float& e, float val) {
+      e += val;
+    });
+  }
+
+  ASSERT_EQ(0, memcmp(g1.get(), g2.get(), sizeof(Gradient)));
+}
+
+TEST(GradientTest, testSymmetricIndex) {
+  using IndexType = FeatureVector<uint32_t>;
+  CONSTEXPR_CONST size_t Size = sizeof(Gradient) / sizeof(float);
+
+  Random r;
+  auto index = std::unique_ptr<IndexType>(new IndexType);
+  auto g1 = std::unique_ptr<Gradient>(new Gradient);
+  auto g2 = std::unique_ptr<Gradient>(new Gradient);
+
+  auto pi = reinterpret_cast<uint32_t*>(index.get());
+  for (size_t i = 0; i < Size; i++) {
+    pi[i] = static_cast<uint32_t>(i);
+  }
+  symmetrize(*index, [](uint32_t& e1, uint32_t& e2) {
+    std::swap(e1, e2);
+  });
+
+  each(*g1, [&r](float& v) {
+    v = static_cast<float>(r.int16() % 2001 - 1000) / 7.0f;
+  });
+  memcpy(g2.get(), g1.get(), sizeof(Gradient));
+  symmetrize(*g2, [](float& e1, float& e2) {
+    e1 = e2 = e1 + e2;
+  });
+
+  // each element is paired with at most one element,
+  // and receives the gradient of the pair.
+  auto p1 = reinterpret_cast<const float*>(g1.get());
+  auto p2 = reinterpret_cast<const float*>(g2.get());
+  size_t errors = 0;
+  for (size_t i = 0; i < Size; i++) {
+    uint32_t s = pi[i];
+    float expected = s == i ? p1[i] : p1[i] + p1[s];
+    if (pi[s] != i || p2[i] != expected) {
+      errors++;
+    }
+  }
+  ASSERT_EQ(0, errors);
+}
@@ -0,0 +1,140 @@
+/* TrainingDataTest.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "test/Test.hpp"
+#include "learn/batch/TrainingData.hpp"
+#include "core/move/Move.hpp"
+#include <fstream>
+#include <cstdio>
+
+using namespace sunfish;
+
+namespace {
+
+const char* TrainingDataPath = "training_data_test.bin";
+
+/**
+ * Enough records to span several blocks.
+ */
+CONSTEXPR_CONST unsigned NumberOfRecords = 20000;
+
+std::vector<std::vector<Move>> createPVs(unsigned index) {
+  std::vector<std::vector<Move>> pvs(index % 3 + 1);
+  for (auto& pv : pvs) {
+    pv.push_back(Move(Square::s77(), Square::s76(), false));
+    pv.push_back(Move(Square::s33(), Square::s34(), false));
+    if (index % 2 == 0) {
+      pv.push_back(Move(Square::s88(), Square::s22(), true));
+    }
+  }
+  return pvs;
+}
+
+void writeTrainingData(bool compress) {
+  TrainingDataWriter writer;
+  ASSERT_TRUE(writer.open(TrainingDataPath, compress));
+
+  Position pos(Position::Handicap::Even);
+  for (unsigned i = 0; i < NumberOfRecords; i++) {
+    ASSERT_TRUE(writer.write(pos, createPVs(i)));
+  }
+
+  ASSERT_TRUE(writer.close());
+}
+
+void testRoundTrip(bool compress) {
+  writeTrainingData(compress);
+
+  TrainingDataReader reader;
+  ASSERT_TRUE(reader.open(TrainingDataPath));
+  ASSERT_TRUE(reader.getBlocks().size() > 1);
+
+  Position pos(Position::Handicap::Even);
+  MutablePosition mp;
+  std::vector<std::vector<Move>> pvs;
+  unsigned count = 0;
+  while (reader.read(mp, pvs)) {
+    ASSERT_EQ(pos.toString(), Position(mp).toString());
+
+    auto expected = createPVs(count);
+    ASSERT_EQ(expected.size(), pvs.size());
+    for (unsigned i = 0; i < pvs.size(); i++) {
+      ASSERT_EQ(expected[i].size(), pvs[i].size());
+      for (unsigned j = 0; j < pvs[i].size(); j++) {
+        ASSERT_EQ(expected[i][j].serialize16(), pvs[i][j].serialize16());
+      }
+    }
+    count++;
+  }
+
+  ASSERT_FALSE(reader.isError());
+  ASSERT_EQ(NumberOfRecords, count);
+
+  remove(TrainingDataPath);
+}
+
+} // namespace
+
+TEST(TrainingDataTest, testRoundTrip) {
+  testRoundTrip(false);
+  testRoundTrip(true);
+}
+
+TEST(TrainingDataTest, testBlockRange) {
+  writeTrainingData(true);
+
+  TrainingDataReader reader;
+  ASSERT_TRUE(reader.open(TrainingDataPath));
+  const auto& blocks = reader.getBlocks();
+  ASSERT_TRUE(blocks.size() > 2);
+
+  reader.setBlockRange(1, 2);
+
+  MutablePosition mp;
+  std::vector<std::vector<Move>> pvs;
+  unsigned count = 0;
+  while (reader.read(mp, pvs)) {
+    count++;
+  }
+
+  ASSERT_FALSE(reader.isError());
+  ASSERT_EQ(blocks[1].numberOfRecords, count);
+
+  remove(TrainingDataPath);
+}
+
+TEST(TrainingDataTest, testBrokenBlock) {
+  writeTrainingData(true);
+
+  uint64_t offset;
+  {
+    TrainingDataReader reader;
+    ASSERT_TRUE(reader.open(TrainingDataPath));
+    offset = reader.getBlocks()[1].offset;
+  }
+
+  // break the stored size of the second block.
+  {
+    std::fstream file(TrainingDataPath, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offset);
+    uint32_t storedSize = 0xffffffff;
+    file.write(reinterpret_cast<const char*>(&storedSize), sizeof(storedSize));
+  }
+
+  TrainingDataReader reader;
+  ASSERT_TRUE(reader.open(TrainingDataPath));
+
+  MutablePosition mp;
+  std::vector<std::vector<Move>> pvs;
+  unsigned count = 0;
+  while (reader.read(mp, pvs)) {
+    count++;
+  }
+
+  ASSERT_TRUE(reader.isError());
+  ASSERT_EQ(reader.getBlocks()[0].numberOfRecords, count);
+
+  remove(TrainingDataPath);
+}
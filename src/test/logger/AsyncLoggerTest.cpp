@@ -0,0 +1,95 @@
+/* AsyncLoggerTest.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "test/Test.hpp"
+#include "common/Def.hpp"
+#include "logger/Logger.hpp"
+#include <thread>
+#include <vector>
+#include <sstream>
+
+using namespace sunfish;
+
+namespace {
+
+CONSTEXPR_CONST int NumberOfThreads = 4;
+CONSTEXPR_CONST int NumberOfLines = 100;
+
+int countLines(const std::string& str) {
+  std::istringstream iss(str);
+  std::string line;
+  int count = 0;
+  while (std::getline(iss, line)) {
+    count++;
+  }
+  return count;
+}
+
+} // namespace
+
+TEST(AsyncLoggerTest, testBlock) {
+  std::ostringstream oss;
+  Logger logger("[TEST] ");
+  logger.addStream(oss, false, true);
+
+  AsyncLogger::start(AsyncLogger::OverflowPolicy::Block, 16);
+  ASSERT_TRUE(AsyncLogger::isRunning());
+
+  std::vector<std::thread> threads;
+  for (int ti = 0; ti < NumberOfThreads; ti++) {
+    threads.emplace_back([&logger, ti]() {
+      for (int i = 0; i < NumberOfLines; i++) {
+        logger << ti << ' ' << i;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  AsyncLogger::stop();
+  ASSERT_FALSE(AsyncLogger::isRunning());
+
+  // the lines of each thread keep their order.
+  std::istringstream iss(oss.str());
+  std::string name;
+  int ti;
+  int i;
+  int next[NumberOfThreads] = { 0 };
+  int count = 0;
+  while (iss >> name >> ti >> i) {
+    ASSERT_EQ("[TEST]", name);
+    ASSERT_EQ(next[ti], i);
+    next[ti]++;
+    count++;
+  }
+  ASSERT_EQ(NumberOfThreads * NumberOfLines, count);
+
+  // synchronous after stop
+  logger << "sync";
+  ASSERT_EQ(NumberOfThreads * NumberOfLines + 1, countLines(oss.str()));
+}
+
+TEST(AsyncLoggerTest, testDrop) {
+  std::ostringstream oss;
+  Logger logger;
+  logger.addStream(oss);
+
+  auto dropped0 = AsyncLogger::getNumberOfDroppedLines();
+
+  AsyncLogger::start(AsyncLogger::OverflowPolicy::Drop, 4);
+
+  std::thread thread([&logger]() {
+    for (int i = 0; i < NumberOfLines; i++) {
+      logger << i;
+    }
+  });
+  thread.join();
+
+  AsyncLogger::stop();
+
+  auto dropped = AsyncLogger::getNumberOfDroppedLines() - dropped0;
+  ASSERT_EQ(NumberOfLines, countLines(oss.str()) + (int)dropped);
+}
@@ -7,10 +7,13 @@
 #include "search/eval/Evaluator.hpp"
 #include "search/eval/Material.hpp"
 #include "search/eval/FeatureTemplates.hpp"
+#include "search/RandomSearcher.hpp"
 #include "core/position/Position.hpp"
 #include "core/util/PositionUtil.hpp"
 #include "common/math/Random.hpp"
+#include <vector>
 #include <memory>
+#include <cstring>
 
 using namespace sunfish;
 
@@ -611,3 +614,95 @@ TEST(EvaluatorTest, testDataSourceType) {
   oss << static_cast<Evaluator::DataSourceType>(123);
   ASSERT_EQ("123", oss.str());
 }
+
+TEST(EvaluatorTest, testGeneration) {
+  auto eval = std::make_shared<Evaluator>(Evaluator::InitType::Zero);
+  uint32_t generation = eval->generation();
+
+  eval->onChanged(Evaluator::DataSourceType::Custom);
+  ASSERT_EQ(generation + 1, eval->generation());
+}
+
+TEST(EvaluatorTest, testEvaluateBatch) {
+  RandomSearcher searcher;
+  std::vector<Position> positions;
+  Position pos = PositionUtil::createPositionFromCsaString(
+    "P1-KY-KE-GI-KI-OU-KI-GI-KE-KY\n"
+    "P2 * -HI *  *  *  *  * -KA * \n"
+    "P3-FU-FU-FU-FU-FU-FU-FU-FU-FU\n"
+    "P4 *  *  *  *  *  *  *  *  * \n"
+    "P5 *  *  *  *  *  *  *  *  * \n"
+    "P6 *  *  *  *  *  *  *  *  * \n"
+    "P7+FU+FU+FU+FU+FU+FU+FU+FU+FU\n"
+    "P8 * +KA *  *  *  *  * +HI * \n"
+    "P9+KY+KE+GI+KI+OU+KI+GI+KE+KY\n"
+    "P+\n"
+    "P-\n"
+    "+\n");
+  positions.push_back(pos);
+  for (int i = 0; i < 1000; i++) {
+    Move move;
+    if (!searcher.search(pos, move)) {
+      break;
+    }
+    Piece captured;
+    pos.doMove(move, captured);
+    positions.push_back(pos);
+  }
+
+  std::vector<Score> scores;
+  g_eval.evaluateBatch(positions, scores);
+  ASSERT_EQ(positions.size(), scores.size());
+  for (unsigned i = 0; i < positions.size(); i++) {
+    auto materialScore = g_eval.calculateMaterialScore(positions[i]);
+    auto score = g_eval.calculateTotalScore(materialScore,
+                                            positions[i]);
+    ASSERT_EQ(score, scores[i]);
+  }
+
+  std::vector<Score> scores2;
+  g_eval.evaluateBatch(positions, scores2, 4);
+  ASSERT_EQ(scores.size(), scores2.size());
+  for (unsigned i = 0; i < scores.size(); i++) {
+    ASSERT_EQ(scores[i], scores2[i]);
+  }
+}
+
+TEST(EvaluatorTest, testPartitionedTemplates) {
+  using FV = FeatureVector<float>;
+  using OFV = OptimizedFeatureVector<float>;
+  CONSTEXPR_CONST int Parts = 3;
+
+  Random r;
+  auto fv1 = std::unique_ptr<FV>(new FV);
+  auto fv2 = std::unique_ptr<FV>(new FV);
+  auto ofv1 = std::unique_ptr<OFV>(new OFV);
+  auto ofv2 = std::unique_ptr<OFV>(new OFV);
+
+  each(*fv1, [&r](float& v) {
+    v = static_cast<float>(r.int16() % 2001 - 1000) / 7.0f;
+  });
+  memcpy(fv2.get(), fv1.get(), sizeof(FV));
+
+  optimize(*fv1, *ofv1);
+  for (int part = 0; part < Parts; part++) {
+    optimize(*fv2, *ofv2, part, Parts);
+  }
+  ASSERT_EQ(0, memcmp(ofv1.get(), ofv2.get(), sizeof(OFV)));
+
+  expand(*fv1, *ofv1);
+  for (int part = 0; part < Parts; part++) {
+    expand(*fv2, *ofv2, part, Parts);
+  }
+  ASSERT_EQ(0, memcmp(fv1.get(), fv2.get(), sizeof(FV)));
+
+  symmetrize(*fv1, [](float& e1, float& e2) {
+    e1 = e2 = e1 + e2;
+  });
+  for (int part = 0; part < Parts; part++) {
+    symmetrize(*fv2, [](float& e1, float& e2) {
+      e1 = e2 = e1 + e2;
+    }, part, Parts);
+  }
+  ASSERT_EQ(0, memcmp(fv1.get(), fv2.get(), sizeof(FV)));
+}
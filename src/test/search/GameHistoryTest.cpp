@@ -0,0 +1,95 @@
+/* GameHistoryTest.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "test/Test.hpp"
+#include "core/record/Record.hpp"
+#include "core/util/PositionUtil.hpp"
+#include "search/shek/GameHistory.hpp"
+
+using namespace sunfish;
+
+namespace {
+
+void addRepetition(Record& record) {
+  record.moveList.push_back(Move(Square::s59(), Square::s58(), false));
+  record.moveList.push_back(Move(Square::s51(), Square::s52(), false));
+  record.moveList.push_back(Move(Square::s58(), Square::s59(), false));
+  record.moveList.push_back(Move(Square::s52(), Square::s51(), false));
+}
+
+} // namespace
+
+TEST(GameHistoryTest, test) {
+  Record record;
+  record.initialPosition.initialize(Position::Handicap::Even);
+  addRepetition(record);
+  addRepetition(record);
+
+  Position pos = record.initialPosition;
+  ShekTable path(ShekTable::PathWidth);
+  GameHistory history;
+
+  {
+    ASSERT_TRUE(history.update(record));
+    ASSERT_EQ(8, history.size());
+    ASSERT_EQ(pos.getHash(), history.getEntryFromLast(3).hash);
+    ASSERT_EQ(pos.getHash(), history.getEntryFromLast(7).hash);
+    ASSERT_EQ(ShekState::Equal, path.check(pos, history.getShekTable()));
+
+    path.retain(pos);
+    ASSERT_EQ(ShekState::Equal4, path.check(pos, history.getShekTable()));
+    path.release(pos);
+  }
+
+  {
+    // take back
+    record.moveList.resize(4);
+    ASSERT_TRUE(history.update(record));
+    ASSERT_EQ(4, history.size());
+    ASSERT_EQ(ShekState::Equal, path.check(pos, history.getShekTable()));
+
+    path.retain(pos);
+    ASSERT_EQ(ShekState::Equal, path.check(pos, history.getShekTable()));
+    path.release(pos);
+  }
+
+  {
+    addRepetition(record);
+    ASSERT_TRUE(history.update(record));
+    ASSERT_EQ(8, history.size());
+
+    path.retain(pos);
+    ASSERT_EQ(ShekState::Equal4, path.check(pos, history.getShekTable()));
+    path.release(pos);
+  }
+
+  {
+    // another game
+    Record record2;
+    record2.initialPosition = PositionUtil::createPositionFromCsaString(
+      "P1 *  *  *  * -OU *  *  *  * \n"
+      "P2 *  *  *  *  *  *  *  *  * \n"
+      "P3 *  *  *  *  *  *  *  *  * \n"
+      "P4 *  *  *  *  *  *  *  *  * \n"
+      "P5 *  *  *  *  *  *  *  *  * \n"
+      "P6 *  *  *  *  *  *  *  *  * \n"
+      "P7 *  *  *  *  *  *  *  *  * \n"
+      "P8 *  *  *  *  *  *  *  *  * \n"
+      "P9 *  *  *  * +OU *  *  *  * \n"
+      "P+\n"
+      "P-\n"
+      "+\n");
+    ASSERT_TRUE(history.update(record2));
+    ASSERT_EQ(0, history.size());
+    ASSERT_EQ(ShekState::None, path.check(pos, history.getShekTable()));
+  }
+
+  {
+    history.update(record);
+    history.clear();
+    ASSERT_EQ(0, history.size());
+    ASSERT_EQ(ShekState::None, path.check(pos, history.getShekTable()));
+  }
+}
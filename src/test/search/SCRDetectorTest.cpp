@@ -7,6 +7,8 @@
 #include "core/util/PositionUtil.hpp"
 #include "search/tree/Tree.hpp"
 #include "search/shek/SCRDetector.hpp"
+#include "search/shek/GameHistory.hpp"
+#include "core/record/Record.hpp"
 
 using namespace sunfish;
 
@@ -220,8 +222,11 @@ TEST(SCRDetectorTest, testBlack) {
     record.moveList.push_back(Move(Square::s62(), Square::s51(), false));
     record.moveList.push_back(Move(Square::s68(), Square::s59(), false));
 
+    GameHistory history;
+    history.update(record);
+
     SCRDetector scr;
-    scr.registerRecord(record);
+    scr.setHistory(history);
 
     Tree tree;
     tree.position = PositionUtil::createPositionFromCsaString(PosStrBlackNoCheck);
@@ -246,8 +251,11 @@ TEST(SCRDetectorTest, testBlack) {
     record.moveList.push_back(Move(Square::s62(), Square::s51(), false));
     record.moveList.push_back(Move(Square::s44(), Square::s33(), false));
 
+    GameHistory history;
+    history.update(record);
+
     SCRDetector scr;
-    scr.registerRecord(record);
+    scr.setHistory(history);
 
     Tree tree;
     tree.position = PositionUtil::createPositionFromCsaString(PosStrBlackCheck);
@@ -272,8 +280,11 @@ TEST(SCRDetectorTest, testBlack) {
     record.moveList.push_back(Move(Square::s77(), Square::s66(), false));
     record.moveList.push_back(Move(Square::s48(), Square::s59(), false));
 
+    GameHistory history;
+    history.update(record);
+
     SCRDetector scr;
-    scr.registerRecord(record);
+    scr.setHistory(history);
 
     Tree tree;
     tree.position = PositionUtil::createPositionFromCsaString(PosStrBlackCheck2);
@@ -409,8 +420,11 @@ TEST(SCRDetectorTest, testWhite) {
     record.moveList.push_back(Move(Square::s48(), Square::s59(), false));
     record.moveList.push_back(Move(Square::s66(), Square::s77(), false));
 
+    GameHistory history;
+    history.update(record);
+
     SCRDetector scr;
-    scr.registerRecord(record);
+    scr.setHistory(history);
 
     Tree tree;
     tree.position = PositionUtil::createPositionFromCsaString(PosStrWhiteCheck);
@@ -435,8 +449,11 @@ TEST(SCRDetectorTest, testWhite) {
     record.moveList.push_back(Move(Square::s33(), Square::s44(), false));
     record.moveList.push_back(Move(Square::s62(), Square::s51(), false));
 
+    GameHistory history;
+    history.update(record);
+
     SCRDetector scr;
-    scr.registerRecord(record);
+    scr.setHistory(history);
 
     Tree tree;
     tree.position = PositionUtil::createPositionFromCsaString(PosStrWhiteCheck2);
@@ -0,0 +1,66 @@
+/* SearchTraceTest.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "test/Test.hpp"
+#include "search/trace/SearchTrace.hpp"
+
+using namespace sunfish;
+
+TEST(SearchTraceTest, testDisabled) {
+  SearchTraceBuffer buffer;
+  buffer.initialize(0, 1);
+
+  ASSERT_FALSE(buffer.isEnabled());
+}
+
+TEST(SearchTraceTest, testSampling) {
+  SearchTraceBuffer buffer;
+  buffer.initialize(100, 2);
+  buffer.setIteration(3);
+
+  ASSERT_TRUE(buffer.isEnabled());
+
+  // the 1st subtree is recorded
+  buffer.record(SearchTrace::Enter, 1, 0x1234, 8, -100, 100, 0);
+  buffer.record(SearchTrace::Enter, 2, 0x1234, 4, -100, 100, 0);
+  buffer.record(SearchTrace::Exit, 2, 0x1234, 4, -100, 100, 50);
+  buffer.record(SearchTrace::Exit, 1, 0x1234, 8, -100, 100, -50);
+
+  // the 2nd subtree is skipped
+  buffer.record(SearchTrace::Enter, 1, 0x5678, 8, -100, 100, 0);
+  buffer.record(SearchTrace::TTHit, 1, 0x5678, 8, -100, 100, 10);
+  buffer.record(SearchTrace::Exit, 1, 0x5678, 8, -100, 100, 10);
+
+  // the 3rd subtree is recorded
+  buffer.record(SearchTrace::Enter, 1, 0x9abc, 8, -100, 100, 0);
+
+  const auto& events = buffer.getEvents();
+  ASSERT_EQ(5, events.size());
+  ASSERT_EQ(SearchTrace::Enter, events[0].type);
+  ASSERT_EQ(1, events[0].ply);
+  ASSERT_EQ(0x1234, events[0].rootMove);
+  ASSERT_EQ(3, events[0].iteration);
+  ASSERT_EQ(SearchTrace::Exit, events[2].type);
+  ASSERT_EQ(50, events[2].score);
+  ASSERT_EQ(0x9abc, events[4].rootMove);
+  ASSERT_EQ(0, buffer.getDropped());
+}
+
+TEST(SearchTraceTest, testCapacity) {
+  SearchTraceBuffer buffer;
+  buffer.initialize(3, 1);
+
+  for (int i = 0; i < 5; i++) {
+    buffer.record(SearchTrace::Enter, 1, 0, 8, -100, 100, 0);
+  }
+
+  ASSERT_EQ(3, buffer.getEvents().size());
+  ASSERT_EQ(2, buffer.getDropped());
+
+  buffer.initialize(3, 1);
+
+  ASSERT_EQ(0, buffer.getEvents().size());
+  ASSERT_EQ(0, buffer.getDropped());
+}
@@ -0,0 +1,133 @@
+/* SearcherTest.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "test/Test.hpp"
+#include "search/Searcher.hpp"
+#include "core/move/MoveGenerator.hpp"
+#include "core/position/Position.hpp"
+#include "core/util/PositionUtil.hpp"
+#include <memory>
+#include <vector>
+
+using namespace sunfish;
+
+TEST(SearcherTest, testSearchRootMoves) {
+  auto eval = std::make_shared<Evaluator>(Evaluator::InitType::Zero);
+
+  {
+    Position pos(Position::Handicap::Even);
+    Moves moves;
+    MoveGenerator::generateCaptures(pos, moves);
+    MoveGenerator::generateQuiets(pos, moves);
+
+    Searcher searcher(eval);
+    std::vector<RootMoveResult> results;
+    searcher.searchRootMoves(pos,
+                             Searcher::Depth1Ply,
+                             -Score::infinity(),
+                             Score::infinity(),
+                             moves,
+                             results);
+
+    ASSERT_EQ(30, (int)results.size());
+    for (Moves::size_type i = 0; i < moves.size(); i++) {
+      ASSERT_EQ(moves[i], results[i].move);
+    }
+  }
+
+  {
+    Position pos = PositionUtil::createPositionFromCsaString(
+      "P1 *  *  *  * -OU *  *  *  * \n"
+      "P2 *  *  *  *  *  *  *  *  * \n"
+      "P3 *  *  *  * +FU *  *  *  * \n"
+      "P4 *  *  *  *  *  *  *  *  * \n"
+      "P5 *  *  *  *  *  *  *  *  * \n"
+      "P6 *  *  *  *  *  *  *  *  * \n"
+      "P7 *  *  *  *  *  *  *  *  * \n"
+      "P8 *  *  *  *  *  *  *  *  * \n"
+      "P9 *  *  *  * +OU *  *  *  * \n"
+      "P+00KI\n"
+      "P-\n"
+      "+\n");
+    Moves moves;
+    moves.add(Move(PieceType::gold(), Square::s52()));
+    moves.add(Move(PieceType::gold(), Square::s42()));
+
+    Searcher searcher(eval);
+    std::vector<RootMoveResult> results;
+    searcher.searchRootMoves(pos,
+                             Searcher::Depth1Ply,
+                             -Score::infinity(),
+                             Score::infinity(),
+                             moves,
+                             results);
+
+    ASSERT_EQ(2, (int)results.size());
+    ASSERT_EQ(Move(PieceType::gold(), Square::s52()), results[0].move);
+    ASSERT_TRUE(results[0].score >= Score::mate());
+    ASSERT_TRUE(results[1].score < Score::mate());
+  }
+}
+
+#if SUNFISH_TABLE_STATS
+namespace {
+
+class NullSearchHandler : public SearchHandler {
+public:
+  void onStart(const Searcher&) override {}
+  void onUpdatePV(const Searcher&, const PV&, float, int, Score) override {}
+  void onFailLow(const Searcher&, const PV&, float, int, Score) override {}
+  void onFailHigh(const Searcher&, const PV&, float, int, Score) override {}
+  void onIterateEnd(const Searcher&, float, int) override {}
+};
+
+} // namespace
+
+TEST(SearcherTest, testTableStatistics) {
+  auto eval = std::make_shared<Evaluator>(Evaluator::InitType::Zero);
+  Position pos(Position::Handicap::Even);
+
+  NullSearchHandler handler;
+  Searcher searcher(eval);
+  searcher.setHandler(&handler);
+  auto config = searcher.getConfig();
+  config.maximumTimeMs = SearchConfig::InfinityTime;
+  config.optimumTimeMs = SearchConfig::InfinityTime;
+  searcher.setConfig(config);
+
+  searcher.idsearch(pos, 4 * Searcher::Depth1Ply);
+  SearchInfo info1 = searcher.getInfo();
+
+  ASSERT_TRUE(info1.ttProbe != 0);
+  ASSERT_TRUE(info1.ttHit != 0);
+  ASSERT_TRUE(info1.ttHit + info1.ttMismatch <= info1.ttProbe);
+  ASSERT_TRUE(info1.evalCacheProbe != 0);
+  ASSERT_TRUE(info1.evalCacheHit <= info1.evalCacheProbe);
+  ASSERT_TRUE(info1.shekProbe != 0);
+  ASSERT_TRUE(info1.shekHit <= info1.shekProbe);
+
+  uint64_t stored = 0;
+  for (int i = 0; i < SearchInfo::TTDepthSize; i++) {
+    stored += info1.ttDepth[i];
+  }
+  ASSERT_EQ(info1.ttUpdate + info1.ttReplace, stored);
+
+  // the same counts are given by the same search on a single thread.
+  searcher.clean();
+  searcher.idsearch(pos, 4 * Searcher::Depth1Ply);
+  SearchInfo info2 = searcher.getInfo();
+
+  ASSERT_EQ(info1.ttProbe, info2.ttProbe);
+  ASSERT_EQ(info1.ttHit, info2.ttHit);
+  ASSERT_EQ(info1.ttMismatch, info2.ttMismatch);
+  ASSERT_EQ(info1.shekProbe, info2.shekProbe);
+
+  // TT retains the entries of the previous search without clean().
+  searcher.idsearch(pos, 4 * Searcher::Depth1Ply);
+  SearchInfo info3 = searcher.getInfo();
+
+  ASSERT_TRUE(info3.ttHit * info1.ttProbe > info1.ttHit * info3.ttProbe);
+}
+#endif
@@ -7,6 +7,7 @@
 #include "search/tt/TT.hpp"
 #include "core/position/Position.hpp"
 #include "core/util/PositionUtil.hpp"
+#include <cstdio>
 
 namespace {
 
@@ -263,3 +264,66 @@ TEST(TTTest, testUpdate) {
                  /* mate  */ false);
   ASSERT_TRUE(TTStatus::Update == tts);
 }
+
+TEST(TTTest, testSnapshot) {
+  const char* path = "tt_snapshot_test.bin";
+  TTElement tte;
+
+  Position pos1 = PositionUtil::createPositionFromCsaString(posStr1);
+  Position pos2 = PositionUtil::createPositionFromCsaString(posStr2);
+
+  {
+    TT tt;
+    tt.resize(12);
+    tt.store(/* hash  */ pos1.getHash(),
+             /* alpha */ Score(-123),
+             /* beta  */ Score(456),
+             /* score */ Score(77),
+             /* depth */ 5,
+             /* ply   */ 3,
+             /* move  */ Move(Square::s77(), Square::s76(), false),
+             /* mate  */ false);
+    ASSERT_TRUE(tt.save(path));
+  }
+
+  {
+    TT tt;
+    ASSERT_TRUE(tt.load(path));
+    ASSERT_EQ(12u, tt.getWidth());
+
+    bool success = tt.get(pos1.getHash(), tte);
+    ASSERT_EQ(true, success);
+    ASSERT_EQ(Score(77), tte.score(8));
+    ASSERT_EQ(5, tte.depth());
+    ASSERT_EQ(Move(Square::s77(), Square::s76(), false), tte.move());
+    ASSERT_EQ(false, tt.get(pos2.getHash(), tte));
+
+    // the entries stored after loading are not written back to the file.
+    tt.store(/* hash  */ pos2.getHash(),
+             /* alpha */ Score(-123),
+             /* beta  */ Score(456),
+             /* score */ Score(517),
+             /* depth */ 5,
+             /* ply   */ 3,
+             /* move  */ Move(Square::s33(), Square::s34(), false),
+             /* mate  */ false);
+    ASSERT_EQ(true, tt.get(pos2.getHash(), tte));
+  }
+
+  {
+    TT tt;
+    ASSERT_TRUE(tt.load(path));
+    ASSERT_EQ(true, tt.get(pos1.getHash(), tte));
+    ASSERT_EQ(false, tt.get(pos2.getHash(), tte));
+
+    // the mapping is released with the size kept.
+    tt.clear();
+    ASSERT_EQ(12u, tt.getWidth());
+    ASSERT_EQ(false, tt.get(pos1.getHash(), tte));
+
+    ASSERT_TRUE(tt.load(path));
+    ASSERT_EQ(true, tt.get(pos1.getHash(), tte));
+  }
+
+  remove(path);
+}
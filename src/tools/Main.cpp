@@ -7,9 +7,14 @@
 #include "common/program_options/ProgramOptions.hpp"
 #include "core/util/CoreUtil.hpp"
 #include "book/Book.hpp"
+#include "book/BinaryBook.hpp"
+#include "book/BinaryBookGenerator.hpp"
+#include "common/string/StringUtil.hpp"
 #include "book/BookGenerator.hpp"
 #include "logger/Logger.hpp"
 #include "tools/sfen2csa/Sfen2Csa.hpp"
+#include "tools/csa2db/Csa2Db.hpp"
+#include "tools/trace/TraceSummary.hpp"
 
 using namespace sunfish;
 
@@ -20,7 +25,16 @@ int main(int argc, char** argv, char**) {
   // program options
   ProgramOptions po;
   po.addOption("sfen2csa", "SFEN-CSA converter");
+  po.addOption("csa2db", "convert CSA files into a record database", true);
+  po.addOption("output", "o", "output file of --csa2db (default: kifu.db)", true);
   po.addOption("gen-book", "generate opening book", true);
+  po.addOption("convert-book", "convert opening book into binary format");
+  po.addOption("gen-binary-book", "generate binary opening book", true);
+  po.addOption("threads", "t", "the number of threads (--gen-binary-book)", true);
+  po.addOption("threshold", "the minimum count of book moves (--gen-binary-book)", true);
+  po.addOption("limit", "the maximum number of plies of book moves (--gen-binary-book)", true);
+  po.addOption("trace-summary", "summarize a search trace written by sunfish_expt --trace", true);
+  po.addOption("root-moves", "the number of root moves shown for each search (--trace-summary)", true);
   po.addOption("help", "h", "show this help");
   po.parse(argc, argv);
 
@@ -54,6 +68,24 @@ int main(int argc, char** argv, char**) {
     return ok ? 0 : 1;
   }
 
+  // csa2db
+  if (po.has("csa2db")) {
+    Csa2Db c2d;
+    bool ok = c2d.run(po.getValue("csa2db"),
+                      po.has("output") ? po.getValue("output") : "kifu.db");
+    return ok ? 0 : 1;
+  }
+
+  // trace-summary
+  if (po.has("trace-summary")) {
+    TraceSummary ts;
+    if (po.has("root-moves")) {
+      ts.setNumberOfRootMoves(StringUtil::toInt(po.getValue("root-moves"), TraceSummary::DefaultRootMoves));
+    }
+    bool ok = ts.run(po.getValue("trace-summary"));
+    return ok ? 0 : 1;
+  }
+
   // gen-book
   if (po.has("gen-book")) {
     auto path = po.getValue("gen-book");
@@ -66,6 +98,41 @@ int main(int argc, char** argv, char**) {
     return 0;
   }
 
+  // gen-binary-book
+  if (po.has("gen-binary-book")) {
+    auto path = po.getValue("gen-binary-book");
+    BinaryBookGenerator bg(path);
+    bg.setLimit(BinaryBookGenerator::DefaultLimit);
+    if (po.has("limit")) {
+      bg.setLimit(StringUtil::toInt(po.getValue("limit"), BinaryBookGenerator::DefaultLimit));
+    }
+    if (po.has("threads")) {
+      bg.setNumberOfThreads(StringUtil::toInt(po.getValue("threads"), 1));
+    }
+    if (po.has("threshold")) {
+      bg.setThreshold(StringUtil::toInt(po.getValue("threshold"), 1));
+    }
+    return bg.generate() ? 0 : 1;
+  }
+
+  // convert-book
+  if (po.has("convert-book")) {
+    Book book;
+    if (!book.load()) {
+      return 1;
+    }
+    if (!BinaryBook::write(book)) {
+      return 1;
+    }
+    BinaryBook binaryBook;
+    if (!binaryBook.open()) {
+      return 1;
+    }
+    MSG(info) << "positions: " << binaryBook.getNumberOfEntries();
+    MSG(info) << "moves    : " << binaryBook.getNumberOfMoves();
+    return 0;
+  }
+
   MSG(error) << "No action is specified.";
   std::cout << po.help();
 
@@ -0,0 +1,51 @@
+/* Csa2Db.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "tools/csa2db/Csa2Db.hpp"
+#include "core/record/RecordLoader.hpp"
+#include "core/record/RecordDatabase.hpp"
+#include "common/time/Timer.hpp"
+#include "logger/Logger.hpp"
+
+namespace sunfish {
+
+bool Csa2Db::run(const std::string& inputPath, const std::string& outputPath) {
+  Timer timer;
+  timer.start();
+
+  RecordDatabaseWriter writer;
+  if (!writer.open(outputPath)) {
+    return false;
+  }
+
+  // the records are written in the order that the loader finishes them.
+  RecordLoader loader;
+  if (!loader.start(inputPath)) {
+    writer.close();
+    return false;
+  }
+
+  Record record;
+  while (loader.next(record)) {
+    if (!writer.write(record)) {
+      LOG(error) << "could not write the record";
+      loader.stop();
+      writer.close();
+      return false;
+    }
+  }
+
+  if (!writer.close()) {
+    return false;
+  }
+
+  MSG(info) << "files  : " << loader.getNumberOfFiles();
+  MSG(info) << "records: " << writer.getNumberOfRecords();
+  MSG(info) << "elapsed: " << timer.elapsed();
+
+  return true;
+}
+
+} // namespace sunfish
@@ -0,0 +1,24 @@
+/* Csa2Db.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_TOOLS_CSA2DB_CSA2DB_HPP__
+#define SUNFISH_TOOLS_CSA2DB_CSA2DB_HPP__
+
+#include <string>
+
+namespace sunfish {
+
+class Csa2Db {
+public:
+
+  bool run(const std::string& inputPath, const std::string& outputPath);
+
+private:
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_TOOLS_CSA2DB_CSA2DB_HPP__
@@ -0,0 +1,205 @@
+/* TraceSummary.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "tools/trace/TraceSummary.hpp"
+#include "search/trace/SearchTrace.hpp"
+#include "core/move/Move.hpp"
+#include "common/string/TablePrinter.hpp"
+#include "logger/Logger.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+using namespace sunfish;
+
+CONSTEXPR_CONST int MaxPly = 256;
+
+/**
+ * The number of the events of each ply.
+ * The events are multiplied by the sample rate of the chunk.
+ */
+struct PlyStat {
+  uint64_t nodes;
+  uint64_t cuts;
+  uint64_t events[SearchTrace::NumberOfEventTypes];
+};
+
+struct RootMoveStat {
+  uint16_t move;
+  uint64_t nodes;
+};
+
+std::string formatRatio(double value) {
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(2) << value;
+  return oss.str();
+}
+
+std::string formatRatio(uint64_t n, uint64_t d) {
+  return d != 0 ? formatRatio(static_cast<double>(n) / d) : "-";
+}
+
+} // namespace
+
+namespace sunfish {
+
+bool TraceSummary::run(const std::string& path) {
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  if (!file) {
+    LOG(error) << "could not open a file: " << path;
+    return false;
+  }
+
+  SearchTrace::Header header;
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (file.fail() || header.magic != SearchTrace::Magic) {
+    LOG(error) << "invalid search trace: " << path;
+    return false;
+  }
+
+  if (header.version != SearchTrace::Version) {
+    LOG(error) << "unsupported version of search trace: " << header.version;
+    return false;
+  }
+
+  std::vector<PlyStat> plies(MaxPly);
+  memset(plies.data(), 0, sizeof(PlyStat) * plies.size());
+  std::map<uint16_t, uint64_t> iterations;
+  std::map<uint32_t, std::map<uint16_t, uint64_t>> rootMoves;
+  uint64_t numberOfChunks = 0;
+  uint64_t numberOfEvents = 0;
+  uint64_t dropped = 0;
+
+  std::vector<SearchTrace::Event> events;
+  for (;;) {
+    SearchTrace::ChunkHeader chunk;
+    file.read(reinterpret_cast<char*>(&chunk), sizeof(chunk));
+    if (file.gcount() == 0) {
+      break;
+    }
+
+    events.resize(chunk.numberOfEvents);
+    file.read(reinterpret_cast<char*>(events.data()),
+              sizeof(SearchTrace::Event) * events.size());
+    if (file.fail()) {
+      LOG(error) << "the search trace is broken: " << path;
+      return false;
+    }
+
+    numberOfChunks++;
+    numberOfEvents += events.size();
+    dropped += chunk.dropped;
+
+    uint64_t weight = std::max<uint16_t>(chunk.sampleRate, 1);
+    auto& rootMovesOfSearch = rootMoves[chunk.search];
+
+    for (const auto& event : events) {
+      if (event.type >= SearchTrace::NumberOfEventTypes) {
+        LOG(error) << "the search trace is broken: " << path;
+        return false;
+      }
+
+      auto& ply = plies[event.ply];
+      ply.events[event.type] += weight;
+
+      if (event.type == SearchTrace::Enter) {
+        ply.nodes += weight;
+        iterations[event.iteration] += weight;
+        rootMovesOfSearch[event.rootMove] += weight;
+      } else if (event.type == SearchTrace::Exit &&
+                 event.score >= event.beta) {
+        ply.cuts += weight;
+      }
+    }
+  }
+
+  MSG(info) << "searches : " << rootMoves.size();
+  MSG(info) << "chunks   : " << numberOfChunks;
+  MSG(info) << "events   : " << numberOfEvents;
+  MSG(info) << "dropped  : " << dropped;
+  if (dropped != 0) {
+    MSG(info) << "the buffers were full. the deeper iterations are underestimated.";
+  }
+  MSG(info) << "";
+
+  // the effective branching factor of each ply
+  {
+    TablePrinter tp;
+    tp.row() << "ply" << "nodes" << "EBF" << "cut%"
+             << "tt-hit" << "hash-cut" << "null" << "futility"
+             << "razoring" << "probcut";
+    for (int i = 1; i < MaxPly; i++) {
+      const auto& ply = plies[i];
+      if (ply.nodes == 0) {
+        continue;
+      }
+
+      uint64_t nextNodes = i + 1 < MaxPly ? plies[i+1].nodes : 0;
+      tp.row() << i
+               << ply.nodes
+               << formatRatio(nextNodes, ply.nodes)
+               << (ply.cuts * 100 / ply.nodes)
+               << ply.events[SearchTrace::TTHit]
+               << ply.events[SearchTrace::HashCut]
+               << ply.events[SearchTrace::NullMovePruning]
+               << ply.events[SearchTrace::FutilityPruning]
+               << ply.events[SearchTrace::Razoring]
+               << ply.events[SearchTrace::ProbCut];
+    }
+    MSG(info) << "plies:";
+    MSG(info) << tp.stringify();
+  }
+
+  // the growth of the tree by the iterative deepening
+  {
+    TablePrinter tp;
+    tp.row() << "iteration" << "nodes" << "ratio";
+    uint64_t prevNodes = 0;
+    for (const auto& iteration : iterations) {
+      tp.row() << iteration.first
+               << iteration.second
+               << formatRatio(iteration.second, prevNodes);
+      prevNodes = iteration.second;
+    }
+    MSG(info) << "iterations:";
+    MSG(info) << tp.stringify();
+  }
+
+  // the nodes of each root move
+  for (const auto& search : rootMoves) {
+    std::vector<RootMoveStat> stats;
+    uint64_t totalNodes = 0;
+    for (const auto& rootMove : search.second) {
+      stats.push_back({ rootMove.first, rootMove.second });
+      totalNodes += rootMove.second;
+    }
+
+    std::stable_sort(stats.begin(), stats.end(), [](const RootMoveStat& lhs, const RootMoveStat& rhs) {
+      return lhs.nodes > rhs.nodes;
+    });
+
+    TablePrinter tp;
+    tp.row() << "move" << "nodes" << "%";
+    for (size_t i = 0; i < stats.size() && i < numberOfRootMoves_; i++) {
+      tp.row() << Move::deserialize(stats[i].move).toString()
+               << stats[i].nodes
+               << (stats[i].nodes * 100 / totalNodes);
+    }
+    MSG(info) << "root moves of search " << search.first
+              << " (" << stats.size() << " moves):";
+    MSG(info) << tp.stringify();
+  }
+
+  return true;
+}
+
+} // namespace sunfish
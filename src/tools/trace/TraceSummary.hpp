@@ -0,0 +1,42 @@
+/* TraceSummary.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_TOOLS_TRACE_TRACESUMMARY_HPP__
+#define SUNFISH_TOOLS_TRACE_TRACESUMMARY_HPP__
+
+#include "common/Def.hpp"
+#include <string>
+
+namespace sunfish {
+
+/**
+ * Summarize a search trace written by SearchTraceWriter.
+ */
+class TraceSummary {
+public:
+
+  static CONSTEXPR_CONST unsigned DefaultRootMoves = 10;
+
+  TraceSummary() : numberOfRootMoves_(DefaultRootMoves) {
+  }
+
+  /**
+   * Set the number of the root moves shown for each search.
+   */
+  void setNumberOfRootMoves(unsigned numberOfRootMoves) {
+    numberOfRootMoves_ = numberOfRootMoves;
+  }
+
+  bool run(const std::string& path);
+
+private:
+
+  unsigned numberOfRootMoves_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_TOOLS_TRACE_TRACESUMMARY_HPP__
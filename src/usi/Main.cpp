@@ -39,10 +39,17 @@ int main(int, char**, char**) {
     Loggers::receive.addStream(fout, true, true);
   }
 
+  // the log is written on a background thread
+  // not to block the search threads.
+  AsyncLogger::start();
+
   // USI client
   UsiClient client;
 
   bool ok = client.start();
 
+  // the log file is closed at the end of this function.
+  AsyncLogger::stop();
+
   return ok ? 0 : 1;
 }
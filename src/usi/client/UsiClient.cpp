@@ -11,6 +11,7 @@
 #include "core/record/SfenParser.hpp"
 #include "search/eval/Material.hpp"
 #include "logger/Logger.hpp"
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 #include <utility>
@@ -36,7 +37,11 @@ const char* Author = "res/strings/usi_author";
 
 namespace sunfish {
 
-UsiClient::UsiClient() : breakReceiver_(false), isBookLoaded(false) {
+UsiClient::UsiClient() :
+    writer_(std::cout),
+    positionHasMoves_(false),
+    breakReceiver_(false),
+    isBookLoaded(false) {
   receiver_ = std::thread([this]() {
     receiver();
   });
@@ -47,7 +52,12 @@ UsiClient::UsiClient() : breakReceiver_(false), isBookLoaded(false) {
   options_.snappy = true;
   options_.marginMs = 500;
   options_.numberOfThreads = 1;
+  options_.numa = false;
+  options_.replicateEval = false;
   options_.maxDepth = Searcher::DepthInfinity;
+  options_.tableStatistics = false;
+  options_.ttLoad = false;
+  options_.ttSave = false;
 }
 
 bool UsiClient::start() {
@@ -94,7 +104,15 @@ bool UsiClient::acceptUsi() {
   send("option", "name", "Snappy", "type", "check", "default", "true");
   send("option", "name", "MarginMs", "type", "spin", "default", "500", "min", "0", "max", "2000");
   send("option", "name", "Threads", "type", "spin", "default", "1", "min", "1", "max", "32");
+  send("option", "name", "NUMA", "type", "check", "default", "false");
+  send("option", "name", "NUMAReplicateEval", "type", "check", "default", "false");
   send("option", "name", "MaxDepth", "type", "spin", "default", "64", "min", "1", "max", "64");
+#if SUNFISH_TABLE_STATS
+  send("option", "name", "TableStatistics", "type", "check", "default", "false");
+#endif
+  send("option", "name", "TTFile", "type", "string", "default", "<empty>");
+  send("option", "name", "TTLoad", "type", "check", "default", "false");
+  send("option", "name", "TTSave", "type", "check", "default", "false");
 
   send("usiok");
 
@@ -118,6 +136,9 @@ bool UsiClient::ready() {
         }
         searcher_.reset(new Searcher(Evaluator::sharedEvaluator()));
         searcher_->setHandler(this);
+      } else if (options_.ttLoad && !options_.ttFile.empty()) {
+        // TT is replaced by the snapshot below.
+        searcher_->cleanGame();
       } else {
         searcher_->clean();
       }
@@ -126,8 +147,20 @@ bool UsiClient::ready() {
         searcher_->ttResizeMB(options_.hash);
       }
 
+      // the snapshot is loaded on every game
+      // to discard the entries of the previous game.
+      if (options_.ttLoad && !options_.ttFile.empty()) {
+        if (searcher_->ttLoad(options_.ttFile)) {
+          MSG(info) << "TT is loaded: " << options_.ttFile;
+        }
+      }
+
       if (!isBookLoaded) {
-        book_.load();
+        if (BinaryBook::exists()) {
+          binaryBook_.open();
+        } else {
+          book_.load();
+        }
         isBookLoaded = true;
       }
 
@@ -165,8 +198,20 @@ void UsiClient::setOption(const CommandArguments& args) {
     options_.marginMs = StringUtil::toInt(value, options_.marginMs);
   } else if (name == "Threads") {
     options_.numberOfThreads = StringUtil::toInt(value, options_.numberOfThreads);
+  } else if (name == "NUMA") {
+    options_.numa = value == "true";
+  } else if (name == "NUMAReplicateEval") {
+    options_.replicateEval = value == "true";
   } else if (name == "MaxDepth") {
     options_.maxDepth = StringUtil::toInt(value, options_.maxDepth);
+  } else if (name == "TableStatistics") {
+    options_.tableStatistics = value == "true";
+  } else if (name == "TTFile") {
+    options_.ttFile = value == "<empty>" ? "" : value;
+  } else if (name == "TTLoad") {
+    options_.ttLoad = value == "true";
+  } else if (name == "TTSave") {
+    options_.ttSave = value == "true";
   } else {
     LOG(warning) << "unknown option: " << name;
   }
@@ -200,14 +245,9 @@ bool UsiClient::game() {
     // >position
     // >go
     if (args[0] == "position") {
-      if (!SfenParser::parseUsiCommand(args.begin(),
-                                       args.end(),
-                                       record_)) {
-        LOG(error) << "an error is occured in SfenParser";
+      if (!updatePosition(command.value, args)) {
         return false;
       }
-      lastPositionCommand_ = command.value;
-
 
       if (!receiveGo()) {
         return false;
@@ -218,6 +258,11 @@ bool UsiClient::game() {
 
     // >gameover
     if (args[0] == "gameover") {
+      if (options_.ttSave && !options_.ttFile.empty()) {
+        if (searcher_->ttSave(options_.ttFile)) {
+          MSG(info) << "TT is saved: " << options_.ttFile;
+        }
+      }
       return true;
     }
 
@@ -226,6 +271,70 @@ bool UsiClient::game() {
   }
 }
 
+bool UsiClient::updatePosition(const std::string& command,
+                               const CommandArguments& args) {
+  // GUIs send the whole game on every move,
+  // so only the moves following the previous command are applied.
+  if (appendMoves(command)) {
+    lastPositionCommand_ = command;
+    return true;
+  }
+
+  if (!SfenParser::parseUsiCommand(args.begin(),
+                                   args.end(),
+                                   record_)) {
+    LOG(error) << "an error is occured in SfenParser";
+    lastPositionCommand_.clear();
+    return false;
+  }
+
+  position_ = generatePosition(record_, -1);
+  positionHasMoves_ = std::find(args.begin(), args.end(), "moves") != args.end();
+  lastPositionCommand_ = command;
+
+  return true;
+}
+
+bool UsiClient::appendMoves(const std::string& command) {
+  const auto& last = lastPositionCommand_;
+  if (last.empty() ||
+      command.size() < last.size() ||
+      command.compare(0, last.size(), last) != 0 ||
+      (command.size() != last.size() && !isspace(command[last.size()]))) {
+    return false;
+  }
+
+  auto args = StringUtil::split(command.c_str() + last.size(), [](char c) {
+    return isspace(c);
+  });
+
+  auto ite = args.begin();
+  if (!positionHasMoves_ && ite != args.end()) {
+    if (*ite != "moves") {
+      return false;
+    }
+    ite++;
+  }
+
+  Record::MoveListType moves;
+  Position position = position_;
+  for (; ite != args.end(); ite++) {
+    Move move;
+    Piece captured;
+    if (!SfenParser::parseMove(*ite, move) ||
+        !position.doMove(move, captured)) {
+      return false;
+    }
+    moves.push_back(move);
+  }
+
+  record_.moveList.insert(record_.moveList.end(), moves.begin(), moves.end());
+  position_ = position;
+  positionHasMoves_ = positionHasMoves_ || !args.empty();
+
+  return true;
+}
+
 bool UsiClient::receiveGo() {
   auto command = receive();
   if (command.state != CommandState::Ok) {
@@ -295,8 +404,9 @@ bool UsiClient::runSearch(const CommandArguments& args) {
 
   // check opening book
   if (options_.useBook) {
-    auto pos = generatePosition(record_, -1);
-    Move bookMove = BookUtil::select(book_, pos, random_);
+    Move bookMove = binaryBook_.isOpen()
+        ? BookUtil::select(binaryBook_, position_, random_)
+        : BookUtil::select(book_, position_, random_);
     if (!bookMove.isNone()) {
       MSG(info) << "opening book hit";
       send("bestmove", bookMove.toStringSFEN());
@@ -342,7 +452,7 @@ bool UsiClient::runSearch(const CommandArguments& args) {
 void UsiClient::search() {
   MSG(info) << "search thread is started. tid=" << std::this_thread::get_id();
 
-  auto pos = generatePosition(record_, -1);
+  const auto& pos = position_;
   auto config = searcher_->getConfig();
 
   if (isInfinite_) {
@@ -368,6 +478,8 @@ void UsiClient::search() {
   }
 
   config.numberOfThreads = options_.numberOfThreads;
+  config.numa = options_.numa;
+  config.replicateEval = options_.replicateEval;
 
   searcher_->setConfig(config);
 
@@ -382,6 +494,10 @@ void UsiClient::search() {
   bool canPonder = !result.move.isNone() &&
                    result.pv.size() >= 2;
 
+  if (options_.tableStatistics) {
+    sendTableStatistics(info);
+  }
+
   // send the result of search
   if (canPonder) {
     send("bestmove", result.move.toStringSFEN(),
@@ -445,17 +561,21 @@ bool UsiClient::runPonder(const CommandArguments&) {
 void UsiClient::ponder() {
   MSG(info) << "ponder thread is started. tid=" << std::this_thread::get_id();
 
-  record_.moveList.pop_back();
-  auto pos = generatePosition(record_, -1);
+  // record_ is kept as it is to apply the next position command.
+  Record record = record_;
+  record.moveList.pop_back();
+  auto pos = generatePosition(record, -1);
   auto config = searcher_->getConfig();
 
   config.maximumTimeMs = SearchConfig::InfinityTime;
   config.optimumTimeMs = SearchConfig::InfinityTime;
   config.numberOfThreads = options_.numberOfThreads;
+  config.numa = options_.numa;
+  config.replicateEval = options_.replicateEval;
 
   searcher_->setConfig(config);
 
-  searcher_->idsearch(pos, options_.maxDepth * Searcher::Depth1Ply, &record_);
+  searcher_->idsearch(pos, options_.maxDepth * Searcher::Depth1Ply, &record);
 
   MSG(info) << "ponder thread is stopped. tid=" << std::this_thread::get_id();
 }
@@ -513,8 +633,7 @@ void UsiClient::onUpdatePV(const Searcher& searcher, const PV& pv, float elapsed
             << score;
 
   if (!inPonder_) {
-    send("info",
-         "time", timeMs,
+    sendInfo("time", timeMs,
          "depth", realDepth,
          "nodes", totalNodes,
          "nps", nps,
@@ -610,17 +729,40 @@ void UsiClient::receiver() {
   }
 }
 
+void UsiClient::sendTableStatistics(const SearchInfo& info) {
+  // the info strings are not thinned out unlike the other info commands.
+  send("info", "string", "tt",
+       "probe", info.ttProbe,
+       "hit", info.ttHit,
+       "mismatch", info.ttMismatch,
+       "update", info.ttUpdate,
+       "replace", info.ttReplace,
+       "reject", info.ttReject);
+
+  std::ostringstream oss;
+  printTTDepth(oss, info);
+  send("info", "string", "tt", "depth", oss.str());
+
+  send("info", "string", "evalcache",
+       "probe", info.evalCacheProbe,
+       "hit", info.evalCacheHit,
+       "replace", info.evalCacheReplace);
+
+  send("info", "string", "shek",
+       "probe", info.shekProbe,
+       "hit", info.shekHit,
+       "reject", info.shekReject);
+}
+
 void UsiClient::breakReceive() {
   breakReceiver_ = true;
 }
 
 template <class T>
 void UsiClient::send(T&& command) {
-  std::lock_guard<std::mutex> lock(sendMutex_);
-
-  std::cout << command << std::endl;
-  std::cout.flush();
-  MSG(send) << command;
+  std::ostringstream oss;
+  oss << command;
+  writer_.write(oss.str());
 }
 
 template <class T, class... Args>
@@ -631,6 +773,14 @@ void UsiClient::send(T&& command, Args&&... options) {
   send(oss.str());
 }
 
+template <class... Args>
+void UsiClient::sendInfo(Args&&... options) {
+  std::ostringstream oss;
+  oss << "info";
+  joinOptions(oss, std::forward<Args>(options)...);
+  writer_.writeInfo(oss.str());
+}
+
 template <class T>
 void UsiClient::joinOptions(std::ostream& os, T&& arg) {
   os << ' ' << arg;
@@ -10,7 +10,9 @@
 #include "core/position/Position.hpp"
 #include "core/record/Record.hpp"
 #include "book/Book.hpp"
+#include "book/BinaryBook.hpp"
 #include "search/Searcher.hpp"
+#include "usi/client/UsiWriter.hpp"
 #include <iostream>
 #include <string>
 #include <vector>
@@ -36,7 +38,13 @@ private:
     bool snappy;
     int marginMs;
     int numberOfThreads;
+    bool numa;
+    bool replicateEval;
     int maxDepth;
+    bool tableStatistics;
+    std::string ttFile;
+    bool ttLoad;
+    bool ttSave;
   };
 
   enum class CommandState : uint8_t {
@@ -68,6 +76,11 @@ private:
 
   bool game();
 
+  bool updatePosition(const std::string& command,
+                      const CommandArguments& args);
+
+  bool appendMoves(const std::string& command);
+
   bool receiveGo();
 
   bool runSearch(const CommandArguments& args);
@@ -92,6 +105,8 @@ private:
 
   void onIterateEnd(const Searcher&, float, int) override {}
 
+  void sendTableStatistics(const SearchInfo& info);
+
   Command receive();
 
   Command receiveWithBreak();
@@ -106,6 +121,9 @@ private:
   template <class T, class... Args>
   void send(T&& command, Args&&... options);
 
+  template <class... Args>
+  void sendInfo(Args&&... options);
+
   template <class T>
   void joinOptions(std::ostream& os, T&& arg);
 
@@ -114,6 +132,8 @@ private:
 
   Options options_;
 
+  UsiWriter writer_;
+
   std::queue<std::string> deferredCommands_;
   std::queue<Command> commandQueue_;
 
@@ -121,6 +141,8 @@ private:
   std::string lastGoCommand_;
 
   Record record_;
+  Position position_;
+  bool positionHasMoves_;
 
   TimeType blackTimeMs_;
   TimeType whiteTimeMs_;
@@ -136,11 +158,11 @@ private:
   std::atomic<bool> breakReceiver_;
 
   Book book_;
+  BinaryBook binaryBook_;
   bool isBookLoaded;
 
   Random random_;
 
-  std::mutex sendMutex_;
   std::mutex receiveMutex_;
   std::thread receiver_;
 
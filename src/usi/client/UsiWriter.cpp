@@ -0,0 +1,99 @@
+/* UsiWriter.cpp
+ *
+ * Kubo Ryosuke
+ */
+
+#include "usi/client/UsiWriter.hpp"
+#include "logger/Logger.hpp"
+
+namespace sunfish {
+
+UsiWriter::UsiWriter(std::ostream& os) :
+    os_(os),
+    infoInterval_(DefaultInfoIntervalMs),
+    infoPosition_(0),
+    hasInfo_(false),
+    stop_(false) {
+  thread_ = std::thread([this]() {
+    run();
+  });
+}
+
+UsiWriter::~UsiWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+
+  thread_.join();
+}
+
+void UsiWriter::write(std::string&& line) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lines_.push_back(std::move(line));
+  }
+  cv_.notify_one();
+}
+
+void UsiWriter::writeInfo(std::string&& line) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    info_ = std::move(line);
+    infoPosition_ = lines_.size();
+    hasInfo_ = true;
+  }
+  cv_.notify_one();
+}
+
+void UsiWriter::run() {
+  std::vector<std::string> lines;
+  auto lastInfoTime = Clock::now() - infoInterval_;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  for (;;) {
+    bool writeInfo = hasInfo_ &&
+                     (!lines_.empty() || stop_ ||
+                      Clock::now() >= lastInfoTime + infoInterval_);
+
+    if (lines_.empty() && !writeInfo) {
+      if (stop_) {
+        break;
+      }
+
+      if (hasInfo_) {
+        cv_.wait_until(lock, lastInfoTime + infoInterval_);
+      } else {
+        cv_.wait(lock);
+      }
+      continue;
+    }
+
+    // the info line keeps its order to the other commands.
+    lines.swap(lines_);
+    if (writeInfo) {
+      lines.insert(lines.begin() + infoPosition_, std::move(info_));
+      lastInfoTime = Clock::now();
+      hasInfo_ = false;
+    }
+    infoPosition_ = 0;
+
+    lock.unlock();
+
+    for (const auto& line : lines) {
+      os_ << line << '\n';
+    }
+    os_.flush();
+
+    for (const auto& line : lines) {
+      MSG(send) << line;
+    }
+    lines.clear();
+
+    lock.lock();
+  }
+}
+
+} // namespace sunfish
@@ -0,0 +1,74 @@
+/* UsiWriter.hpp
+ *
+ * Kubo Ryosuke
+ */
+
+#ifndef SUNFISH_USI_CLIENT_USIWRITER_HPP__
+#define SUNFISH_USI_CLIENT_USIWRITER_HPP__
+
+#include "common/Def.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <iostream>
+
+namespace sunfish {
+
+/**
+ * Write the USI commands on a dedicated thread,
+ * so that a slow GUI does not stall the search threads.
+ * The info lines of PV are coalesced and written at most once
+ * in each interval, and the other commands are written immediately.
+ */
+class UsiWriter {
+public:
+
+  static CONSTEXPR_CONST int DefaultInfoIntervalMs = 50;
+
+  explicit UsiWriter(std::ostream& os);
+  UsiWriter(const UsiWriter&) = delete;
+  UsiWriter(UsiWriter&&) = delete;
+
+  ~UsiWriter();
+
+  void setInfoIntervalMs(int infoIntervalMs) {
+    infoInterval_ = std::chrono::milliseconds(infoIntervalMs);
+  }
+
+  /**
+   * Write a command.
+   * The pending info line is written before it.
+   */
+  void write(std::string&& line);
+
+  /**
+   * Write an info line.
+   * This replaces the pending info line which is not written yet.
+   */
+  void writeInfo(std::string&& line);
+
+private:
+
+  using Clock = std::chrono::steady_clock;
+
+  void run();
+
+  std::ostream& os_;
+  std::chrono::milliseconds infoInterval_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::string> lines_;
+  std::string info_;
+  size_t infoPosition_;
+  bool hasInfo_;
+  bool stop_;
+  std::thread thread_;
+
+};
+
+} // namespace sunfish
+
+#endif // SUNFISH_USI_CLIENT_USIWRITER_HPP__